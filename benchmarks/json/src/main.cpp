@@ -0,0 +1,130 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Message.h"
+#include "MessagePage.h"
+#include "UserSet.hpp"
+#include "util/Json.h"
+
+/*
+ * Measures how fast a page of messages is parsed with the JSON backend the
+ * library was built with, next to building a `nlohmann::json` for the page
+ * and calling `GroupMe::Message::createFromJson` for every message.
+ *
+ * Build once with `-DGROUPME_SIMDJSON=OFF` and once with `-DGROUPME_SIMDJSON=ON`,
+ * both in Release, to compare the two backends.
+ */
+
+namespace {
+    // A page that looks like what the messages endpoint sends back
+    std::string makePage(std::size_t count) {
+        nlohmann::json messages = nlohmann::json::array();
+
+        for (std::size_t i = 0; i < count; i++) {
+            nlohmann::json message;
+            message["attachments"] = nlohmann::json::array();
+            if (i % 4 == 0) {
+                message["attachments"].push_back({{"type", "image"}, {"url", "https://i.groupme.com/1024x768.jpeg." + std::to_string(i)}});
+            }
+            message["avatar_url"] = "https://i.groupme.com/avatar." + std::to_string(i % 20);
+            message["created_at"] = 1700000000 + i;
+            message["favorited_by"] = nlohmann::json::array({std::to_string(i % 20), std::to_string((i + 7) % 20)});
+            message["group_id"] = "12345678";
+            message["id"] = std::to_string(170000000000000000 + i);
+            message["name"] = "User " + std::to_string(i % 20);
+            message["sender_id"] = std::to_string(i % 20);
+            message["sender_type"] = "user";
+            message["source_guid"] = "a1b2c3d4e5f6" + std::to_string(i);
+            message["system"] = false;
+            message["text"] = "This is message number " + std::to_string(i) + " with a bit of text so it looks real \\u2764";
+            message["user_id"] = std::to_string(i % 20);
+            messages.push_back(std::move(message));
+        }
+
+        nlohmann::json page;
+        page["response"]["count"] = count;
+        page["response"]["messages"] = std::move(messages);
+        page["meta"]["code"] = 200;
+
+        return page.dump();
+    }
+
+    void run(const char* name, const std::string& page, const std::function<std::size_t()>& parse) {
+        using Clock = std::chrono::steady_clock;
+
+        // Warm up
+        std::size_t parsed = parse();
+
+        std::size_t iterations = 0;
+        Clock::time_point start = Clock::now();
+        Clock::duration elapsed;
+
+        do {
+            parsed += parse();
+            iterations++;
+            elapsed = Clock::now() - start;
+        } while (elapsed < std::chrono::seconds(2));
+
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        double gigabytes = static_cast<double>(page.size()) * static_cast<double>(iterations) / 1e9;
+
+        std::printf("%-32s %8.3f GB/s %10.0f pages/s (%zu messages)\n", name, gigabytes / seconds, static_cast<double>(iterations) / seconds, parsed);
+    }
+}
+
+int main() {
+    GroupMe::UserSet users;
+    for (int i = 0; i < 20; i += 2) {
+        users.insert(std::make_shared<GroupMe::User>(std::to_string(i), "User " + std::to_string(i), "", "", "", ""));
+    }
+
+    std::string page = makePage(100);
+
+    std::printf("Page size: %zu bytes\n", page.size());
+
+    std::string backend = std::string("createFromPage (") + GroupMe::Util::Json::backend() + ")";
+
+    run(backend.c_str(), page, [&page, &users]() {
+        return GroupMe::Message::createFromPage(page, users).size();
+    });
+
+    run("MessagePage::parse", page, [&page]() {
+        return GroupMe::MessagePage::parse(page).size();
+    });
+
+    run("nlohmann DOM + createFromJson", page, [&page, &users]() {
+        nlohmann::json json = nlohmann::json::parse(page);
+
+        std::vector<GroupMe::Message> messages;
+        for (const auto& message : json["response"]["messages"]) {
+            messages.push_back(GroupMe::Message::createFromJson(message, users));
+        }
+        return messages.size();
+    });
+
+    return EXIT_SUCCESS;
+}
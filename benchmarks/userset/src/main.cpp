@@ -0,0 +1,158 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "User.h"
+#include "UserSet.hpp"
+
+/*
+ * Compares `GroupMe::UserSet` to the `std::set` ordered by `GroupMe::UserCompare`
+ * that it replaced, on a group of 5,000 members. Lookups are done with IDs
+ * the way the message parser does them, in a random order. Syncing a
+ * member list is measured with a bulk build and a diff.
+ */
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    using OrderedSet = std::set<std::shared_ptr<GroupMe::User>, GroupMe::UserCompare>;
+
+    constexpr std::size_t s_members = 5000;
+
+    void run(const char* name, std::size_t operations, const std::function<std::size_t()>& work) {
+        // Warm up
+        std::size_t found = work();
+
+        std::size_t iterations = 0;
+        Clock::time_point start = Clock::now();
+        Clock::duration elapsed;
+
+        do {
+            found += work();
+            iterations++;
+            elapsed = Clock::now() - start;
+        } while (elapsed < std::chrono::seconds(2));
+
+        double nanoseconds = std::chrono::duration<double, std::nano>(elapsed).count();
+
+        std::printf("%-32s %10.1f ns/op (%zu found)\n", name, nanoseconds / static_cast<double>(iterations * operations), found);
+    }
+}
+
+int main() {
+    std::vector<std::shared_ptr<GroupMe::User>> members;
+    std::vector<std::string> ids;
+    for (std::size_t i = 0; i < s_members; i++) {
+        // Looks like the IDs the API hands out
+        std::string id = std::to_string(10000000 + i * 7919);
+        members.push_back(std::make_shared<GroupMe::User>(id, "User " + std::to_string(i), "", "", "", ""));
+        ids.push_back(id);
+    }
+
+    std::mt19937 random(42);
+    std::shuffle(ids.begin(), ids.end(), random);
+
+    // A quarter of the lookups are for users that aren't in the group
+    for (std::size_t i = 0; i < s_members / 4; i++) {
+        ids[i] = std::to_string(90000000 + i);
+    }
+
+    OrderedSet ordered(members.begin(), members.end());
+
+    GroupMe::UserSet hashed;
+    hashed.insert(members.begin(), members.end());
+
+    std::printf("Members: %zu\n", s_members);
+
+    run("std::set find", ids.size(), [&ordered, &ids]() {
+        std::size_t found = 0;
+        for (const auto& id : ids) {
+            found += ordered.find(id) != ordered.end();
+        }
+        return found;
+    });
+
+    run("UserSet find", ids.size(), [&hashed, &ids]() {
+        std::size_t found = 0;
+        for (const auto& id : ids) {
+            found += hashed.find(id) != hashed.end();
+        }
+        return found;
+    });
+
+    run("std::set build", members.size(), [&members]() {
+        OrderedSet set(members.begin(), members.end());
+        return set.size();
+    });
+
+    run("UserSet build", members.size(), [&members]() {
+        GroupMe::UserSet set;
+        set.insert(members.begin(), members.end());
+        return set.size();
+    });
+
+    run("UserSet bulk build", members.size(), [&members]() {
+        GroupMe::UserSet set(members);
+        return set.size();
+    });
+
+    // A sync where a tenth of the members changed their nickname
+    std::vector<std::shared_ptr<GroupMe::User>> synced;
+    for (std::size_t i = 0; i < members.size(); i++) {
+        if (i % 10 == 0) {
+            synced.push_back(std::make_shared<GroupMe::User>(*members[i]));
+            synced.back()->setNickname("Renamed " + std::to_string(i));
+        }
+        else {
+            synced.push_back(members[i]);
+        }
+    }
+    GroupMe::UserSet after(synced);
+
+    run("UserSet diff", members.size(), [&hashed, &after]() {
+        return GroupMe::UserSet::diff(hashed, after).changed.size();
+    });
+
+    run("std::set iterate", members.size(), [&ordered]() {
+        std::size_t count = 0;
+        for (const auto& user : ordered) {
+            count += user != nullptr;
+        }
+        return count;
+    });
+
+    run("UserSet iterate", members.size(), [&hashed]() {
+        std::size_t count = 0;
+        for (const auto& user : hashed) {
+            count += user != nullptr;
+        }
+        return count;
+    });
+
+    return EXIT_SUCCESS;
+}
@@ -23,6 +23,7 @@
 #include <string>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 
 #include <cpprest/http_client.h>
 #include <cpprest/uri.h>
@@ -136,16 +137,28 @@ namespace GroupMe {
              */
             Attachment(const std::string &content, const Attachment::Types &type);
 
+            Attachment(const Attachment& other) = default;
+
+            Attachment(Attachment&& other) = default;
+
+            virtual ~Attachment() = default;
+
+            Attachment& operator=(const Attachment& other) = default;
+
+            Attachment& operator=(Attachment&& other) = default;
+
             /**
              * The content URL will contain the endpoint of the uploaded attachment
-             * to send alongside a message.
+             * to send alongside a message. Every copy of an attachment sees the
+             * content once an upload finishes, even copies that were sliced down
+             * to a `GroupMe::Attachment` when they were attached to a message.
              *
              * @brief Gets the content URL.
              *
              * @return web::uri The URL of the content
              *
              */
-            web::uri getContentURL();
+            virtual web::uri getContentURL();
 
             /**
              * @brief Gets the type of attachment
@@ -153,9 +166,23 @@ namespace GroupMe {
              * @return Attachment::Types The type of the attachment
              *
              */
-            Attachment::Types getType();
+            Attachment::Types getType() const;
+
+            /**
+             * Once an attachment is uploaded this is the URL of a picture or
+             * video, or the ID of a file, which is what a message sends.
+             *
+             * @brief Gets the content as it's sent with a message
+             *
+             * @return std::string
+             *
+             */
+            std::string getContent() const;
 
             /**
+             * This only changes this copy of the attachment, an upload that
+             * is still running won't overwrite it.
+             *
              * @brief Sets the content URL
              *
              * @param url The URL to set
@@ -180,10 +207,30 @@ namespace GroupMe {
             std::filesystem::path m_contentPath;
 
             /**
+             * @brief The content of an attachment, shared by its copies
+             *
+             */
+            struct Content {
+                explicit Content(std::string value);
+
+                std::string get() const;
+
+                void set(std::string content);
+
+                mutable std::mutex mutex;
+
+                std::string value;
+            };
+
+            /**
+             * Uploads finish after the attachment was copied into a message,
+             * so they write the uploaded URL or file ID into this instead of
+             * into the attachment itself.
+             *
              * @brief The binary file represented as a string
              *
              */
-            std::string m_content;
+            std::shared_ptr<Content> m_content;
 
             /**
              * @brief The binary file represented as a vector
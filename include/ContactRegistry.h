@@ -0,0 +1,167 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+#include "User.h"
+#include "UserSet.hpp"
+
+namespace GroupMe {
+    /**
+     * The contacts are kept in an immutable `GroupMe::UserSet` that is
+     * swapped out atomically. Readers copy the pointer to the current set
+     * and look up in it without taking any lock that writers hold, so any
+     * number of threads can resolve contacts at once. Writers copy the
+     * set, change the copy, and publish it, so they should batch their
+     * changes into a single `update`.
+     *
+     * The users in the registry are its own copies and are never changed
+     * once they're published. A contact is changed by replacing it with
+     * a new `GroupMe::User`, see `assign`. A snapshot never changes, and
+     * stays valid for as long as it's held.
+     *
+     * @brief A thread safe set of contacts that is optimized for reading
+     *
+     */
+    class ContactRegistry {
+        public:
+            ContactRegistry();
+
+            ContactRegistry(const ContactRegistry& other) = delete;
+
+            ContactRegistry(ContactRegistry&& other) noexcept;
+
+            ContactRegistry& operator=(const ContactRegistry& other) = delete;
+
+            ContactRegistry& operator=(ContactRegistry&& other) noexcept;
+
+            /**
+             * @brief Gets the current contacts
+             *
+             * @return std::shared_ptr<const GroupMe::UserSet> A set that won't change
+             *
+             */
+            std::shared_ptr<const GroupMe::UserSet> snapshot() const;
+
+            /**
+             * @brief Finds a contact by their ID
+             *
+             * @param id The ID of the contact
+             *
+             * @return std::shared_ptr<const GroupMe::User> The contact, or `nullptr` if there isn't one
+             *
+             */
+            std::shared_ptr<const GroupMe::User> find(std::string_view id) const;
+
+            std::shared_ptr<const GroupMe::User> find(const GroupMe::ID& id) const;
+
+            /**
+             * @brief Finds a contact by their ID and gets a snapshot of them
+             *
+             * @param id The ID of the contact
+             *
+             * @return std::shared_ptr<const GroupMe::UserRecord> `nullptr` if there isn't a contact with the ID
+             *
+             */
+            std::shared_ptr<const GroupMe::UserRecord> findRecord(const GroupMe::ID& id) const;
+
+            std::size_t size() const;
+
+            /**
+             * The registry keeps a copy of the contact, so changing `contact`
+             * afterwards doesn't change the registry.
+             *
+             * @brief Adds a contact if there isn't one with the same ID
+             *
+             * @param contact The contact to add
+             *
+             * @return bool Whether or not the contact was added
+             *
+             */
+            bool insert(const std::shared_ptr<GroupMe::User>& contact);
+
+            /**
+             * Readers that already found the old contact keep seeing it
+             * unchanged.
+             *
+             * @brief Replaces the contact with the same ID with a copy of `contact`, or adds it
+             *
+             * @param contact The new version of the contact
+             *
+             */
+            void assign(const GroupMe::User& contact);
+
+            /**
+             * Like `GroupMe::UserSet::merge`, users that are already
+             * contacts are left in `set`. The registry keeps copies of the
+             * users it takes.
+             *
+             * @brief Moves the users of `set` into the contacts in a single update
+             *
+             * @param set The users to add
+             *
+             */
+            void merge(GroupMe::UserSet& set);
+
+            /**
+             * The set passed to `update` is a copy of the current contacts,
+             * which is published once `update` returns. Writers are
+             * serialized, readers keep seeing the old set until then.
+             *
+             * The users in the set are shared with readers, so they must
+             * never be changed. Erase a user and insert a new one instead.
+             *
+             * @brief Makes any number of changes to the contacts at once
+             *
+             * @param update Called with the contacts to change
+             *
+             */
+            void update(const std::function<void(GroupMe::UserSet&)>& update);
+
+            /**
+             * This is how a member list that was fetched again is synced,
+             * the diff says exactly what to update downstream.
+             *
+             * @brief Replaces all of the contacts
+             *
+             * @param contacts The new contacts
+             *
+             * @return GroupMe::UserSet::Diff What changed from the old contacts
+             *
+             */
+            GroupMe::UserSet::Diff replace(GroupMe::UserSet contacts);
+
+        private:
+            std::shared_ptr<const GroupMe::UserSet> load() const;
+
+            void publish(std::shared_ptr<const GroupMe::UserSet> contacts);
+
+            // Only ever accessed through `std::atomic_load` and `std::atomic_store`
+            std::shared_ptr<const GroupMe::UserSet> m_contacts;
+
+            // Serializes writers, readers never take it
+            std::mutex m_writer;
+    };
+}
@@ -29,11 +29,15 @@
 #include <exception>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <memory>
 
 #include <nlohmann/json.hpp>
 
 #include "Attachment.h"
 #include "util/Exceptions.h"
+#include "util/Executors.h"
+#include "util/Cancellation.h"
 
 namespace GroupMe {
     /**
@@ -88,7 +92,23 @@ namespace GroupMe {
              */
             File(std::string accessToken, web::uri contentURL, std::string conversationID);
 
-            ~File();
+            File(const File& other);
+
+            File(File&& other) noexcept = default;
+
+            /**
+             * This never waits for anything that is running for the file.
+             * If this is the last copy of the file and it hasn't been
+             * uploaded, the preparation of the file is cancelled.
+             *
+             * @brief The destructor
+             *
+             */
+            ~File() override;
+
+            File& operator=(const File& other);
+
+            File& operator=(File&& other) noexcept;
 
             /**
              * This member function will upload the file to the GroupMe
@@ -102,24 +122,71 @@ namespace GroupMe {
              *
              * @brief Uploads the file to the server
              *
+             * @param token A token that can be used to cancel the upload
+             * @param deadline The point in time the upload is cancelled at if it hasn't finished
+             *
              * @return pplx::task<std::string>
              *
              */
-            pplx::task<std::string> upload();
+            pplx::task<std::string> upload(const pplx::cancellation_token& token = pplx::cancellation_token::none(), const Util::Deadline& deadline = Util::Deadline::none());
+
+            /**
+             * This aborts any requests that are in flight for this file,
+             * including the download of the file if it was created from
+             * a URL, and stops polling for the upload status. Tasks that were
+             * cancelled will throw `pplx::task_canceled` when `.get()` is called.
+             * The file can't be uploaded after this.
+             *
+             * @brief Cancels everything that is running for this file
+             *
+             */
+            void cancel();
 
         private:
 
             // This function creates a url from two strings. Saves me a lot of pain
             static std::string getURL(std::string conversationID, std::string filename);
 
-            web::http::http_request m_request;
+            // Everything the tasks use lives in here so that the tasks can
+            // own it. That lets the file be moved or destroyed without
+            // waiting for them.
+            struct State {
+                explicit State(const web::uri& endpoint);
 
-            std::string m_conversationID;
+                web::http::http_request request;
+
+                web::http::client::http_client client;
+
+                std::vector<unsigned char> contentBinary;
+
+                // The content of the file, shared with every copy of it
+                std::shared_ptr<Attachment::Content> content;
+
+                pplx::task<void> task;
+
+                pplx::cancellation_token_source cancellation;
 
-            pplx::task<void> m_task;
+                // Copies of the file and uploads that haven't finished. Once
+                // none are left nothing can use the preparation anymore.
+                std::atomic<std::size_t> owners;
 
-            nlohmann::json m_json;
+                pplx::cancellation_token_source preparation;
+            };
+
+            // Adds this copy as an owner of the state
+            void acquire();
+
+            // Cancels the preparation if this is the last copy
+            void release();
+
+            // Drops an owner, the last one cancels the preparation and frees its buffers
+            static void release(const std::shared_ptr<State>& state);
+
+            // Checks the status url until the upload is processed
+            static pplx::task<std::string> poll(const std::shared_ptr<web::http::client::http_client>& client, const pplx::cancellation_token& token);
+
+            std::string m_conversationID;
 
-            web::http::client::http_client m_client;
+            std::shared_ptr<State> m_state;
     };
 }
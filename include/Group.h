@@ -0,0 +1,221 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <array>
+#include <memory>
+#include <limits>
+
+#include "ID.h"
+#include "User.h"
+#include "UserSet.hpp"
+#include "MemberDirectory.h"
+#include "util/Fields.h"
+
+namespace GroupMe::Util::Json {
+    class Value;
+}
+
+namespace GroupMe {
+    /**
+     * Groups are made from the responses of the groups endpoints, see
+     * `GroupMe::GroupIndex` to fetch them. Members are kept in a
+     * `GroupMe::UserSet` that is built in a single pass, unless the group
+     * has more members than the threshold it was made with. Those groups
+     * keep a `GroupMe::MemberDirectory` instead, which only builds the
+     * members that are looked up.
+     *
+     * @brief Class to represent a group chat
+     *
+     */
+    class Group {
+        public:
+            Group();
+
+            /**
+             * @brief Constructs a `GroupMe::Group` from a group object of the API
+             *
+             * @param json A JSON object that holds group data
+             * @param directoryThreshold Groups with more members than this keep a `GroupMe::MemberDirectory`
+             *
+             * @return GroupMe::Group
+             *
+             */
+            static Group createFromJson(GroupMe::Util::Json::Value& json, std::size_t directoryThreshold = std::numeric_limits<std::size_t>::max());
+
+            /**
+             * @brief Gets the ID of the group
+             *
+             * @return const GroupMe::ID&
+             *
+             */
+            const GroupMe::ID& getID() const;
+
+            /**
+             * @brief Gets the name of the group
+             *
+             * @return const std::string&
+             *
+             */
+            const std::string& getName() const;
+
+            /**
+             * @brief Gets the type of the group, `private` or `public`
+             *
+             * @return const std::string&
+             *
+             */
+            const std::string& getType() const;
+
+            const std::string& getDescription() const;
+
+            const std::string& getImageURL() const;
+
+            const std::string& getShareURL() const;
+
+            /**
+             * @brief Gets the ID of the user who created the group
+             *
+             * @return const GroupMe::ID&
+             *
+             */
+            const GroupMe::ID& getCreatorID() const;
+
+            unsigned int getCreatedAt() const;
+
+            /**
+             * @brief Gets when the group last changed, as a unix timestamp
+             *
+             * @return unsigned int
+             *
+             */
+            unsigned int getUpdatedAt() const;
+
+            /**
+             * @brief Gets the number of messages in the group
+             *
+             * @return unsigned int
+             *
+             */
+            unsigned int getMessageCount() const;
+
+            /**
+             * @brief Gets the ID of the newest message in the group
+             *
+             * @return const GroupMe::ID&
+             *
+             */
+            const GroupMe::ID& getLastMessageID() const;
+
+            /**
+             * This is empty when the group keeps a `GroupMe::MemberDirectory`,
+             * use `findMember` to work with either.
+             *
+             * @brief Gets the members of the group
+             *
+             * @return const GroupMe::UserSet&
+             *
+             */
+            const GroupMe::UserSet& getMembers() const;
+
+            /**
+             * @brief Gets the directory of the members of a large group
+             *
+             * @return std::shared_ptr<const GroupMe::MemberDirectory> `nullptr` if the members are kept in a `GroupMe::UserSet`
+             *
+             */
+            std::shared_ptr<const GroupMe::MemberDirectory> getMemberDirectory() const;
+
+            /**
+             * @brief Finds a member of the group
+             *
+             * @param userID The user ID of the member
+             *
+             * @return std::shared_ptr<GroupMe::User> `nullptr` if the user isn't a member
+             *
+             */
+            std::shared_ptr<GroupMe::User> findMember(std::string_view userID) const;
+
+            /**
+             * @brief Gets the number of members in the group
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t getMemberCount() const;
+
+            // The JSON representation of a group, defined below
+            struct Schema;
+
+        private:
+            GroupMe::ID m_id;
+
+            std::string m_name;
+
+            std::string m_type;
+
+            std::string m_description;
+
+            std::string m_imageURL;
+
+            std::string m_shareURL;
+
+            GroupMe::ID m_creatorID;
+
+            unsigned int m_createdAt;
+
+            unsigned int m_updatedAt;
+
+            unsigned int m_messageCount;
+
+            GroupMe::ID m_lastMessageID;
+
+            GroupMe::UserSet m_members;
+
+            // Shared by the copies of the group, so they share the cache too
+            std::shared_ptr<GroupMe::MemberDirectory> m_directory;
+    };
+
+    /**
+     * The members and the message summary of a group are read separately,
+     * with `GroupMe::User::Schema::member` for every member.
+     *
+     * @brief The table that maps the JSON keys of a group to its members
+     *
+     */
+    struct Group::Schema {
+        using Field = Util::Field<Group>;
+
+        static constexpr std::array<Field, 9> group = {{
+            {"id", &Group::m_id, Field::Read},
+            {"name", &Group::m_name},
+            {"type", &Group::m_type},
+            {"description", &Group::m_description},
+            {"image_url", &Group::m_imageURL},
+            {"share_url", &Group::m_shareURL, Field::Read},
+            {"creator_user_id", &Group::m_creatorID, Field::Read},
+            {"created_at", &Group::m_createdAt, Field::Read},
+            {"updated_at", &Group::m_updatedAt, Field::Read}
+        }};
+    };
+}
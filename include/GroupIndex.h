@@ -0,0 +1,184 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+#include <limits>
+
+#include <cpprest/http_client.h>
+#include <pplx/pplxtasks.h>
+
+#include "Group.h"
+#include "util/Executors.h"
+#include "util/Cancellation.h"
+
+namespace GroupMe {
+    /**
+     * Pages of `/groups` are requested several at a time instead of one
+     * after another, so an account in hundreds of groups is loaded with
+     * a single fan out of requests. Every page is revalidated with its
+     * `ETag` when it's fetched again, so pages that haven't changed
+     * aren't parsed again.
+     *
+     * @brief Fetches and caches the groups of the authenticated user
+     *
+     */
+    class GroupIndex {
+        public:
+            using Groups = std::vector<std::shared_ptr<const GroupMe::Group>>;
+
+            /**
+             * @brief Constructs a new `GroupMe::GroupIndex` object
+             *
+             * @param accessToken The users access token
+             * @param perPage The number of groups in every page, at most 100
+             * @param concurrency The number of pages that are requested at once
+             * @param directoryThreshold Groups with more members than this keep a `GroupMe::MemberDirectory`
+             *
+             */
+            explicit GroupIndex(const std::string& accessToken, std::size_t perPage = 100, std::size_t concurrency = 8, std::size_t directoryThreshold = std::numeric_limits<std::size_t>::max());
+
+            GroupIndex(const GroupIndex& other) = delete;
+
+            GroupIndex(GroupIndex&& other) noexcept = default;
+
+            /**
+             * Fetches that are still running are cancelled.
+             *
+             * @brief The destructor
+             *
+             */
+            ~GroupIndex();
+
+            GroupIndex& operator=(const GroupIndex& other) = delete;
+
+            GroupIndex& operator=(GroupIndex&& other) noexcept = default;
+
+            /**
+             * Pages are fetched `concurrency` at a time until a page comes
+             * back with fewer than `perPage` groups. The cache is replaced
+             * once every page is in.
+             *
+             * @brief Fetches every group, revalidating the cached pages
+             *
+             * @param token A token that can be used to cancel the fetch
+             * @param deadline The point in time the fetch is cancelled at if it hasn't finished
+             *
+             * @return pplx::task<GroupMe::GroupIndex::Groups> The groups in the order the API sends them
+             *
+             */
+            pplx::task<Groups> refresh(const pplx::cancellation_token& token = pplx::cancellation_token::none(), const Util::Deadline& deadline = Util::Deadline::none());
+
+            /**
+             * @brief Gets the groups from the cache if it's newer than `maxAge`, or fetches them
+             *
+             * @param maxAge How old the cache can be
+             * @param token A token that can be used to cancel the fetch
+             * @param deadline The point in time the fetch is cancelled at if it hasn't finished
+             *
+             * @return pplx::task<GroupMe::GroupIndex::Groups>
+             *
+             */
+            pplx::task<Groups> get(std::chrono::seconds maxAge, const pplx::cancellation_token& token = pplx::cancellation_token::none(), const Util::Deadline& deadline = Util::Deadline::none());
+
+            /**
+             * @brief Finds a cached group by its ID
+             *
+             * @param id The ID of the group
+             *
+             * @return std::shared_ptr<const GroupMe::Group> `nullptr` if the group isn't cached
+             *
+             */
+            std::shared_ptr<const GroupMe::Group> find(const GroupMe::ID& id) const;
+
+            /**
+             * @brief Gets the cached groups without fetching anything
+             *
+             * @return GroupMe::GroupIndex::Groups
+             *
+             */
+            Groups getCached() const;
+
+            /**
+             * @brief Cancels every fetch that is running
+             *
+             */
+            void cancel();
+
+        private:
+            // A page of `/groups` as it was last fetched
+            struct Page {
+                std::string etag;
+
+                Groups groups;
+            };
+
+            // Everything the tasks use lives in here so that the tasks can own it
+            struct State {
+                State();
+
+                std::string accessToken;
+
+                // Every page is fetched with the same client so connections are reused
+                web::http::client::http_client client;
+
+                std::size_t perPage;
+
+                std::size_t concurrency;
+
+                std::size_t directoryThreshold;
+
+                pplx::cancellation_token_source cancellation;
+
+                // Guards everything below
+                mutable std::mutex mutex;
+
+                // Page `n` is at `n - 1`
+                std::vector<Page> pages;
+
+                Groups groups;
+
+                std::unordered_map<GroupMe::ID, std::shared_ptr<const GroupMe::Group>> byID;
+
+                Util::Deadline::Clock::time_point fetchedAt;
+
+                bool fetched = false;
+            };
+
+            // The pages of one refresh, in order
+            struct Batch {
+                std::vector<Page> pages;
+            };
+
+            static pplx::task<Page> fetchPage(const std::shared_ptr<State>& state, std::size_t page, const pplx::cancellation_token& token);
+
+            // Fetches `concurrency` pages starting at `first`, and the next
+            // ones after that until the last page
+            static pplx::task<void> fetchPages(const std::shared_ptr<State>& state, const std::shared_ptr<Batch>& batch, std::size_t first, const pplx::cancellation_token& token);
+
+            std::shared_ptr<State> m_state;
+    };
+}
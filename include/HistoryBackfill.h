@@ -0,0 +1,214 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+
+#include <cpprest/http_client.h>
+#include <pplx/pplxtasks.h>
+
+#include "ID.h"
+#include "MessagePage.h"
+#include "util/Cancellation.h"
+#include "util/Limiter.h"
+
+namespace GroupMe {
+    /**
+     * The messages endpoint pages with `before_id`, so the pages of one group
+     * have to be fetched one after another. The backfill hides the round
+     * trips by always having the next request of a group in flight while
+     * the page before it is handed to the sink. Every group runs its own
+     * pipeline, and all of them share one budget of concurrent requests.
+     *
+     * Pages are parsed into a `GroupMe::MessagePage` on the CPU scheduler.
+     * At most two pages per group are held at once, so a slow sink slows
+     * the backfill down instead of piling pages up.
+     *
+     * For example:
+     * `backfill.run(groupIDs, [&](const GroupMe::ID& group, const GroupMe::MessagePage& page) { store.append(page); });`
+     *
+     * @brief Downloads the message history of groups
+     *
+     */
+    class HistoryBackfill {
+        public:
+            /**
+             * Pages of one group are handed over newest first and one at a
+             * time, but pages of different groups can be handed over at once.
+             *
+             * @brief Receives the pages of a backfill
+             *
+             */
+            using Sink = std::function<void(const GroupMe::ID& group, const GroupMe::MessagePage& page)>;
+
+            /**
+             * @brief How much a backfill has downloaded
+             *
+             */
+            struct Progress {
+                uint64_t pages = 0;
+
+                uint64_t messages = 0;
+
+                uint64_t bytes = 0;
+
+                Util::Deadline::Clock::duration elapsed = Util::Deadline::Clock::duration::zero();
+
+                /**
+                 * @brief Gets the number of pages that were downloaded per second
+                 *
+                 * @return double
+                 *
+                 */
+                double pagesPerSecond() const;
+
+                /**
+                 * @brief Gets the number of bytes that were downloaded per second
+                 *
+                 * @return double
+                 *
+                 */
+                double bytesPerSecond() const;
+            };
+
+            /**
+             * @brief Constructs a new `GroupMe::HistoryBackfill` object
+             *
+             * @param accessToken The users access token
+             * @param concurrency The number of requests that are in flight at once, across every group
+             * @param limit The number of messages in every page, at most 100
+             *
+             */
+            explicit HistoryBackfill(const std::string& accessToken, std::size_t concurrency = 8, std::size_t limit = 100);
+
+            HistoryBackfill(const HistoryBackfill& other) = delete;
+
+            HistoryBackfill(HistoryBackfill&& other) noexcept = default;
+
+            /**
+             * Backfills that are still running are cancelled.
+             *
+             * @brief The destructor
+             *
+             */
+            ~HistoryBackfill();
+
+            HistoryBackfill& operator=(const HistoryBackfill& other) = delete;
+
+            HistoryBackfill& operator=(HistoryBackfill&& other) noexcept = default;
+
+            /**
+             * @brief Downloads the history of a group, from the newest message back
+             *
+             * @param group The ID of the group
+             * @param sink Receives every page
+             * @param beforeID Only download messages before this one, empty to start at the newest
+             * @param token A token to cancel the backfill with
+             * @param deadline A deadline to cancel the backfill at
+             *
+             * @return pplx::task<GroupMe::HistoryBackfill::Progress> What this backfill downloaded
+             *
+             */
+            pplx::task<Progress> run(const GroupMe::ID& group, Sink sink, const GroupMe::ID& beforeID = GroupMe::ID(), const pplx::cancellation_token& token = pplx::cancellation_token::none(), const Util::Deadline& deadline = Util::Deadline::none());
+
+            /**
+             * Every group is started at once, the concurrency budget decides
+             * how many of their requests are actually in flight.
+             *
+             * @brief Downloads the whole history of many groups in parallel
+             *
+             * @param groups The IDs of the groups
+             * @param sink Receives every page of every group
+             * @param token A token to cancel the backfill with
+             * @param deadline A deadline to cancel the backfill at
+             *
+             * @return pplx::task<GroupMe::HistoryBackfill::Progress> What this backfill downloaded
+             *
+             */
+            pplx::task<Progress> run(const std::vector<GroupMe::ID>& groups, Sink sink, const pplx::cancellation_token& token = pplx::cancellation_token::none(), const Util::Deadline& deadline = Util::Deadline::none());
+
+            /**
+             * @brief Gets what every backfill has downloaded since the object was made
+             *
+             * @return GroupMe::HistoryBackfill::Progress
+             *
+             */
+            Progress getProgress() const;
+
+            /**
+             * @brief Cancels every backfill that is running
+             *
+             */
+            void cancel();
+
+        private:
+            struct Counters {
+                std::atomic<uint64_t> pages{0};
+
+                std::atomic<uint64_t> messages{0};
+
+                std::atomic<uint64_t> bytes{0};
+
+                Util::Deadline::Clock::time_point started = Util::Deadline::Clock::now();
+
+                void add(const GroupMe::MessagePage& page);
+
+                Progress snapshot() const;
+            };
+
+            // Everything the tasks use lives in here so that the tasks can own it
+            struct State {
+                State();
+
+                std::string accessToken;
+
+                // Every page is fetched with the same client so connections are reused
+                web::http::client::http_client client;
+
+                std::size_t limit;
+
+                std::shared_ptr<Util::Limiter> limiter;
+
+                pplx::cancellation_token_source cancellation;
+
+                Counters total;
+            };
+
+            // What one call to `run` shares between its groups
+            struct Run {
+                Sink sink;
+
+                Counters counters;
+            };
+
+            // Fetches and parses the page before `beforeID`, `nullptr` if there are no more
+            static pplx::task<std::shared_ptr<GroupMe::MessagePage>> fetchPage(const std::shared_ptr<State>& state, const GroupMe::ID& group, const GroupMe::ID& beforeID, const pplx::cancellation_token& token);
+
+            // Hands pages to the sink after `delivered` finishes, while the next page is fetched
+            static pplx::task<void> backfill(const std::shared_ptr<State>& state, const std::shared_ptr<Run>& run, const GroupMe::ID& group, const GroupMe::ID& beforeID, pplx::task<void> delivered, const pplx::cancellation_token& token);
+
+            std::shared_ptr<State> m_state;
+    };
+}
@@ -0,0 +1,197 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <functional>
+
+namespace GroupMe {
+    /**
+     * User, message and group IDs from the API are numeric strings, so
+     * they are parsed into a 64 bit integer once when they come in. IDs
+     * that aren't in canonical decimal form, like ones with a leading
+     * zero, are kept as text instead. Text IDs of up to `s_shortCapacity`
+     * characters don't allocate. `toString` always gives back exactly the
+     * text the ID was made from.
+     *
+     * Numeric IDs order by their value and come before text IDs, which
+     * order like strings. The empty ID comes before everything.
+     *
+     * @brief A compact user, message or group ID
+     *
+     */
+    class ID {
+        public:
+            // Text IDs up to this long are stored inline, it's as big as
+            // a long ID's pointer and size so the ID stays 24 bytes
+            static constexpr std::size_t s_shortCapacity = 16;
+
+            /**
+             * @brief Constructs an empty ID
+             *
+             */
+            ID() noexcept;
+
+            /**
+             * @brief Constructs an ID from its text
+             *
+             * @param id The ID as the API sends it
+             *
+             */
+            explicit ID(std::string_view id);
+
+            ID(const ID& other);
+
+            ID(ID&& other) noexcept;
+
+            ~ID();
+
+            ID& operator=(const ID& other);
+
+            ID& operator=(ID&& other) noexcept;
+
+            /**
+             * @brief Constructs a numeric ID
+             *
+             * @param number The number of the ID
+             *
+             * @return GroupMe::ID
+             *
+             */
+            static ID fromNumber(uint64_t number);
+
+            bool empty() const;
+
+            /**
+             * @brief Returns whether the ID is stored as a number
+             *
+             * @return bool
+             *
+             */
+            bool isNumber() const;
+
+            /**
+             * @brief Gets the number of a numeric ID
+             *
+             * @return uint64_t Zero if the ID isn't a number
+             *
+             */
+            uint64_t getNumber() const;
+
+            /**
+             * @brief Gets the ID as the API sends it
+             *
+             * @return std::string
+             *
+             */
+            std::string toString() const;
+
+            /**
+             * @brief Appends the text of the ID to a string
+             *
+             * @param out The string to append to
+             *
+             */
+            void appendTo(std::string& out) const;
+
+            std::size_t hash() const;
+
+            /**
+             * @brief Compares two IDs
+             *
+             * @param other The ID to compare to
+             *
+             * @return int Less than, equal to or greater than zero, like `std::string::compare`
+             *
+             */
+            int compare(const ID& other) const;
+
+            friend bool operator==(const ID& a, const ID& b) {
+                return a.compare(b) == 0;
+            }
+
+            friend bool operator!=(const ID& a, const ID& b) {
+                return a.compare(b) != 0;
+            }
+
+            friend bool operator<(const ID& a, const ID& b) {
+                return a.compare(b) < 0;
+            }
+
+            friend bool operator<=(const ID& a, const ID& b) {
+                return a.compare(b) <= 0;
+            }
+
+            friend bool operator>(const ID& a, const ID& b) {
+                return a.compare(b) > 0;
+            }
+
+            friend bool operator>=(const ID& a, const ID& b) {
+                return a.compare(b) >= 0;
+            }
+
+        private:
+            // In the order that IDs of different kinds compare in, `Short`
+            // and `Long` are both text
+            enum class Kind : uint8_t {
+                Empty,
+                Number,
+                Short,
+                Long
+            };
+
+            struct Long {
+                char* data;
+
+                std::size_t size;
+            };
+
+            // The text of a `Short` or `Long` ID
+            std::string_view text() const;
+
+            void assignText(std::string_view text);
+
+            void release();
+
+            union {
+                uint64_t m_number;
+
+                char m_short[s_shortCapacity];
+
+                Long m_long;
+            };
+
+            uint8_t m_length;
+
+            Kind m_kind;
+    };
+}
+
+namespace std {
+    template <>
+    struct hash<GroupMe::ID> {
+        std::size_t operator()(const GroupMe::ID& id) const noexcept {
+            return id.hash();
+        }
+    };
+}
@@ -0,0 +1,277 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <functional>
+
+#include "User.h"
+#include "ID.h"
+
+namespace GroupMe {
+    /**
+     * Two handles from the same `GroupMe::IdentityTable` are equal if and
+     * only if they refer to the same user ID, so comparing senders is an
+     * integer compare.
+     *
+     * @brief A compact handle to an interned user
+     *
+     */
+    class UserHandle {
+        public:
+            /**
+             * @brief Constructs a handle that doesn't refer to any user
+             *
+             */
+            constexpr UserHandle() :
+                m_value(0)
+            {
+
+            }
+
+            constexpr explicit UserHandle(uint32_t value) :
+                m_value(value)
+            {
+
+            }
+
+            /**
+             * @brief Gets the raw value of the handle
+             *
+             * @return uint32_t
+             *
+             */
+            constexpr uint32_t value() const {
+                return m_value;
+            }
+
+            /**
+             * @brief Returns whether or not the handle refers to a user
+             *
+             * @return bool
+             *
+             */
+            constexpr bool isValid() const {
+                return m_value != 0;
+            }
+
+            friend constexpr bool operator==(const UserHandle& lhs, const UserHandle& rhs) {
+                return lhs.m_value == rhs.m_value;
+            }
+
+            friend constexpr bool operator!=(const UserHandle& lhs, const UserHandle& rhs) {
+                return lhs.m_value != rhs.m_value;
+            }
+
+            friend constexpr bool operator<(const UserHandle& lhs, const UserHandle& rhs) {
+                return lhs.m_value < rhs.m_value;
+            }
+
+        private:
+            uint32_t m_value;
+    };
+
+    /**
+     * Every user ID that is seen is interned once along with the nickname
+     * and avatar URL it was last seen with. Messages keep a `GroupMe::UserHandle`
+     * to their sender, and senders that aren't in a group share one `GroupMe::User`
+     * per identity instead of every message making its own.
+     *
+     * The table is thread safe and `GroupMe::IdentityTable::global` is shared
+     * by every page and group. Handles stay valid forever, so only the compact
+     * ID of every user is kept for good. A changed nickname or avatar URL
+     * replaces the old one, and the table doesn't keep users alive that
+     * nothing else refers to.
+     *
+     * @brief An interning table for user identities
+     *
+     */
+    class IdentityTable {
+        public:
+            /**
+             * @brief Gets the table that is shared by the whole library
+             *
+             * @return GroupMe::IdentityTable&
+             *
+             */
+            static IdentityTable& global();
+
+            IdentityTable() = default;
+
+            IdentityTable(const IdentityTable& other) = delete;
+
+            IdentityTable& operator=(const IdentityTable& other) = delete;
+
+            /**
+             * A user that's already interned keeps the nickname and avatar URL it has.
+             *
+             * @brief Gets the handle of a user ID, interning it if it's new
+             *
+             * @param userID The ID of the user
+             *
+             * @return GroupMe::UserHandle
+             *
+             */
+            UserHandle intern(const GroupMe::ID& userID);
+
+            /**
+             * @brief Gets the handle of a user ID, interning it if it's new
+             *
+             * @param userID The ID of the user
+             *
+             * @return GroupMe::UserHandle
+             *
+             */
+            UserHandle intern(std::string_view userID);
+
+            /**
+             * If the nickname or avatar URL changed since the user was last seen
+             * they're updated, and `getUser` will hand out a new `GroupMe::User`.
+             *
+             * @brief Gets the handle of a user, interning it if it's new
+             *
+             * @param userID The ID of the user
+             * @param nickname The nickname of the user
+             * @param avatarURL The avatar URL of the user
+             *
+             * @return GroupMe::UserHandle
+             *
+             */
+            UserHandle intern(std::string_view userID, std::string_view nickname, std::string_view avatarURL);
+
+            /**
+             * @brief Finds the handle of a user ID without interning it
+             *
+             * @param userID The ID of the user
+             *
+             * @return GroupMe::UserHandle An invalid handle if the ID was never interned
+             *
+             */
+            UserHandle find(std::string_view userID) const;
+
+            /**
+             * @brief Gets the user ID of a handle
+             *
+             * @param handle A valid handle from this table
+             *
+             * @return const GroupMe::ID&
+             *
+             */
+            const GroupMe::ID& getID(UserHandle handle) const;
+
+            /**
+             * This is a copy, since the nickname can be replaced at any time.
+             *
+             * @brief Gets the nickname a user was last seen with
+             *
+             * @param handle A valid handle from this table
+             *
+             * @return std::string
+             *
+             */
+            std::string getNickname(UserHandle handle) const;
+
+            /**
+             * This is a copy, since the avatar URL can be replaced at any time.
+             *
+             * @brief Gets the avatar URL a user was last seen with
+             *
+             * @param handle A valid handle from this table
+             *
+             * @return std::string
+             *
+             */
+            std::string getAvatarURL(UserHandle handle) const;
+
+            /**
+             * The same `GroupMe::User` is returned until the identity changes,
+             * as long as something still holds on to it.
+             *
+             * @brief Gets the shared `GroupMe::User` of a handle
+             *
+             * @param handle A valid handle from this table
+             *
+             * @return std::shared_ptr<GroupMe::User>
+             *
+             */
+            std::shared_ptr<GroupMe::User> getUser(UserHandle handle);
+
+            /**
+             * @brief Gets the number of interned users
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t size() const;
+
+        private:
+            struct Entry {
+                explicit Entry(const GroupMe::ID& id);
+
+                const GroupMe::ID id;
+
+                // Guards everything below, so updating a user that's already
+                // interned never needs the table's exclusive lock
+                mutable std::mutex mutex;
+
+                std::string nickname;
+
+                std::string avatarURL;
+
+                // Made the first time it's asked for, and not owned so it's
+                // freed once no message uses it
+                std::weak_ptr<GroupMe::User> user;
+            };
+
+            // This must be called with `m_mutex` held
+            UserHandle findLocked(const GroupMe::ID& userID) const;
+
+            // This takes `m_mutex` itself
+            Entry& entry(UserHandle handle) const;
+
+            // Adds the entry if it's still missing, `m_mutex` must not be held
+            UserHandle insert(const GroupMe::ID& userID);
+
+            mutable std::shared_mutex m_mutex;
+
+            std::unordered_map<GroupMe::ID, uint32_t> m_handles;
+
+            // The entry of a handle is at `value() - 1`. A deque never moves
+            // its elements, so entries can be used with just the shared lock.
+            mutable std::deque<Entry> m_entries;
+    };
+}
+
+namespace std {
+    template <>
+    struct hash<GroupMe::UserHandle> {
+        std::size_t operator()(const GroupMe::UserHandle& handle) const noexcept {
+            return std::hash<uint32_t>()(handle.value());
+        }
+    };
+}
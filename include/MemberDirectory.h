@@ -0,0 +1,207 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+#include "ID.h"
+#include "User.h"
+#include "UserSet.hpp"
+
+namespace GroupMe::Util::Json {
+    class Value;
+}
+
+namespace GroupMe {
+    class Group;
+
+    /**
+     * Only the ID, nickname and avatar URL of every member are kept, packed
+     * into one buffer and sorted by ID. A full `GroupMe::User` is built the
+     * first time a member is looked up, and the most recently used ones are
+     * kept in an LRU so that a member who sends a lot of messages is only
+     * built once. A member that's evicted but still used somewhere, like
+     * by a message, gets the same `GroupMe::User` when it's looked up again.
+     *
+     * This is meant for groups with thousands of members, where only the
+     * few who actually send messages are ever needed. Lookups are thread safe.
+     *
+     * @brief A compact index of the members of a group that builds users on demand
+     *
+     */
+    class MemberDirectory {
+        public:
+            /**
+             * @brief Constructs an empty `GroupMe::MemberDirectory`
+             *
+             * @param capacity The number of users that are kept built
+             *
+             */
+            explicit MemberDirectory(std::size_t capacity = 256);
+
+            MemberDirectory(const MemberDirectory& other) = delete;
+
+            MemberDirectory(MemberDirectory&& other) noexcept;
+
+            MemberDirectory& operator=(const MemberDirectory& other) = delete;
+
+            MemberDirectory& operator=(MemberDirectory&& other) noexcept;
+
+            /**
+             * Members that are listed more than once keep the first entry.
+             *
+             * @brief Constructs a `GroupMe::MemberDirectory` from the `members` of a group
+             *
+             * @param members A JSON array of member objects
+             * @param capacity The number of users that are kept built
+             *
+             * @return GroupMe::MemberDirectory
+             *
+             */
+            static MemberDirectory createFromJson(GroupMe::Util::Json::Value& members, std::size_t capacity = 256);
+
+            /**
+             * @brief Finds a member, building the user if it isn't cached
+             *
+             * @param id The user ID of the member
+             *
+             * @return std::shared_ptr<GroupMe::User> `nullptr` if the user isn't a member
+             *
+             */
+            std::shared_ptr<GroupMe::User> find(const GroupMe::ID& id) const;
+
+            std::shared_ptr<GroupMe::User> find(std::string_view id) const;
+
+            /**
+             * @brief Returns whether or not a user is a member, without building it
+             *
+             * @param id The user ID
+             *
+             * @return bool
+             *
+             */
+            bool contains(const GroupMe::ID& id) const;
+
+            /**
+             * @brief Gets the number of members
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t size() const;
+
+            /**
+             * @brief Gets the number of members that are currently built
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t cached() const;
+
+            std::size_t capacity() const;
+
+            /**
+             * Shrinking the capacity evicts the least recently used members.
+             *
+             * @brief Sets the number of users that are kept built
+             *
+             * @param capacity The new capacity
+             *
+             */
+            void setCapacity(std::size_t capacity);
+
+            /**
+             * Members that are built are shared with the set. The rest are
+             * built without being cached, but later lookups reuse them for as
+             * long as the set holds them.
+             *
+             * @brief Builds every member into a `GroupMe::UserSet`
+             *
+             * @return GroupMe::UserSet
+             *
+             */
+            GroupMe::UserSet toUserSet() const;
+
+        private:
+            // Groups switch to a directory part way through their members
+            friend class GroupMe::Group;
+
+            // A member is the ID and two strings that are packed into `m_text`
+            struct Entry {
+                GroupMe::ID id;
+
+                uint32_t offset;
+
+                uint16_t nicknameLength;
+
+                uint16_t imageLength;
+            };
+
+            struct Cached {
+                uint32_t entry;
+
+                std::shared_ptr<GroupMe::User> user;
+            };
+
+            void add(std::string_view userID, std::string_view nickname, std::string_view imageURL);
+
+            // Adds one element of a `members` array
+            void read(GroupMe::Util::Json::Value& member);
+
+            // Sorts the entries and drops the duplicates, once they're all added
+            void seal();
+
+            const Entry* lookup(const GroupMe::ID& id) const;
+
+            std::shared_ptr<GroupMe::User> build(const Entry& entry) const;
+
+            // These expect `m_mutex` to be held
+            void evict() const;
+
+            // Gets the user of an entry if one is cached or still alive
+            std::shared_ptr<GroupMe::User> reuse(uint32_t index) const;
+
+            void remember(uint32_t index, const std::shared_ptr<GroupMe::User>& user) const;
+
+            std::vector<Entry> m_entries;
+
+            std::string m_text;
+
+            std::size_t m_capacity;
+
+            // The most recently used member is at the front
+            mutable std::list<Cached> m_recent;
+
+            mutable std::unordered_map<uint32_t, std::list<Cached>::iterator> m_cache;
+
+            // Every user that was handed out, by entry. Made on the first
+            // lookup, so a directory nobody looks into stays small
+            mutable std::vector<std::weak_ptr<GroupMe::User>> m_live;
+
+            mutable std::mutex m_mutex;
+    };
+}
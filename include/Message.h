@@ -20,7 +20,9 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <nlohmann/json.hpp>
+#include <pplx/pplxtasks.h>
 
 #include "Attachment.h"
 #include "Picture.h"
@@ -28,6 +30,13 @@
 #include "File.h"
 #include "User.h"
 #include "UserSet.hpp"
+#include "IdentityTable.h"
+#include "MemberDirectory.h"
+#include "util/Executors.h"
+
+namespace GroupMe::Util::Json {
+    class Value;
+}
 
 namespace GroupMe {
     /**
@@ -106,6 +115,84 @@ namespace GroupMe {
              */
             static Message createFromJson(const nlohmann::json &json, const GroupMe::UserSet &user);
 
+            /**
+             * The value is read in a single pass with whichever JSON backend
+             * the library was built with, see `util/Json.h`.
+             *
+             * @brief Constructs a `GroupMe::Message` from a JSON value.
+             *
+             * @param json A JSON object that holds message data
+             *
+             * @param users The users that are the group that the message was sent in
+             *
+             */
+            static Message createFromJson(GroupMe::Util::Json::Value& json, const GroupMe::UserSet &users);
+
+            /**
+             * Only the sender and the users who favorited the message are
+             * built, and only if the directory doesn't already have them cached.
+             *
+             * @brief Constructs a `GroupMe::Message` from a JSON value, resolving users through a directory
+             *
+             * @param json A JSON object that holds message data
+             *
+             * @param members The members of the group that the message was sent in
+             *
+             */
+            static Message createFromJson(GroupMe::Util::Json::Value& json, const GroupMe::MemberDirectory &members);
+
+            /**
+             * This parses the body straight into messages with
+             * `GroupMe::Util::MessagePageParser`, or with simdjson when the
+             * library is built with `GROUPME_SIMDJSON`, so no `nlohmann::json`
+             * is built for the page. This should be preferred over parsing the
+             * page and calling `createFromJson` for every message.
+             *
+             * @brief Constructs `GroupMe::Message`'s from a page of messages
+             *
+             * @param page The body of a response from the messages endpoint
+             *
+             * @param users The users that are in the group that the messages were sent in
+             *
+             * @return std::vector<GroupMe::Message>
+             *
+             */
+            static std::vector<Message> createFromPage(const std::string& page, const GroupMe::UserSet &users);
+
+            /**
+             * @brief Constructs `GroupMe::Message`'s from a page of messages, resolving users through a directory
+             *
+             * @param page The body of a response from the messages endpoint
+             *
+             * @param members The members of the group that the messages were sent in
+             *
+             * @return std::vector<GroupMe::Message>
+             *
+             */
+            static std::vector<Message> createFromPage(const std::string& page, const GroupMe::MemberDirectory &members);
+
+            /**
+             * Every page is decoded as its own task on the scheduler, which is
+             * the CPU pool by default, so a big backlog uses every core. Pass a
+             * `GroupMe::Util::ThreadPool` to pick the amount of threads. The pages
+             * are then merged into one vector ordered by `created_at`, oldest first.
+             * Messages with the same `created_at` keep the order of the pages.
+             *
+             * @brief Constructs `GroupMe::Message`'s from many pages of messages in parallel
+             *
+             * @param pages The bodies of responses from the messages endpoint
+             *
+             * @param users The users that are in the group that the messages were sent in
+             *
+             * @param scheduler The scheduler to decode the pages on
+             *
+             * @param token A token to cancel the decoding with
+             *
+             * @return pplx::task<std::vector<GroupMe::Message>>
+             *
+             */
+            static pplx::task<std::vector<Message>> createFromPages(std::vector<std::string> pages, const GroupMe::UserSet &users, const std::shared_ptr<pplx::scheduler_interface>& scheduler = GroupMe::Util::Executors::cpu(), const pplx::cancellation_token& token = pplx::cancellation_token::none());
+
             /**
              * @brief Gets the ID of the message
              *
@@ -122,6 +209,14 @@ namespace GroupMe {
              */
             void setID(const std::string& messageID);
 
+            /**
+             * @brief Gets the ID of the message without converting it to a string
+             *
+             * @return const GroupMe::ID&
+             *
+             */
+            const GroupMe::ID& getCompactID() const;
+
             /**
              * @brief Gets when the message was created at
              *
@@ -178,6 +273,14 @@ namespace GroupMe {
              */
             std::shared_ptr<const GroupMe::User> getSender() const;
 
+            /**
+             * @brief Gets a snapshot of the sender of the message, shared with the sender
+             *
+             * @return std::shared_ptr<const GroupMe::UserRecord> `nullptr` if the message has no sender
+             *
+             */
+            std::shared_ptr<const GroupMe::UserRecord> getSenderRecord() const;
+
             /**
              * @brief Sets the user info for the sender of the message
              *
@@ -186,6 +289,20 @@ namespace GroupMe {
              */
             void setSender(const std::shared_ptr<GroupMe::User>& sender);
 
+            /**
+             * Two messages were sent by the same user if and only if their
+             * sender handles are equal.
+             *
+             * @brief Gets the handle of the sender in `GroupMe::IdentityTable::global`
+             *
+             * @return GroupMe::UserHandle An invalid handle if the message has no sender
+             *
+             */
+            GroupMe::UserHandle getSenderHandle() const;
+
+            // The JSON representation of a message that is sent, defined below
+            struct Schema;
+
             /**
              * @brief Adds a person to the favorited by list
              *
@@ -194,8 +311,16 @@ namespace GroupMe {
              */
             void addFavorited(const std::shared_ptr<GroupMe::User> &favoritedBy);
 
+            /**
+             * @brief Gets the users who favorited the message
+             *
+             * @return const std::vector<std::shared_ptr<GroupMe::User>>&
+             *
+             */
+            const std::vector<std::shared_ptr<GroupMe::User>>& getFavorited() const;
+
         private:
-            std::string m_id;
+            GroupMe::ID m_id;
 
             std::string m_guid;
 
@@ -209,10 +334,28 @@ namespace GroupMe {
 
             std::shared_ptr<GroupMe::User> m_sender;
 
+            GroupMe::UserHandle m_senderHandle;
+
             std::vector<GroupMe::Attachment> m_attachments;
 
             std::vector<std::shared_ptr<GroupMe::User>> m_favoritedBy;
 
             std::string m_text;
     };
+
+    /**
+     * Messages are read through `GroupMe::Util::MessageFields`, since
+     * the sender and attachments need the users of the group.
+     *
+     * @brief The table that maps the JSON keys of a message that is sent to its members
+     *
+     */
+    struct Message::Schema {
+        using Field = Util::Field<Message>;
+
+        static constexpr std::array<Field, 2> outbound = {{
+            {"source_guid", &Message::m_guid, Field::Write},
+            {"text", &Message::m_text, Field::Write}
+        }};
+    };
 }
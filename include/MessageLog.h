@@ -0,0 +1,418 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <filesystem>
+
+#include "ID.h"
+#include "Message.h"
+#include "MessagePage.h"
+#include "MemberDirectory.h"
+#include "UserSet.hpp"
+
+namespace GroupMe {
+    /**
+     * Messages are appended to segment files in a compact binary encoding,
+     * where numeric IDs are varints and strings are length prefixed. A
+     * segment is closed once it's full and a new one is started, nothing
+     * is ever rewritten.
+     *
+     * Two indexes are kept next to the segments:
+     * - An open addressing hash table from message ID to record, which is
+     *   memory mapped, so opening the log doesn't load it
+     * - A sparse index by `created_at`, with the smallest and largest time
+     *   of every block of records. Range reads skip whole blocks that don't
+     *   overlap, and only decode the time of the records in the rest
+     *
+     * The segments are memory mapped as well, and records are read straight
+     * out of the mapping. Opening the log only checks the records that were
+     * written after the indexes were last brought up to date, and drops a
+     * record that was cut off by a crash.
+     *
+     * This class isn't synchronized, just like the standard containers.
+     *
+     * @brief An append only, memory mapped log of messages
+     *
+     */
+    class MessageLog {
+        public:
+            /**
+             * @brief Options used to open a `GroupMe::MessageLog`
+             *
+             */
+            struct Options {
+                /**
+                 * @brief The size a segment is closed at, in bytes
+                 *
+                 */
+                std::size_t segmentSize = 64 * 1024 * 1024;
+
+                /**
+                 * @brief The number of records in every block of the time index
+                 *
+                 */
+                std::size_t blockRecords = 64;
+
+                /**
+                 * @brief Whether or not every append waits for the data to reach the disk
+                 *
+                 */
+                bool sync = false;
+            };
+
+            /**
+             * The views it hands out point into the log, so they're only
+             * valid while the log is alive.
+             *
+             * @brief A message that was read out of a `GroupMe::MessageLog`
+             *
+             */
+            class Record {
+                public:
+                    const GroupMe::ID& getID() const;
+
+                    uint64_t getCreatedAt() const;
+
+                    /**
+                     * @brief Gets the ID of the user who sent the message
+                     *
+                     * @return const GroupMe::ID&
+                     *
+                     */
+                    const GroupMe::ID& getUserID() const;
+
+                    std::string_view getName() const;
+
+                    std::string_view getAvatarURL() const;
+
+                    std::string_view getText() const;
+
+                    /**
+                     * @brief Gets the IDs of the users who favorited the message
+                     *
+                     * @return const std::vector<GroupMe::ID>&
+                     *
+                     */
+                    const std::vector<GroupMe::ID>& getFavoritedBy() const;
+
+                    const std::vector<GroupMe::MessagePage::AttachmentView>& getAttachments() const;
+
+                    /**
+                     * @brief Copies the record into a `GroupMe::Message`
+                     *
+                     * @param users The users that are in the group that the message was sent in
+                     *
+                     * @return GroupMe::Message
+                     *
+                     */
+                    GroupMe::Message toMessage(const GroupMe::UserSet& users) const;
+
+                    GroupMe::Message toMessage(const GroupMe::MemberDirectory& members) const;
+
+                private:
+                    friend class MessageLog;
+
+                    GroupMe::ID m_id;
+
+                    uint64_t m_createdAt = 0;
+
+                    GroupMe::ID m_userID;
+
+                    std::string_view m_name;
+
+                    std::string_view m_avatarURL;
+
+                    std::string_view m_text;
+
+                    std::vector<GroupMe::ID> m_favoritedBy;
+
+                    std::vector<GroupMe::MessagePage::AttachmentView> m_attachments;
+            };
+
+            using Visitor = std::function<void(const Record& record)>;
+
+            /**
+             * The directory is created if it doesn't exist.
+             *
+             * @brief Opens the log in a directory with the default options
+             *
+             * @param directory The directory of the log
+             *
+             */
+            explicit MessageLog(const std::filesystem::path& directory);
+
+            /**
+             * The directory is created if it doesn't exist.
+             *
+             * @brief Opens the log in a directory
+             *
+             * @param directory The directory of the log
+             * @param options The options for the log
+             *
+             */
+            MessageLog(const std::filesystem::path& directory, const Options& options);
+
+            MessageLog(const MessageLog& other) = delete;
+
+            MessageLog(MessageLog&& other) noexcept = default;
+
+            MessageLog& operator=(const MessageLog& other) = delete;
+
+            MessageLog& operator=(MessageLog&& other) noexcept = default;
+
+            ~MessageLog() = default;
+
+            /**
+             * @brief Appends a message
+             *
+             * @param message The message to append
+             *
+             * @return bool `false` if a message with the same ID is already in the log
+             *
+             */
+            bool append(const GroupMe::Message& message);
+
+            /**
+             * This writes straight from the views of the page, without making
+             * a `GroupMe::Message` for any of them.
+             *
+             * @brief Appends every message of a page
+             *
+             * @param page The page to append
+             *
+             * @return std::size_t The number of messages that weren't already in the log
+             *
+             */
+            std::size_t append(const GroupMe::MessagePage& page);
+
+            /**
+             * @brief Returns whether or not a message is in the log
+             *
+             * @param id The ID of the message
+             *
+             * @return bool
+             *
+             */
+            bool contains(const GroupMe::ID& id) const;
+
+            /**
+             * @brief Finds a message by its ID
+             *
+             * @param id The ID of the message
+             *
+             * @return std::optional<GroupMe::MessageLog::Record>
+             *
+             */
+            std::optional<Record> find(const GroupMe::ID& id) const;
+
+            /**
+             * Records are visited in the order they were appended in.
+             *
+             * @brief Visits the messages created in `[from, to)`
+             *
+             * @param from The first time to visit
+             * @param to The first time after the range
+             * @param visitor Called with every record in the range
+             *
+             */
+            void scan(uint64_t from, uint64_t to, const Visitor& visitor) const;
+
+            /**
+             * @brief Visits every message, in the order they were appended in
+             *
+             * @param visitor Called with every record
+             *
+             */
+            void forEach(const Visitor& visitor) const;
+
+            /**
+             * @brief Gets the number of messages in the log
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t size() const;
+
+            /**
+             * @brief Gets the number of segment files
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t segments() const;
+
+            /**
+             * @brief Waits for everything that was appended to reach the disk
+             *
+             */
+            void flush();
+
+        private:
+            // Owns a file descriptor
+            class File {
+                public:
+                    File() = default;
+
+                    explicit File(int descriptor);
+
+                    File(File&& other) noexcept;
+
+                    File& operator=(File&& other) noexcept;
+
+                    ~File();
+
+                    int get() const;
+
+                private:
+                    int m_descriptor = -1;
+            };
+
+            // Owns a read only or read write mapping
+            class Mapping {
+                public:
+                    Mapping() = default;
+
+                    Mapping(const File& file, std::size_t length, bool writable);
+
+                    Mapping(Mapping&& other) noexcept;
+
+                    Mapping& operator=(Mapping&& other) noexcept;
+
+                    ~Mapping();
+
+                    char* data() const;
+
+                    std::size_t length() const;
+
+                private:
+                    char* m_data = nullptr;
+
+                    std::size_t m_length = 0;
+            };
+
+            struct Segment {
+                File file;
+
+                Mapping mapping;
+
+                // The bytes that were written, the mapping can be longer
+                std::size_t size = 0;
+            };
+
+            // Where a record starts, the segment and the offset in it
+            struct Position {
+                uint32_t segment = 0;
+
+                uint32_t offset = 0;
+            };
+
+            // An entry of the time index, all of its records are in one segment
+            struct Block {
+                uint64_t minCreatedAt;
+
+                uint64_t maxCreatedAt;
+
+                uint32_t segment;
+
+                uint32_t offset;
+
+                uint32_t length;
+
+                uint32_t count;
+            };
+
+            // The fields of a message that's being appended
+            struct Fields {
+                GroupMe::ID id;
+
+                uint64_t createdAt = 0;
+
+                GroupMe::ID userID;
+
+                std::string_view name;
+
+                std::string_view avatarURL;
+
+                std::string_view text;
+
+                std::vector<GroupMe::ID> favoritedBy;
+
+                std::vector<GroupMe::MessagePage::AttachmentView> attachments;
+            };
+
+            void openSegments();
+
+            void openTimeIndex();
+
+            void openIDIndex();
+
+            // Checks and indexes the records that the indexes don't cover yet
+            void recover();
+
+            void addSegment();
+
+            bool append(const Fields& fields);
+
+            void encode(const Fields& fields);
+
+            static bool decode(std::string_view payload, Record& record);
+
+            // The record that starts at a position, the payload after the header
+            std::string_view payloadAt(Position position) const;
+
+            std::optional<Position> lookup(const GroupMe::ID& id) const;
+
+            void insert(uint64_t key, Position position);
+
+            void growIDIndex();
+
+            void extendBlock(Position position, uint32_t length, uint64_t createdAt);
+
+            void closeBlock();
+
+            void visitBlock(const Block& block, uint64_t from, uint64_t to, const Visitor& visitor) const;
+
+            std::filesystem::path m_directory;
+
+            Options m_options;
+
+            std::vector<Segment> m_segments;
+
+            File m_idFile;
+
+            Mapping m_ids;
+
+            File m_timeFile;
+
+            std::vector<Block> m_blocks;
+
+            // The block that's being filled, it's only written once it's full
+            Block m_open;
+
+            // Scratch space for encoding records
+            std::string m_buffer;
+    };
+}
@@ -0,0 +1,302 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "Message.h"
+#include "UserSet.hpp"
+#include "IdentityTable.h"
+
+namespace GroupMe {
+    /**
+     * A page owns a single `std::pmr::monotonic_buffer_resource` that holds
+     * a copy of the response body and every string that was decoded out of it.
+     * The messages only hold `std::string_view`'s into that arena, so parsing
+     * a page of 100 messages only takes a handful of allocations and the whole
+     * page is freed at once when it is destroyed.
+     *
+     * The views that are handed out are only valid while the page is alive.
+     * Use `GroupMe::MessagePage::MessageView::toMessage` to get a `GroupMe::Message`
+     * that outlives the page.
+     *
+     * @brief A page of messages that is parsed into an arena
+     *
+     */
+    class MessagePage {
+        public:
+            /**
+             * @brief A read only view over an array in the arena
+             *
+             */
+            template <class T>
+            class Range {
+                public:
+                    Range() :
+                        m_data(nullptr),
+                        m_size(0)
+                    {
+
+                    }
+
+                    Range(const T* data, std::size_t size) :
+                        m_data(data),
+                        m_size(size)
+                    {
+
+                    }
+
+                    const T* begin() const {
+                        return m_data;
+                    }
+
+                    const T* end() const {
+                        return m_data + m_size;
+                    }
+
+                    std::size_t size() const {
+                        return m_size;
+                    }
+
+                    bool empty() const {
+                        return m_size == 0;
+                    }
+
+                    const T& operator[](std::size_t index) const {
+                        return m_data[index];
+                    }
+
+                private:
+                    const T* m_data;
+
+                    std::size_t m_size;
+            };
+
+            /**
+             * @brief An attachment as it was sent, including the types that aren't supported
+             *
+             */
+            struct AttachmentView {
+                std::string_view type;
+
+                std::string_view url;
+
+                std::string_view fileID;
+            };
+
+            /**
+             * @brief A message inside of a `GroupMe::MessagePage`
+             *
+             */
+            class MessageView {
+                public:
+                    /**
+                     * @brief Gets the ID of the message
+                     *
+                     * @return std::string_view
+                     *
+                     */
+                    std::string_view getID() const;
+
+                    /**
+                     * @brief Gets the time the message was created at
+                     *
+                     * @return uint64_t
+                     *
+                     */
+                    uint64_t getCreatedAt() const;
+
+                    /**
+                     * @brief Gets the ID of the user who sent the message
+                     *
+                     * @return std::string_view
+                     *
+                     */
+                    std::string_view getUserID() const;
+
+                    /**
+                     * @brief Gets the handle of the sender in `GroupMe::IdentityTable::global`
+                     *
+                     * @return GroupMe::UserHandle
+                     *
+                     */
+                    GroupMe::UserHandle getSender() const;
+
+                    /**
+                     * @brief Gets the nickname of the user who sent the message
+                     *
+                     * @return std::string_view
+                     *
+                     */
+                    std::string_view getName() const;
+
+                    /**
+                     * @brief Gets the avatar URL of the user who sent the message
+                     *
+                     * @return std::string_view
+                     *
+                     */
+                    std::string_view getAvatarURL() const;
+
+                    /**
+                     * @brief Gets the text of the message
+                     *
+                     * @return std::string_view
+                     *
+                     */
+                    std::string_view getText() const;
+
+                    /**
+                     * @brief Gets the IDs of the users who favorited the message
+                     *
+                     * @return GroupMe::MessagePage::Range<std::string_view>
+                     *
+                     */
+                    Range<std::string_view> getFavoritedBy() const;
+
+                    /**
+                     * @brief Gets the attachments of the message
+                     *
+                     * @return GroupMe::MessagePage::Range<GroupMe::MessagePage::AttachmentView>
+                     *
+                     */
+                    Range<AttachmentView> getAttachments() const;
+
+                    /**
+                     * @brief Copies the message out of the page into a `GroupMe::Message`
+                     *
+                     * @param users The users that are in the group that the message was sent in
+                     *
+                     * @return GroupMe::Message
+                     *
+                     */
+                    GroupMe::Message toMessage(const GroupMe::UserSet& users) const;
+
+                private:
+                    friend class MessagePage;
+
+                    std::string_view m_id;
+
+                    uint64_t m_createdAt = 0;
+
+                    std::string_view m_userID;
+
+                    GroupMe::UserHandle m_sender;
+
+                    std::string_view m_name;
+
+                    std::string_view m_avatarURL;
+
+                    std::string_view m_text;
+
+                    Range<std::string_view> m_favoritedBy;
+
+                    Range<AttachmentView> m_attachments;
+            };
+
+            using const_iterator = std::pmr::vector<MessageView>::const_iterator;
+
+            /**
+             * The body is copied into the arena, so it doesn't have to outlive the page.
+             *
+             * @brief Parses a page of messages from the messages endpoint
+             *
+             * @param body The body of the response, or a bare array of messages
+             *
+             * @return GroupMe::MessagePage
+             *
+             */
+            static MessagePage parse(std::string_view body);
+
+            MessagePage(MessagePage&& other) noexcept = default;
+
+            MessagePage& operator=(MessagePage&& other) noexcept = default;
+
+            MessagePage(const MessagePage& other) = delete;
+
+            MessagePage& operator=(const MessagePage& other) = delete;
+
+            /**
+             * @brief Gets the number of messages in the page
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t size() const;
+
+            /**
+             * @brief Returns whether or not the page has no messages
+             *
+             * @return bool
+             *
+             */
+            bool empty() const;
+
+            const MessageView& operator[](std::size_t index) const;
+
+            const_iterator begin() const;
+
+            const_iterator end() const;
+
+            /**
+             * @brief Gets the response body that the page was parsed from
+             *
+             * @return std::string_view
+             *
+             */
+            std::string_view getBody() const;
+
+            /**
+             * @brief Copies every message out of the page
+             *
+             * @param users The users that are in the group that the messages were sent in
+             *
+             * @return std::vector<GroupMe::Message>
+             *
+             */
+            std::vector<GroupMe::Message> toMessages(const GroupMe::UserSet& users) const;
+
+        private:
+            // Kept behind one pointer so that the arena never moves while the
+            // vector is allocated from it, and so the page is freed in one go
+            struct Storage {
+                explicit Storage(std::size_t initialSize);
+
+                std::pmr::monotonic_buffer_resource arena;
+
+                std::string_view body;
+
+                std::pmr::vector<MessageView> messages;
+            };
+
+            explicit MessagePage(std::size_t bodySize);
+
+            // Copies a string into the arena
+            std::string_view store(std::string_view string);
+
+            std::unique_ptr<Storage> m_storage;
+    };
+}
@@ -0,0 +1,262 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Message.h"
+#include "MessagePage.h"
+#include "IdentityTable.h"
+
+namespace GroupMe {
+    /**
+     * Instead of keeping a `GroupMe::Message` per message, every field is
+     * kept in its own contiguous column:
+     * - `created_at` as 64 bit integers
+     * - The sender as a 32 bit `GroupMe::UserHandle`
+     * - The IDs and texts as offsets into two blobs
+     * - The kinds of attachments as a bitmask
+     *
+     * Scans only touch the columns they filter on, and the predicates are
+     * written as branchless loops over plain arrays so the compiler can
+     * vectorize them. This keeps analytics over a whole history bound by
+     * memory bandwidth instead of chasing pointers.
+     *
+     * For example:
+     * `store.scan().between(from, to).sentBy(handle).count();`
+     *
+     * This class isn't synchronized, just like the standard containers.
+     *
+     * @brief A columnar store for large message histories
+     *
+     */
+    class MessageStore {
+        public:
+            /**
+             * @brief Bits of the attachment kind column
+             *
+             */
+            enum AttachmentKind : uint8_t {
+                Picture = 1 << 0,
+                Video = 1 << 1,
+                File = 1 << 2,
+                // Anything else, like mentions or locations
+                Other = 1 << 3
+            };
+
+            /**
+             * Every filter narrows the rows down further, so they combine like AND.
+             *
+             * @brief A scan over a `GroupMe::MessageStore`
+             *
+             */
+            class Scan {
+                public:
+                    /**
+                     * @brief Keeps the messages created in `[from, to)`
+                     *
+                     * @param from The first time to keep
+                     * @param to The first time after the range
+                     *
+                     * @return GroupMe::MessageStore::Scan&
+                     *
+                     */
+                    Scan& between(uint64_t from, uint64_t to);
+
+                    /**
+                     * @brief Keeps the messages sent by a user
+                     *
+                     * @param sender The handle of the user
+                     *
+                     * @return GroupMe::MessageStore::Scan&
+                     *
+                     */
+                    Scan& sentBy(GroupMe::UserHandle sender);
+
+                    /**
+                     * @brief Keeps the messages that have any of the attachment kinds
+                     *
+                     * @param kinds A mask of `GroupMe::MessageStore::AttachmentKind`
+                     *
+                     * @return GroupMe::MessageStore::Scan&
+                     *
+                     */
+                    Scan& withAttachments(uint8_t kinds);
+
+                    /**
+                     * @brief Counts the messages that are left
+                     *
+                     * @return std::size_t
+                     *
+                     */
+                    std::size_t count() const;
+
+                    /**
+                     * @brief Gets the rows of the messages that are left, in order
+                     *
+                     * @return std::vector<std::size_t>
+                     *
+                     */
+                    std::vector<std::size_t> rows() const;
+
+                private:
+                    friend class MessageStore;
+
+                    explicit Scan(const MessageStore& store);
+
+                    const MessageStore& m_store;
+
+                    // One byte per row, 1 if it's still selected. Bytes
+                    // vectorize a lot better than a bitset
+                    std::vector<uint8_t> m_selected;
+            };
+
+            MessageStore() = default;
+
+            /**
+             * @brief Reserves room for a number of messages
+             *
+             * @param messages The number of messages
+             * @param textBytes The total length of their texts
+             *
+             */
+            void reserve(std::size_t messages, std::size_t textBytes = 0);
+
+            /**
+             * @brief Appends a message
+             *
+             * @param message The message to append
+             *
+             */
+            void append(const GroupMe::Message& message);
+
+            /**
+             * @brief Appends every message of a page
+             *
+             * @param page The page to append
+             *
+             */
+            void append(const GroupMe::MessagePage& page);
+
+            /**
+             * @brief Gets the number of messages in the store
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t size() const;
+
+            /**
+             * @brief Starts a scan over every message in the store
+             *
+             * @return GroupMe::MessageStore::Scan
+             *
+             */
+            Scan scan() const;
+
+            /**
+             * @brief Gets the ID of a message
+             *
+             * @param row The row of the message
+             *
+             * @return std::string_view
+             *
+             */
+            std::string_view getID(std::size_t row) const;
+
+            /**
+             * @brief Gets the time a message was created at
+             *
+             * @param row The row of the message
+             *
+             * @return uint64_t
+             *
+             */
+            uint64_t getCreatedAt(std::size_t row) const;
+
+            /**
+             * @brief Gets the sender of a message
+             *
+             * @param row The row of the message
+             *
+             * @return GroupMe::UserHandle
+             *
+             */
+            GroupMe::UserHandle getSender(std::size_t row) const;
+
+            /**
+             * @brief Gets the text of a message
+             *
+             * @param row The row of the message
+             *
+             * @return std::string_view
+             *
+             */
+            std::string_view getText(std::size_t row) const;
+
+            /**
+             * @brief Gets the kinds of attachments a message has
+             *
+             * @param row The row of the message
+             *
+             * @return uint8_t A mask of `GroupMe::MessageStore::AttachmentKind`
+             *
+             */
+            uint8_t getAttachmentKinds(std::size_t row) const;
+
+            /**
+             * @brief Gets the whole `created_at` column
+             *
+             * @return const std::vector<uint64_t>&
+             *
+             */
+            const std::vector<uint64_t>& getCreatedAtColumn() const;
+
+            /**
+             * @brief Gets the whole sender column, as `GroupMe::UserHandle` values
+             *
+             * @return const std::vector<uint32_t>&
+             *
+             */
+            const std::vector<uint32_t>& getSenderColumn() const;
+
+        private:
+            void append(std::string_view id, uint64_t createdAt, GroupMe::UserHandle sender, std::string_view text, uint8_t attachmentKinds);
+
+            std::vector<uint64_t> m_createdAt;
+
+            std::vector<uint32_t> m_senders;
+
+            std::vector<uint8_t> m_attachmentKinds;
+
+            // Row `i` is `[offsets[i], offsets[i + 1])` of the blob
+            std::vector<uint64_t> m_idOffsets = {0};
+
+            std::string m_ids;
+
+            std::vector<uint64_t> m_textOffsets = {0};
+
+            std::string m_texts;
+    };
+}
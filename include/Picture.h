@@ -26,9 +26,13 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <atomic>
+#include <memory>
 #include <nlohmann/json.hpp>
 
 #include "Attachment.h"
+#include "util/Executors.h"
+#include "util/Cancellation.h"
 
 namespace GroupMe {
     //TODO Add a constructor to upload as with a `std::vector<unsigned char>`
@@ -70,13 +74,21 @@ namespace GroupMe {
 
             Picture(const Picture& other);
 
-            Picture(Picture&& other) = delete;
+            Picture(Picture&& other) noexcept = default;
 
-            ~Picture();
+            /**
+             * This never waits for anything that is running for the picture.
+             * If this is the last copy of the picture and it hasn't been
+             * uploaded, the preparation of the picture is cancelled.
+             *
+             * @brief The destructor
+             *
+             */
+            ~Picture() override;
 
             Picture& operator=(const Picture& other);
 
-            Picture& operator=(Picture&& other) = delete;
+            Picture& operator=(Picture&& other) noexcept;
 
             /**
              * This member function will upload the picture to the GroupMe
@@ -90,21 +102,62 @@ namespace GroupMe {
              *
              * @brief Uploads the picture to the server
              *
+             * @param token A token that can be used to cancel the upload
+             * @param deadline The point in time the upload is cancelled at if it hasn't finished
+             *
              * @return pplx::task<std::string>
              *
              */
-            pplx::task<std::string> upload();
+            pplx::task<std::string> upload(const pplx::cancellation_token& token = pplx::cancellation_token::none(), const Util::Deadline& deadline = Util::Deadline::none());
+
+            /**
+             * This aborts any requests that are in flight for this picture,
+             * including the download of the picture if it was created from
+             * a URL. Tasks that were cancelled will throw `pplx::task_canceled`
+             * when `.get()` is called. The picture can't be uploaded after this.
+             *
+             * @brief Cancels everything that is running for this picture
+             *
+             */
+            void cancel();
 
         private:
-            web::http::http_request m_request;
-            
-            web::http::client::http_client m_client;
-            
-            nlohmann::json m_json;
+            // Everything the tasks use lives in here so that the tasks can
+            // own it. That lets the picture be moved or destroyed without
+            // waiting for them.
+            struct State {
+                explicit State(const web::uri& endpoint);
+
+                web::http::http_request request;
+
+                web::http::client::http_client client;
+
+                std::vector<unsigned char> contentBinary;
+
+                // The content of the picture, shared with every copy of it
+                std::shared_ptr<Attachment::Content> content;
+
+                pplx::task<void> task;
+
+                pplx::cancellation_token_source cancellation;
+
+                // Copies of the picture and uploads that haven't finished. Once
+                // none are left nothing can use the preparation anymore.
+                std::atomic<std::size_t> owners;
+
+                pplx::cancellation_token_source preparation;
+            };
+
+            // Adds this copy as an owner of the state
+            void acquire();
+
+            // Cancels the preparation if this is the last copy
+            void release();
 
-            std::fstream m_file;
+            // Drops an owner, the last one cancels the preparation and frees its buffers
+            static void release(const std::shared_ptr<State>& state);
 
-            pplx::task<void> m_task;
+            std::shared_ptr<State> m_state;
     };
 
 }
@@ -21,9 +21,13 @@
 #include <cstdio>
 #include <cstdlib>
 #include <string>
+#include <chrono>
 #include <algorithm>
 #include <mutex>
 #include <utility>
+#include <memory>
+#include <functional>
+#include <string_view>
 
 #include <cpprest/http_client.h>
 #include <cpprest/http_headers.h>
@@ -32,6 +36,13 @@
 
 #include "User.h"
 #include "UserSet.hpp"
+#include "ContactRegistry.h"
+#include "util/Executors.h"
+#include "util/Cancellation.h"
+
+namespace GroupMe::Util::Json {
+    class Value;
+}
 
 namespace GroupMe {
     /**
@@ -39,6 +50,11 @@ namespace GroupMe {
      * access token, phone number, etc. like the  `GroupMe::User` class, but has the ability to upload and download
      * this data to the server using the API
      *
+     * The getters read an immutable `GroupMe::UserRecord` that is swapped
+     * whenever the profile changes, so they never wait behind a push or
+     * pull. `getRecord()` gives every field of one version of the profile
+     * without copying.
+     *
      * @brief Class used to represent the current authenticated user
      *
      */
@@ -55,11 +71,20 @@ namespace GroupMe {
 
             Self(const Self& other) = delete;
 
-            Self(Self&& other) = delete;
+            /**
+             * Tasks that are still running for `other` will update this
+             * object once they finish.
+             *
+             * @brief Move constructor
+             *
+             */
+            Self(Self&& other) noexcept;
 
             /**
-             * Makes sure to wait for all of the concurrent tasks to finish
-             * before moving on.
+             * Cancels anything that is still in flight. This never waits for
+             * the network, tasks that are still running just won't update
+             * the user anymore. Changes that are still waiting for a debounced
+             * push are sent in one last push, after any push that is running.
              *
              * @brief The destructor
              *
@@ -68,23 +93,67 @@ namespace GroupMe {
 
             Self& operator=(const Self&) = delete;
 
-            Self& operator=(Self&&) = delete;
+            Self& operator=(Self&& other) noexcept;
 
             /**
-             * @brief Pushes all of the user data to the server
+             * Only the fields that were changed by a setter since the last
+             * push or pull are sent. If nothing changed, no request is made
+             * and the task finishes with `web::http::status_codes::OK`. When
+             * the push fails, the fields are sent again by the next one.
+             *
+             * @brief Pushes the changed user data to the server
+             *
+             * @param token A token that can be used to cancel the push
+             * @param deadline The point in time the push is cancelled at if it hasn't finished
              *
              * @return pplx::task<web::http::status_code>
              *
              */
-            pplx::task<web::http::status_code> push();
+            pplx::task<web::http::status_code> push(const pplx::cancellation_token& token = pplx::cancellation_token::none(), const Util::Deadline& deadline = Util::Deadline::none());
 
             /**
              * @brief Pulls user data from the server
              *
+             * @param token A token that can be used to cancel the pull
+             * @param deadline The point in time the pull is cancelled at if it hasn't finished
+             *
              * @return pplx::task<web::http::status_code>
              *
              */
-            pplx::task<web::http::status_code> pull();
+            pplx::task<web::http::status_code> pull(const pplx::cancellation_token& token = pplx::cancellation_token::none(), const Util::Deadline& deadline = Util::Deadline::none());
+
+            /**
+             * This aborts every request that is in flight for this user. Tasks
+             * that were cancelled will throw `pplx::task_canceled` when `.get()`
+             * is called. Nothing can be pushed or pulled after this.
+             *
+             * @brief Cancels everything that is running for this user
+             *
+             */
+            void cancel();
+
+            /**
+             * When this is set, every change made by a setter waits until
+             * there haven't been any changes for `debounce`, and then all of
+             * them are pushed in a single request. Errors from those pushes
+             * are dropped, the fields stay changed until a push succeeds.
+             * Changes that are waiting when the user is destroyed are pushed
+             * right away.
+             *
+             * @brief Pushes bursts of changes on their own, as a single request
+             *
+             * @param debounce How long to wait after the last change, zero turns it off
+             *
+             */
+            void setPushDebounce(std::chrono::milliseconds debounce);
+
+            /**
+             * @brief Returns whether there are changes that haven't been pushed yet
+             *
+             * @return bool
+             *
+             */
+            bool hasUnpushedChanges() const;
 
             /**
              * @brief Gets the nickname of the authenticated user
@@ -218,24 +287,138 @@ namespace GroupMe {
             void setTwitterConnected(bool twitterConnected);
 
             /**
-             * @brief Adds a contact to the contacts contacts set
+             * @brief Gets the ID of the authenticated user
+             *
+             * @return std::string
+             *
+             */
+            std::string getID() const;
+
+            /**
+             * @brief Sets the ID of the authenticated user, this is never pushed
+             *
+             * @param userID The new ID to set
+             *
+             */
+            void setID(const std::string& userID);
+
+            /**
+             * @brief Gets the GUID of the authenticated user
+             *
+             * @return std::string
+             *
+             */
+            std::string getGUID() const;
+
+            /**
+             * @brief Sets the GUID of the authenticated user, this is never pushed
+             *
+             * @param userGUID The new GUID to set
+             *
+             */
+            void setGUID(const std::string& userGUID);
+
+            /**
+             * @brief Gets the locale of the authenticated user
+             *
+             * @return std::string
+             *
+             */
+            std::string getLocale() const;
+
+            /**
+             * @brief Sets the locale of the authenticated user
+             *
+             * @param locale The new locale to set
+             *
+             */
+            void setLocal(const std::string& locale);
+
+            /**
+             * @brief Gets the share URL of the authenticated user
+             *
+             * @return std::string
+             *
+             */
+            std::string getShareURL() const;
+
+            /**
+             * @brief Sets the share URL of the authenticated user, this is never pushed
+             *
+             * @param shareURL The new share URL to set
+             *
+             */
+            void setShareURL(const std::string& shareURL);
+
+            /**
+             * @brief Gets the QR Code share URL of the authenticated user
+             *
+             * @return std::string
+             *
+             */
+            std::string getShareQRCodeURL() const;
+
+            /**
+             * @brief Sets the QR Code share URL of the authenticated user, this is never pushed
+             *
+             * @param shareQRCodeURL The new QR Code share URL to set
+             *
+             */
+            void setShareQRCodeURL(const std::string& shareQRCodeURL);
+
+            /**
+             * @brief Gets the time the account was created at
+             *
+             * @return unsigned int
+             *
+             */
+            unsigned int getCreatedAt() const;
+
+            /**
+             * @brief Sets the time the account was created at, this is never pushed
+             *
+             * @param createdAt The new time to set
+             *
+             */
+            void setCreatedAt(unsigned int createdAt);
+
+            /**
+             * @brief Gets the time the account was last updated at
+             *
+             * @return unsigned int
+             *
+             */
+            unsigned int getUpdatedAt() const;
+
+            /**
+             * @brief Sets the time the account was last updated at, this is never pushed
+             *
+             * @param updatedAt The new time to set
+             *
+             */
+            void setUpdatedAt(unsigned int updatedAt);
+
+            /**
+             * The contacts can be used from any thread, see `GroupMe::ContactRegistry`.
+             *
+             * @brief Adds a contact to the contacts set
              *
              * @param contact The new contact to add as a `std::shared_ptr<GroupMe::User>`
              *
-             * @return std::pair<GroupMe::UserSet::iterator, bool> This is the same return value as the single insertion for std::set
+             * @return bool Whether the contact was added, false if there already was a contact with its ID
              *
              */
-            std::pair<GroupMe::UserSet::const_iterator, bool> addContact(const std::shared_ptr<GroupMe::User>& contact);
+            bool addContact(const std::shared_ptr<GroupMe::User>& contact);
 
             /**
              * @brief Finds a contact from the contacts set
              * 
              * @param userID The ID of the user to search for
              *
-             * @return A const_iterator to the contact if found, or past-the-end iterator is returned
+             * @return std::shared_ptr<const GroupMe::User> The contact if found, or `nullptr`
              *
              */
-            GroupMe::UserSet::const_iterator findContact(const std::string& userID) const;
+            std::shared_ptr<const GroupMe::User> findContact(std::string_view userID) const;
 
             /**
              * @brief Merges the two UserSets
@@ -246,19 +429,89 @@ namespace GroupMe {
              *
              */
             void mergeContacts(UserSet& set);
+
+            /**
+             * @brief Makes any number of changes to the contacts in a single update
+             *
+             * @param update Called with a copy of the contacts, which replaces them once it returns. Users are replaced, never changed
+             *
+             */
+            void updateContacts(const std::function<void(GroupMe::UserSet&)>& update);
+
+            /**
+             * @brief Replaces all of the contacts, like after fetching them again
+             *
+             * @param contacts The new contacts
+             *
+             * @return GroupMe::UserSet::Diff The contacts that were added, removed and changed
+             *
+             */
+            GroupMe::UserSet::Diff replaceContacts(GroupMe::UserSet contacts);
+
+            /**
+             * @brief Gets the contacts as they are right now
+             *
+             * @return std::shared_ptr<const GroupMe::UserSet> A set that won't change, even if contacts are added
+             *
+             */
+            std::shared_ptr<const GroupMe::UserSet> getContacts() const;
         private:
-            std::string m_accessToken;
+            // Everything the tasks use lives in here so that the tasks can
+            // own it. The tasks only touch the user through `self`, which
+            // is cleared when the user is destroyed and updated when it's moved.
+            struct State {
+                std::string accessToken;
+
+                pplx::task<void> task;
+
+                pplx::cancellation_token_source cancellation;
+
+                // Needed because we have variables that are read and written
+                // to in another thread
+                std::mutex mutex;
+
+                Self* self = nullptr;
+
+                // Bit `i` is set when `User::Schema::profile[i]` changed
+                // since the last push or pull
+                uint64_t dirty = 0;
+
+                // The fields of pushes that haven't been answered yet. A pull
+                // can't tell if the server already has them, so it keeps ours
+                uint64_t pushing = 0;
+
+                std::chrono::milliseconds debounce{0};
+
+                Util::Deadline::Clock::time_point lastChange;
+
+                // Whether a debounced push is waiting on the timer
+                bool debouncing = false;
+            };
+
+            // Pushes the dirty fields after everything in `state->task`
+            static pplx::task<web::http::status_code> pushState(const std::shared_ptr<State>& state, const pplx::cancellation_token& token, const Util::Deadline& deadline);
+
+            // Sends a profile body for the `sent` fields, which have to be in `state->pushing`
+            static pplx::task<web::http::status_code> sendProfile(const std::shared_ptr<State>& state, std::string body, uint64_t sent, const pplx::cancellation_token& token);
+
+            // Pushes once there haven't been any changes for the debounce window
+            static void debouncePush(const std::weak_ptr<State>& weak, Util::Deadline::Clock::time_point time);
 
-            web::http::http_request m_request;
+            // Sets a member and marks `bit` dirty if the value changed, a
+            // `bit` of zero only publishes the record
+            template <class T>
+            void change(T& member, const T& value, uint64_t bit);
 
-            web::http::client::http_client m_client;
+            // Stops the tasks from touching this user anymore
+            void detach();
 
-            pplx::task<void> m_task;
+            // Reads the `response` object of the users/me endpoint,
+            // `m_state->mutex` must be held. Fields that changed since the
+            // last push, or that are being pushed, keep the local value
+            void readProfile(GroupMe::Util::Json::Value& response);
 
-            GroupMe::UserSet m_contacts;
+            std::shared_ptr<State> m_state;
 
-            // Needed because we have variables that are read and written
-            // to in another thread
-            mutable std::mutex m_mutex;
+            GroupMe::ContactRegistry m_contacts;
     };
 }
@@ -0,0 +1,345 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <queue>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <cpprest/http_client.h>
+#include <pplx/pplxtasks.h>
+
+#include "ID.h"
+#include "MessagePage.h"
+#include "util/Cancellation.h"
+#include "util/Limiter.h"
+
+namespace GroupMe {
+    /**
+     * Every group has a watermark, the ID of the newest message that was
+     * handed to the sink, and is polled for the messages after it. Groups
+     * are kept in a priority queue by when they are due next, so thousands
+     * of groups only need one timer.
+     *
+     * The interval of a group adapts to its traffic. A poll that finds new
+     * messages divides it by the backoff factor, down to the minimum, and a
+     * poll that finds nothing multiplies it, up to the maximum. A full page
+     * means the group is behind, so it's polled again right away. Busy groups
+     * are polled often and idle ones barely at all, so the number of requests
+     * follows the number of messages instead of the number of groups.
+     *
+     * The watermarks can be saved to a file and loaded back, so a restart
+     * picks up where it left off.
+     *
+     * @brief Keeps the newest messages of many groups in sync
+     *
+     */
+    class TailSync {
+        public:
+            /**
+             * Pages of one group are handed over oldest first and one at a
+             * time, but pages of different groups can be handed over at once.
+             * If the sink throws, the watermark isn't moved and the page is
+             * fetched again on the next poll.
+             *
+             * @brief Receives the new messages of a group
+             *
+             */
+            using Sink = std::function<void(const GroupMe::ID& group, const GroupMe::MessagePage& page)>;
+
+            /**
+             * @brief How a `GroupMe::TailSync` polls
+             *
+             */
+            struct Options {
+                /**
+                 * @brief The shortest a group waits between polls
+                 *
+                 */
+                std::chrono::milliseconds minInterval = std::chrono::seconds(2);
+
+                /**
+                 * @brief The longest a group waits between polls
+                 *
+                 */
+                std::chrono::milliseconds maxInterval = std::chrono::minutes(5);
+
+                /**
+                 * @brief How much the interval is divided or multiplied by after every poll
+                 *
+                 */
+                double backoff = 2.0;
+
+                /**
+                 * @brief The number of requests that are in flight at once, across every group
+                 *
+                 */
+                std::size_t concurrency = 8;
+            };
+
+            /**
+             * @brief How many requests a `GroupMe::TailSync` made and what they found
+             *
+             */
+            struct Stats {
+                uint64_t requests = 0;
+
+                // Requests that found no new messages
+                uint64_t idle = 0;
+
+                uint64_t messages = 0;
+            };
+
+            /**
+             * Nothing is polled until `start` is called.
+             *
+             * @brief Constructs a new `GroupMe::TailSync` object with the default options
+             *
+             * @param accessToken The users access token
+             * @param sink Receives the new messages
+             *
+             */
+            TailSync(const std::string& accessToken, Sink sink);
+
+            /**
+             * Nothing is polled until `start` is called.
+             *
+             * @brief Constructs a new `GroupMe::TailSync` object
+             *
+             * @param accessToken The users access token
+             * @param sink Receives the new messages
+             * @param options How to poll
+             *
+             */
+            TailSync(const std::string& accessToken, Sink sink, const Options& options);
+
+            TailSync(const TailSync& other) = delete;
+
+            TailSync(TailSync&& other) noexcept = default;
+
+            /**
+             * @brief The destructor, stops polling
+             *
+             */
+            ~TailSync();
+
+            TailSync& operator=(const TailSync& other) = delete;
+
+            TailSync& operator=(TailSync&& other) noexcept = default;
+
+            /**
+             * A group without a watermark starts at its newest page. A group
+             * that is already tracked keeps its watermark.
+             *
+             * @brief Starts tracking a group, it's due right away
+             *
+             * @param group The ID of the group
+             * @param watermark The ID of the newest message that was already seen
+             *
+             */
+            void add(const GroupMe::ID& group, const GroupMe::ID& watermark = GroupMe::ID());
+
+            /**
+             * A poll that is already running for the group still finishes.
+             * If the group is added back before then, it's polled again once
+             * that poll is done, never alongside it.
+             *
+             * @brief Stops tracking a group
+             *
+             * @param group The ID of the group
+             *
+             * @return bool `false` if the group wasn't tracked
+             *
+             */
+            bool remove(const GroupMe::ID& group);
+
+            /**
+             * This should be called when something hints that a group has
+             * new messages, like a push notification.
+             *
+             * @brief Makes a group due right away
+             *
+             * @param group The ID of the group
+             *
+             */
+            void nudge(const GroupMe::ID& group);
+
+            /**
+             * @brief Starts polling
+             *
+             */
+            void start();
+
+            /**
+             * Polls that are in flight are cancelled.
+             *
+             * @brief Stops polling
+             *
+             */
+            void stop();
+
+            /**
+             * @brief Gets the watermark of a group
+             *
+             * @param group The ID of the group
+             *
+             * @return GroupMe::ID An empty ID if the group isn't tracked or hasn't been polled
+             *
+             */
+            GroupMe::ID getWatermark(const GroupMe::ID& group) const;
+
+            /**
+             * @brief Gets the current polling interval of a group
+             *
+             * @param group The ID of the group
+             *
+             * @return std::chrono::milliseconds Zero if the group isn't tracked
+             *
+             */
+            std::chrono::milliseconds getInterval(const GroupMe::ID& group) const;
+
+            /**
+             * @brief Gets the number of groups that are tracked
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t size() const;
+
+            Stats getStats() const;
+
+            /**
+             * The file is written next to the path and renamed over it, so
+             * it's never left half written.
+             *
+             * @brief Saves the watermarks of every group
+             *
+             * @param path The file to save to
+             *
+             */
+            void saveWatermarks(const std::filesystem::path& path) const;
+
+            /**
+             * Groups in the file that aren't tracked yet start being tracked.
+             *
+             * @brief Loads watermarks that were saved with `saveWatermarks`
+             *
+             * @param path The file to load from
+             *
+             * @return bool `false` if the file doesn't exist
+             *
+             */
+            bool loadWatermarks(const std::filesystem::path& path);
+
+        private:
+            struct Conversation {
+                GroupMe::ID watermark;
+
+                std::chrono::milliseconds interval;
+
+                // Bumped whenever the group is queued, so older queue entries are skipped
+                uint64_t generation = 0;
+
+                // Set when the group is nudged while it's being polled
+                bool nudged = false;
+            };
+
+            struct Due {
+                Util::Deadline::Clock::time_point time;
+
+                GroupMe::ID group;
+
+                uint64_t generation;
+
+                // Makes `std::priority_queue` a min heap
+                friend bool operator<(const Due& lhs, const Due& rhs) {
+                    return lhs.time > rhs.time;
+                }
+            };
+
+            // Everything the tasks and the timer use lives in here so that they can own it
+            struct State {
+                State();
+
+                std::string accessToken;
+
+                // Every poll goes through the same client so connections are reused
+                web::http::client::http_client client;
+
+                Sink sink;
+
+                Options options;
+
+                std::shared_ptr<Util::Limiter> limiter;
+
+                std::atomic<uint64_t> requests{0};
+
+                std::atomic<uint64_t> idle{0};
+
+                std::atomic<uint64_t> messages{0};
+
+                // Guards everything below
+                mutable std::mutex mutex;
+
+                pplx::cancellation_token_source cancellation;
+
+                bool running = false;
+
+                std::unordered_map<GroupMe::ID, Conversation> conversations;
+
+                // Groups that have a poll running. This outlives the group's
+                // conversation, so a group that is removed and added back while
+                // it's polled still isn't polled twice at once.
+                std::unordered_set<GroupMe::ID> polling;
+
+                std::priority_queue<Due> queue;
+
+                // The earliest time the timer is set for, if it is set
+                Util::Deadline::Clock::time_point armedAt;
+
+                bool armed = false;
+            };
+
+            // Expects `state->mutex` to be held
+            static void enqueue(const std::shared_ptr<State>& state, const GroupMe::ID& group, Conversation& conversation, Util::Deadline::Clock::time_point time);
+
+            // Expects `state->mutex` to be held, sets the timer for the next group that is due
+            static void arm(const std::shared_ptr<State>& state);
+
+            // Polls every group that is due
+            static void pump(const std::shared_ptr<State>& state);
+
+            static void poll(const std::shared_ptr<State>& state, const GroupMe::ID& group, const GroupMe::ID& watermark, const pplx::cancellation_token& token);
+
+            // Moves the watermark and picks the next interval once a poll is done
+            static void finish(const std::shared_ptr<State>& state, const GroupMe::ID& group, const GroupMe::ID& newest, std::size_t messages, bool succeeded);
+
+            std::shared_ptr<State> m_state;
+    };
+}
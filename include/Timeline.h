@@ -0,0 +1,233 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <iterator>
+
+#include "Message.h"
+#include "util/Epoch.h"
+
+namespace GroupMe {
+    /**
+     * Messages are stored in fixed size segments that are linked together.
+     * A message is built in its slot before the size of the timeline is
+     * published with release semantics, so a reader that loads the size
+     * with acquire semantics sees every message before it fully built, and
+     * never takes a lock. Messages never change once they're published.
+     *
+     * Only the newest messages are kept. Once a whole segment is older than
+     * the retention it's unlinked and retired with `GroupMe::Util::Epoch`,
+     * so it's only freed once no reader can still be looking at it.
+     *
+     * Writers take a lock between each other, but never wait for readers.
+     *
+     * For example:
+     * `for (const GroupMe::Message& message : timeline.recent(50)) { ... }`
+     *
+     * @brief An append only timeline of a conversation that can be read while it's written
+     *
+     */
+    class Timeline {
+        private:
+            struct Segment;
+
+        public:
+            /**
+             * @brief The number of messages in every segment
+             *
+             */
+            static constexpr std::size_t s_segmentSize = 256;
+
+            /**
+             * Holding a view keeps the calling thread pinned, so segments
+             * that are retired in the meantime aren't freed until it's
+             * destroyed. Views should be short lived, must be destroyed
+             * on the thread that made them, and can't outlive the timeline.
+             *
+             * @brief A snapshot of a range of a `GroupMe::Timeline`
+             *
+             */
+            class View {
+                public:
+                    class const_iterator {
+                        public:
+                            using iterator_category = std::forward_iterator_tag;
+                            using value_type = GroupMe::Message;
+                            using difference_type = std::ptrdiff_t;
+                            using pointer = const GroupMe::Message*;
+                            using reference = const GroupMe::Message&;
+
+                            const_iterator();
+
+                            reference operator*() const;
+
+                            pointer operator->() const;
+
+                            const_iterator& operator++();
+
+                            const_iterator operator++(int);
+
+                            /**
+                             * @brief Gets the position of the message in the timeline
+                             *
+                             * @return uint64_t
+                             *
+                             */
+                            uint64_t index() const;
+
+                            friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) {
+                                return lhs.m_index == rhs.m_index;
+                            }
+
+                            friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) {
+                                return lhs.m_index != rhs.m_index;
+                            }
+
+                        private:
+                            friend class View;
+
+                            const_iterator(const Segment* segment, uint64_t index);
+
+                            const Segment* m_segment;
+
+                            uint64_t m_index;
+                    };
+
+                    const_iterator begin() const;
+
+                    const_iterator end() const;
+
+                    /**
+                     * @brief Gets the number of messages in the view
+                     *
+                     * @return std::size_t
+                     *
+                     */
+                    std::size_t size() const;
+
+                    bool empty() const;
+
+                private:
+                    friend class Timeline;
+
+                    View(GroupMe::Util::Epoch::Guard guard, const Segment* segment, uint64_t begin, uint64_t end);
+
+                    GroupMe::Util::Epoch::Guard m_guard;
+
+                    // The segment that holds `m_begin`
+                    const Segment* m_segment;
+
+                    uint64_t m_begin;
+
+                    uint64_t m_end;
+            };
+
+            /**
+             * @brief Constructs an empty `GroupMe::Timeline`
+             *
+             * @param retain The number of newest messages that are kept at least
+             *
+             */
+            explicit Timeline(std::size_t retain = 4096);
+
+            Timeline(const Timeline& other) = delete;
+
+            Timeline& operator=(const Timeline& other) = delete;
+
+            /**
+             * No reader can be using the timeline when it's destroyed.
+             *
+             * @brief The destructor
+             *
+             */
+            ~Timeline();
+
+            /**
+             * @brief Appends a message
+             *
+             * @param message The message to append
+             *
+             * @return uint64_t The position of the message in the timeline
+             *
+             */
+            uint64_t append(GroupMe::Message message);
+
+            /**
+             * The messages are published at once, so a reader sees either
+             * none or all of them.
+             *
+             * @brief Appends many messages
+             *
+             * @param messages The messages to append, in order
+             *
+             * @return uint64_t The position of the first message in the timeline
+             *
+             */
+            uint64_t append(std::vector<GroupMe::Message> messages);
+
+            /**
+             * @brief Gets a view of every message that is still kept
+             *
+             * @return GroupMe::Timeline::View
+             *
+             */
+            View view() const;
+
+            /**
+             * @brief Gets a view of the newest messages
+             *
+             * @param count The most messages to view
+             *
+             * @return GroupMe::Timeline::View
+             *
+             */
+            View recent(std::size_t count) const;
+
+            /**
+             * @brief Gets the number of messages that were ever appended
+             *
+             * @return uint64_t
+             *
+             */
+            uint64_t size() const;
+
+        private:
+            // Builds a message in the next slot without publishing it, expects `m_writer` to be held
+            void emplace(GroupMe::Message&& message, uint64_t index);
+
+            // Retires the segments that are older than the retention, expects `m_writer` to be held
+            void trim();
+
+            std::size_t m_retain;
+
+            std::atomic<Segment*> m_head;
+
+            // Only used by writers
+            Segment* m_tail;
+
+            std::atomic<uint64_t> m_size;
+
+            std::mutex m_writer;
+    };
+}
@@ -21,8 +21,13 @@
 #include <cstdio>
 #include <cstdlib>
 #include <string>
+#include <array>
 #include <memory>
 
+#include "ID.h"
+#include "UserRecord.h"
+#include "util/Fields.h"
+
 namespace GroupMe {
     /**
      * This class holds user data for any generic user, such as the nickname,
@@ -77,6 +82,14 @@ namespace GroupMe {
              */
             void setID(const std::string& userID);
 
+            /**
+             * @brief Gets the users ID without converting it to a string
+             *
+             * @return const GroupMe::ID&
+             *
+             */
+            const GroupMe::ID& getCompactID() const;
+
             /**
              * @brief Gets the users nickname
              *
@@ -303,17 +316,49 @@ namespace GroupMe {
              */
             void setTwitterConnected(bool twitterConnected);
 
+            /**
+             * The record is made the first time this is called after the
+             * user changes, and is shared until the user changes again.
+             *
+             * @brief Gets an immutable snapshot of the user
+             *
+             * @return std::shared_ptr<const GroupMe::UserRecord>
+             *
+             */
+            std::shared_ptr<const GroupMe::UserRecord> getRecord() const;
+
+            /**
+             * The fingerprint comes from the record, so it's only worked
+             * out again after the user changes.
+             *
+             * @brief Gets a fingerprint of the fields that `operator==` compares
+             *
+             * @return uint64_t
+             *
+             */
+            uint64_t getFingerprint() const;
+
             bool operator==(const User& user) const;
 
             bool operator!=(const User& user) const;
 
+            // The JSON representations of a user, defined below
+            struct Schema;
+
         protected:
-            
+            // Anything that writes the members directly instead of through
+            // a setter has to call this so a new record gets made
+            void invalidateRecord();
+
+            // Makes the record right away, for owners that can't let
+            // `getRecord` read the members while they're being written
+            void publishRecord();
+
             /**
              * @brief The users ID
              *
              */
-            std::string m_userID;
+            GroupMe::ID m_userID;
 
             /**
              * @brief The users name/nickname
@@ -398,5 +443,51 @@ namespace GroupMe {
              *
              */
             bool m_isTwitterConnected;
+
+        private:
+            friend class GroupMe::UserRecord;
+
+            // Only accessed with the atomic shared_ptr functions, since
+            // `getRecord` is const and can be called from any thread
+            mutable std::shared_ptr<const GroupMe::UserRecord> m_record;
+    };
+
+    /**
+     * @brief The tables that map the JSON keys of a user to its members
+     *
+     */
+    struct User::Schema {
+        using Field = Util::Field<User>;
+
+        /**
+         * @brief The profile from the `users/me` endpoint, the writable fields are what `users/update` takes
+         *
+         */
+        static constexpr std::array<Field, 14> profile = {{
+            {"id", &User::m_userID, Field::Read},
+            {"name", &User::m_userNickname},
+            {"image_url", &User::m_userProfileImageURL},
+            {"phone_number", &User::m_userPhoneNumber},
+            {"email", &User::m_userEmail},
+            {"locale", &User::m_locale},
+            {"zip_code", &User::m_zipcode},
+            {"sms", &User::m_isSMS},
+            {"facebook_connected", &User::m_isFacebookConnected},
+            {"twitter_connected", &User::m_isTwitterConnected},
+            {"share_url", &User::m_shareURL, Field::Read},
+            {"share_qr_code_url", &User::m_shareQRCodeURL, Field::Read},
+            {"created_at", &User::m_createdAt, Field::Read},
+            {"updated_at", &User::m_updatedAt, Field::Read}
+        }};
+
+        /**
+         * @brief A user in the `members` of a group
+         *
+         */
+        static constexpr std::array<Field, 3> member = {{
+            {"user_id", &User::m_userID},
+            {"nickname", &User::m_userNickname},
+            {"image_url", &User::m_userProfileImageURL}
+        }};
     };
 }
@@ -0,0 +1,143 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <array>
+#include <string>
+#include <string_view>
+
+#include "ID.h"
+
+namespace GroupMe {
+    class User;
+
+    /**
+     * A record is made from a `GroupMe::User` and never changes after
+     * that, so it can be shared by pointer between threads, messages and
+     * sets of users without copying or locking. Changing a user publishes
+     * a new record instead of changing the old one.
+     *
+     * All of the text lives in one buffer and the getters return views
+     * into it, so reading a record never allocates.
+     *
+     * Every record has a 64 bit fingerprint of the fields that
+     * `operator==` compares. Records with different fingerprints are
+     * never equal, so most comparisons are a single integer compare.
+     *
+     * @brief An immutable snapshot of a user
+     *
+     */
+    class UserRecord {
+        public:
+            /**
+             * @brief Constructs a record of the user as it is right now
+             *
+             * @param user The user to take a snapshot of
+             *
+             */
+            explicit UserRecord(const GroupMe::User& user);
+
+            const GroupMe::ID& getID() const;
+
+            std::string_view getNickname() const;
+
+            std::string_view getProfileImageURL() const;
+
+            std::string_view getPhoneNumber() const;
+
+            std::string_view getEmail() const;
+
+            std::string_view getGUID() const;
+
+            std::string_view getLocale() const;
+
+            std::string_view getZipcode() const;
+
+            std::string_view getShareURL() const;
+
+            std::string_view getShareQRCodeURL() const;
+
+            unsigned int getCreatedAt() const;
+
+            unsigned int getUpdatedAt() const;
+
+            bool usingSMS() const;
+
+            bool getFacebookConnected() const;
+
+            bool getTwitterConnected() const;
+
+            /**
+             * @brief Gets the fingerprint of the fields that `operator==` compares
+             *
+             * @return uint64_t
+             *
+             */
+            uint64_t getFingerprint() const;
+
+            /**
+             * Compares the same fields as `GroupMe::User::operator==`
+             *
+             * @brief Compares two records without allocating
+             *
+             */
+            bool operator==(const UserRecord& other) const;
+
+            bool operator!=(const UserRecord& other) const;
+
+        private:
+            // The strings in `m_text`, in order
+            enum Text : uint8_t {
+                Nickname,
+                ProfileImageURL,
+                PhoneNumber,
+                Email,
+                GUID,
+                Locale,
+                Zipcode,
+                ShareURL,
+                ShareQRCodeURL,
+                Count
+            };
+
+            std::string_view text(Text text) const;
+
+            GroupMe::ID m_id;
+
+            std::string m_text;
+
+            // String `i` is `m_text[m_offsets[i], m_offsets[i + 1])`
+            std::array<uint32_t, Text::Count + 1> m_offsets;
+
+            uint64_t m_fingerprint;
+
+            unsigned int m_createdAt;
+
+            unsigned int m_updatedAt;
+
+            bool m_isSMS;
+
+            bool m_isFacebookConnected;
+
+            bool m_isTwitterConnected;
+    };
+}
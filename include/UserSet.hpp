@@ -18,9 +18,15 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <set>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <initializer_list>
 
 #include "User.h"
 
@@ -30,24 +36,417 @@ namespace GroupMe {
         using is_transparent = void;
 
         inline size_t operator()(const std::shared_ptr<User>& a, const std::shared_ptr<User>&b ) const {
-            return (a.get()->getID() < b.get()->getID());
+            return (a.get()->getCompactID() < b.get()->getCompactID());
         }
 
+        // IDs are compared as `GroupMe::ID`s so these order the same way as above
         inline size_t operator()(const std::shared_ptr<User>& a, const std::string& id) const {
-            return (a.get()->getID() < id);
+            return (a.get()->getCompactID() < GroupMe::ID(id));
         }
 
         inline size_t operator()(const std::string& id, const std::shared_ptr<User>& a) const {
-            return (a.get()->getID() < id);
+            return (GroupMe::ID(id) < a.get()->getCompactID());
         }
 
     };
 
     /**
-     * @brief This type should be used to hold `GroupMe::User`'s
+     * Users are kept in a flat array in the order they were added, and an
+     * open addressing table with linear probing maps user IDs to their
+     * place in the array. Lookups take a `std::string_view` or a
+     * `GroupMe::ID`, and numeric IDs are compared as integers, so finding
+     * a user doesn't allocate.
+     *
+     * The ID of a user is copied when it's added, so a user's ID shouldn't
+     * be changed while it is in a set, the same as with a `std::set`.
      *
-     * Essentially this is just a std::set with some custom comparisons
+     * Unlike a `std::set`, adding a user can invalidate iterators, and
+     * erasing moves the last user into the erased place.
+     *
+     * @brief This type should be used to hold `GroupMe::User`'s
      *
      */
-    typedef std::set<std::shared_ptr<User>, UserCompare, std::allocator<std::shared_ptr<User>>> UserSet;
+    class UserSet {
+        public:
+            using value_type = std::shared_ptr<User>;
+
+            using size_type = std::size_t;
+
+            using const_iterator = std::vector<std::shared_ptr<User>>::const_iterator;
+
+            // Users can't be changed through the set, like with a `std::set`
+            using iterator = const_iterator;
+
+            UserSet() = default;
+
+            UserSet(std::initializer_list<std::shared_ptr<User>> users) {
+                reserve(users.size());
+                for (const auto& user : users) {
+                    insert(user);
+                }
+            }
+
+            /**
+             * The table is sized once up front, so this is linear in the
+             * number of users whatever order they are in. When two users
+             * have the same ID the first one is kept.
+             *
+             * @brief Builds a set out of a list of users in one pass
+             *
+             * @param users The users to put in the set
+             *
+             */
+            explicit UserSet(std::vector<std::shared_ptr<User>> users) {
+                reserve(users.size());
+                for (auto& user : users) {
+                    GroupMe::ID id = user->getCompactID();
+                    insert(std::move(user), std::move(id));
+                }
+            }
+
+            /**
+             * @brief What changed between two versions of a set of users
+             *
+             */
+            struct Diff {
+                // Users that are only in the new set
+                std::vector<std::shared_ptr<User>> added;
+
+                // Users that are only in the old set
+                std::vector<std::shared_ptr<User>> removed;
+
+                // Users in both sets whose profile changed, as they are in the new set
+                std::vector<std::shared_ptr<User>> changed;
+
+                bool empty() const {
+                    return added.empty() && removed.empty() && changed.empty();
+                }
+            };
+
+            /**
+             * Users are matched by ID, and a matched user changed if its
+             * fingerprint isn't the same as the old one's, which is a single
+             * integer compare once the users' records are made. Each side
+             * is walked once, so this is linear.
+             *
+             * @brief Works out what changed from `before` to `after`
+             *
+             * @param before The old set
+             * @param after The new set
+             *
+             * @return GroupMe::UserSet::Diff
+             *
+             */
+            static Diff diff(const UserSet& before, const UserSet& after) {
+                Diff diff;
+
+                for (size_type i = 0; i < after.m_users.size(); i++) {
+                    const_iterator old = before.find(after.m_ids[i]);
+                    if (old == before.end()) {
+                        diff.added.push_back(after.m_users[i]);
+                    }
+                    else if (*old != after.m_users[i] && (*old)->getFingerprint() != after.m_users[i]->getFingerprint()) {
+                        diff.changed.push_back(after.m_users[i]);
+                    }
+                }
+
+                for (size_type i = 0; i < before.m_users.size(); i++) {
+                    if (!after.contains(before.m_ids[i])) {
+                        diff.removed.push_back(before.m_users[i]);
+                    }
+                }
+
+                return diff;
+            }
+
+            const_iterator begin() const {
+                return m_users.cbegin();
+            }
+
+            const_iterator end() const {
+                return m_users.cend();
+            }
+
+            const_iterator cbegin() const {
+                return m_users.cbegin();
+            }
+
+            const_iterator cend() const {
+                return m_users.cend();
+            }
+
+            bool empty() const {
+                return m_users.empty();
+            }
+
+            size_type size() const {
+                return m_users.size();
+            }
+
+            /**
+             * @brief Makes room for `count` users without growing again
+             *
+             * @param count The number of users to make room for
+             *
+             */
+            void reserve(size_type count) {
+                m_users.reserve(count);
+                m_ids.reserve(count);
+
+                size_type capacity = s_minimumCapacity;
+                while (!fits(count, capacity)) {
+                    capacity *= 2;
+                }
+                if (capacity > m_slots.size()) {
+                    rehash(capacity);
+                }
+            }
+
+            void clear() {
+                m_users.clear();
+                m_ids.clear();
+                m_slots.assign(m_slots.size(), Slot());
+            }
+
+            /**
+             * @brief Adds a user if there isn't a user with the same ID
+             *
+             * @param user The user to add
+             *
+             * @return std::pair<GroupMe::UserSet::iterator, bool> The user with the ID, and whether it was added
+             *
+             */
+            std::pair<iterator, bool> insert(const std::shared_ptr<User>& user) {
+                return insert(std::shared_ptr<User>(user), user->getCompactID());
+            }
+
+            template <class InputIt>
+            void insert(InputIt first, InputIt last) {
+                for (; first != last; ++first) {
+                    insert(*first);
+                }
+            }
+
+            /**
+             * @brief Finds a user by their ID
+             *
+             * @param id The ID of the user
+             *
+             * @return const_iterator The user, or `end()` if it isn't in the set
+             *
+             */
+            const_iterator find(const GroupMe::ID& id) const {
+                size_type slot = findSlot(id, hash(id));
+                if (slot == s_none) {
+                    return end();
+                }
+                return begin() + m_slots[slot].index - 1;
+            }
+
+            const_iterator find(std::string_view id) const {
+                return find(GroupMe::ID(id));
+            }
+
+            /**
+             * @brief Finds the user with the same ID as `user`
+             *
+             * @param user The user to look for
+             *
+             * @return const_iterator The user, or `end()` if it isn't in the set
+             *
+             */
+            const_iterator find(const std::shared_ptr<User>& user) const {
+                return find(user->getCompactID());
+            }
+
+            /**
+             * @brief Finds a user by their ID and gets a snapshot of them
+             *
+             * @param id The ID of the user
+             *
+             * @return std::shared_ptr<const GroupMe::UserRecord> `nullptr` if the user isn't in the set
+             *
+             */
+            std::shared_ptr<const UserRecord> findRecord(const GroupMe::ID& id) const {
+                const_iterator user = find(id);
+                if (user == end()) {
+                    return nullptr;
+                }
+                return (*user)->getRecord();
+            }
+
+            size_type count(std::string_view id) const {
+                return contains(id) ? 1 : 0;
+            }
+
+            bool contains(const GroupMe::ID& id) const {
+                return findSlot(id, hash(id)) != s_none;
+            }
+
+            bool contains(std::string_view id) const {
+                return contains(GroupMe::ID(id));
+            }
+
+            /**
+             * @brief Removes a user, the last user is moved into its place
+             *
+             * @param position The user to remove
+             *
+             * @return iterator The user that took its place, or `end()`
+             *
+             */
+            iterator erase(const_iterator position) {
+                size_type index = static_cast<size_type>(position - begin());
+                removeSlot(findSlot(m_ids[index], hash(m_ids[index])));
+
+                size_type last = m_users.size() - 1;
+                if (index != last) {
+                    // The slot of the last user has to point to where it's moved to
+                    m_slots[findSlot(m_ids[last], hash(m_ids[last]))].index = static_cast<uint32_t>(index + 1);
+                    m_users[index] = std::move(m_users[last]);
+                    m_ids[index] = std::move(m_ids[last]);
+                }
+                m_users.pop_back();
+                m_ids.pop_back();
+
+                return begin() + index;
+            }
+
+            size_type erase(const GroupMe::ID& id) {
+                const_iterator user = find(id);
+                if (user == end()) {
+                    return 0;
+                }
+                erase(user);
+                return 1;
+            }
+
+            size_type erase(std::string_view id) {
+                return erase(GroupMe::ID(id));
+            }
+
+            /**
+             * Like `std::set::merge`, users whose ID is already in this set
+             * are left in `other`.
+             *
+             * @brief Moves the users of `other` into this set
+             *
+             * @param other The set to take users from
+             *
+             */
+            void merge(UserSet& other) {
+                size_type index = 0;
+                while (index < other.m_users.size()) {
+                    if (contains(other.m_ids[index])) {
+                        index++;
+                        continue;
+                    }
+
+                    insert(other.m_users[index], other.m_ids[index]);
+                    other.erase(other.begin() + index);
+                }
+            }
+
+        private:
+            // `index` is the place of the user in `m_users` plus one, zero is an empty slot
+            struct Slot {
+                uint32_t hash = 0;
+
+                uint32_t index = 0;
+            };
+
+            static constexpr size_type s_none = ~size_type(0);
+
+            static constexpr size_type s_minimumCapacity = 16;
+
+            // At most three quarters of the slots are used, so probes stay short
+            static bool fits(size_type count, size_type capacity) {
+                return count * 4 <= capacity * 3;
+            }
+
+            static uint32_t hash(const GroupMe::ID& id) {
+                return static_cast<uint32_t>(id.hash());
+            }
+
+            size_type findSlot(const GroupMe::ID& id, uint32_t hash) const {
+                if (m_slots.empty()) {
+                    return s_none;
+                }
+
+                size_type mask = m_slots.size() - 1;
+                for (size_type slot = hash & mask; ; slot = (slot + 1) & mask) {
+                    const Slot& current = m_slots[slot];
+                    if (current.index == 0) {
+                        return s_none;
+                    }
+                    if (current.hash == hash && m_ids[current.index - 1] == id) {
+                        return slot;
+                    }
+                }
+            }
+
+            void placeSlot(Slot slot) {
+                size_type mask = m_slots.size() - 1;
+                size_type position = slot.hash & mask;
+                while (m_slots[position].index != 0) {
+                    position = (position + 1) & mask;
+                }
+                m_slots[position] = slot;
+            }
+
+            // Shifts the slots after `slot` back so that no probe runs into a hole
+            void removeSlot(size_type slot) {
+                size_type mask = m_slots.size() - 1;
+                size_type hole = slot;
+                for (size_type next = (hole + 1) & mask; m_slots[next].index != 0; next = (next + 1) & mask) {
+                    size_type home = m_slots[next].hash & mask;
+                    if (((next - home) & mask) >= ((next - hole) & mask)) {
+                        m_slots[hole] = m_slots[next];
+                        hole = next;
+                    }
+                }
+                m_slots[hole] = Slot();
+            }
+
+            void rehash(size_type capacity) {
+                std::vector<Slot> slots(capacity);
+                for (const Slot& slot : m_slots) {
+                    if (slot.index != 0) {
+                        size_type position = slot.hash & (capacity - 1);
+                        while (slots[position].index != 0) {
+                            position = (position + 1) & (capacity - 1);
+                        }
+                        slots[position] = slot;
+                    }
+                }
+                m_slots = std::move(slots);
+            }
+
+            std::pair<iterator, bool> insert(std::shared_ptr<User> user, GroupMe::ID id) {
+                uint32_t idHash = hash(id);
+
+                size_type found = findSlot(id, idHash);
+                if (found != s_none) {
+                    return {begin() + m_slots[found].index - 1, false};
+                }
+
+                if (!fits(m_users.size() + 1, m_slots.size())) {
+                    rehash(m_slots.empty() ? s_minimumCapacity : m_slots.size() * 2);
+                }
+
+                m_users.push_back(std::move(user));
+                m_ids.push_back(std::move(id));
+                placeSlot({idHash, static_cast<uint32_t>(m_users.size())});
+
+                return {end() - 1, true};
+            }
+
+            std::vector<std::shared_ptr<User>> m_users;
+
+            // The ID of every user in `m_users`, so probes don't call `User::getID`
+            std::vector<GroupMe::ID> m_ids;
+
+            // Always empty or a power of two
+            std::vector<Slot> m_slots;
+    };
 }
@@ -29,6 +29,7 @@
 #include <algorithm>
 #include <thread>
 #include <chrono>
+#include <atomic>
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -39,6 +40,8 @@ extern "C" {
 #include "util/multipart_parser.h"
 #include "util/Exceptions.h"
 #include "util/AVFileMem.h"
+#include "util/Executors.h"
+#include "util/Cancellation.h"
 
 namespace GroupMe {
     /**
@@ -94,13 +97,21 @@ namespace GroupMe {
 
             Video(const Video& other);
 
-            Video(Video&& other) = delete;
+            Video(Video&& other) noexcept = default;
 
-            ~Video();
+            /**
+             * This never waits for anything that is running for the video.
+             * If this is the last copy of the video and it hasn't been
+             * uploaded, the preparation of the video is cancelled.
+             *
+             * @brief The destructor
+             *
+             */
+            ~Video() override;
 
             Video& operator=(const Video& other);
 
-            Video& operator=(Video&& other) = delete;
+            Video& operator=(Video&& other) noexcept;
 
             /**
              * This member function will upload the video to the GroupMe
@@ -114,22 +125,65 @@ namespace GroupMe {
              *
              * @brief Uploads the video to the server
              *
-             * @return pplx::tasl<std::string>
+             * @param token A token that can be used to cancel the upload
+             * @param deadline The point in time the upload is cancelled at if it hasn't finished
+             *
+             * @return pplx::task<std::string>
+             *
+             */
+            pplx::task<std::string> upload(const pplx::cancellation_token& token = pplx::cancellation_token::none(), const Util::Deadline& deadline = Util::Deadline::none());
+
+            /**
+             * This aborts any requests that are in flight for this video,
+             * including the download of the video if it was created from
+             * a URL, and stops polling for the upload status. Tasks that were
+             * cancelled will throw `pplx::task_canceled` when `.get()` is called.
+             * The video can't be uploaded after this.
+             *
+             * @brief Cancels everything that is running for this video
              *
              */
-            pplx::task<std::string> upload();
+            void cancel();
 
         private:
-            web::http::http_request m_request;
+            // Everything the tasks use lives in here so that the tasks can
+            // own it. That lets the video be moved or destroyed without
+            // waiting for them.
+            struct State {
+                explicit State(const web::uri& endpoint);
+
+                web::http::http_request request;
+
+                web::http::client::http_client client;
+
+                web::http::MultipartParser parser;
+
+                // The content of the video, shared with every copy of it
+                std::shared_ptr<Attachment::Content> content;
+
+                pplx::task<void> task;
+
+                pplx::cancellation_token_source cancellation;
+
+                // Copies of the video and uploads that haven't finished. Once
+                // none are left nothing can use the preparation anymore.
+                std::atomic<std::size_t> owners;
+
+                pplx::cancellation_token_source preparation;
+            };
 
-            web::http::client::http_client m_client;
+            // Adds this copy as an owner of the state
+            void acquire();
 
-            web::http::MultipartParser m_parser;
+            // Cancels the preparation if this is the last copy
+            void release();
 
-            std::string m_conversationID;
+            // Drops an owner, the last one cancels the preparation and frees its buffers
+            static void release(const std::shared_ptr<State>& state);
 
-            pplx::task<void> m_task;
+            // Checks the status url until the upload is processed
+            static pplx::task<std::string> poll(const std::shared_ptr<web::http::client::http_client>& client, const pplx::cancellation_token& token);
 
-            nlohmann::json m_json;
+            std::shared_ptr<State> m_state;
     };
 }
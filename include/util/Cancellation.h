@@ -0,0 +1,305 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <pplx/pplxtasks.h>
+
+#include "util/Executors.h"
+
+namespace GroupMe::Util {
+
+    /**
+     * This class represents a point in time that an operation has to be
+     * finished by. A default constructed deadline never expires.
+     *
+     * For example:
+     * `picture.upload(token, GroupMe::Util::Deadline::after(std::chrono::seconds(10)));`
+     *
+     * @brief A point in time that an operation has to finish by
+     *
+     */
+    class Deadline {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            /**
+             * @brief Constructs a `GroupMe::Util::Deadline` that never expires
+             *
+             */
+            Deadline();
+
+            /**
+             * @brief Constructs a `GroupMe::Util::Deadline` that expires at a point in time
+             *
+             * @param time The point in time to expire at
+             *
+             */
+            explicit Deadline(Clock::time_point time);
+
+            /**
+             * @brief Gets a deadline that never expires
+             *
+             * @return GroupMe::Util::Deadline
+             *
+             */
+            static Deadline none();
+
+            /**
+             * @brief Gets a deadline that expires after a duration from now
+             *
+             * @param duration How long from now the deadline expires
+             *
+             * @return GroupMe::Util::Deadline
+             *
+             */
+            static Deadline after(Clock::duration duration);
+
+            /**
+             * @brief Returns whether or not the deadline can expire
+             *
+             * @return bool
+             *
+             */
+            bool isSet() const;
+
+            /**
+             * @brief Returns whether or not the deadline has passed
+             *
+             * @return bool
+             *
+             */
+            bool expired() const;
+
+            /**
+             * @brief Gets the point in time the deadline expires at
+             *
+             * @return GroupMe::Util::Deadline::Clock::time_point
+             *
+             */
+            Clock::time_point time() const;
+
+        private:
+            Clock::time_point m_time;
+
+            bool m_set;
+    };
+
+    /**
+     * Every callback runs on the same timer thread, so a callback should
+     * only start work, like a task or a request, and never block.
+     *
+     * @brief Runs callbacks at points in time
+     *
+     */
+    class Timer {
+        public:
+            /**
+             * @brief Identifies a callback that was scheduled
+             *
+             */
+            struct Handle {
+                Deadline::Clock::time_point time;
+
+                uint64_t id = 0;
+            };
+
+            Timer() = delete;
+
+            /**
+             * @brief Runs a callback once a point in time passes
+             *
+             * @param time The point in time to run the callback at
+             * @param callback The callback to run
+             *
+             * @return GroupMe::Util::Timer::Handle A handle that can drop the callback
+             *
+             */
+            static Handle schedule(Deadline::Clock::time_point time, std::function<void()> callback);
+
+            /**
+             * The callback is destroyed right away, along with everything it
+             * holds. Callbacks that already ran or are running aren't affected.
+             *
+             * @brief Drops a callback that hasn't run yet
+             *
+             * @param handle The handle `schedule` returned
+             *
+             */
+            static void cancel(const Handle& handle);
+
+            /**
+             * This should be used instead of `GroupMe::Util::Cancellation::sleepFor`
+             * between the steps of a task chain, since nothing waits on a
+             * worker thread while the time passes.
+             *
+             * @brief Creates a task that finishes once a duration passes
+             *
+             * @param duration How long until the task finishes
+             * @param token The token that cancels the task
+             *
+             * @return pplx::task<void>
+             *
+             */
+            static pplx::task<void> delay(std::chrono::milliseconds duration, const pplx::cancellation_token& token = pplx::cancellation_token::none());
+    };
+
+    /**
+     * @brief Helpers for combining cancellation tokens and deadlines
+     *
+     */
+    class Cancellation {
+        public:
+            /**
+             * A link registers a callback on every token it's linked to, and
+             * holds a timer entry for its deadline. Both stay until the link
+             * is released, so a link to a long lived token has to be released
+             * once the operation using it is done. That's usually done with
+             * `attach`. The last copy of a link releases it as well.
+             *
+             * For example:
+             * `auto link = GroupMe::Util::Cancellation::link({token, m_cancellation.get_token()}, deadline);`
+             * `return link.attach(client.request(request, link.getToken()));`
+             *
+             * @brief A token that is linked to other tokens and a deadline
+             *
+             */
+            class Link {
+                public:
+                    /**
+                     * @brief Constructs a `GroupMe::Util::Cancellation::Link` that never cancels
+                     *
+                     */
+                    Link();
+
+                    /**
+                     * @brief Gets the linked token
+                     *
+                     * @return const pplx::cancellation_token&
+                     *
+                     */
+                    const pplx::cancellation_token& getToken() const;
+
+                    /**
+                     * The token keeps whatever state it's in, but it isn't
+                     * cancelled by the linked tokens or the deadline anymore.
+                     *
+                     * @brief Unregisters from the linked tokens and drops the deadline
+                     *
+                     */
+                    void release() const;
+
+                    /**
+                     * @brief Releases the link once a task finishes, however it finishes
+                     *
+                     * @param task The task that uses the token
+                     *
+                     * @return pplx::task<T> The same task
+                     *
+                     */
+                    template <typename T>
+                    pplx::task<T> attach(const pplx::task<T>& task) const {
+                        if (m_state != nullptr) {
+                            task.then([state = m_state](const pplx::task<T>&) {
+                                state->release();
+                            }, Executors::options(Executors::io(), pplx::cancellation_token::none()));
+                        }
+                        return task;
+                    }
+
+                private:
+                    friend class Cancellation;
+
+                    struct State {
+                        State() = default;
+
+                        State(const State& other) = delete;
+
+                        State& operator=(const State& other) = delete;
+
+                        ~State();
+
+                        void release();
+
+                        pplx::cancellation_token_source source;
+
+                        std::mutex mutex;
+
+                        bool released = false;
+
+                        std::vector<std::pair<pplx::cancellation_token, pplx::cancellation_token_registration>> registrations;
+
+                        bool timed = false;
+
+                        Timer::Handle timer;
+                    };
+
+                    explicit Link(pplx::cancellation_token token);
+
+                    explicit Link(std::shared_ptr<State> state);
+
+                    std::shared_ptr<State> m_state;
+
+                    pplx::cancellation_token m_token;
+            };
+
+            Cancellation() = delete;
+
+            /**
+             * The token of the link is cancelled when any of the passed tokens
+             * are cancelled, or when the deadline passes. If nothing passed in
+             * can ever cancel, the token is `pplx::cancellation_token::none()`,
+             * and if a single token can, it's that token. Neither of those need
+             * to be released.
+             *
+             * @brief Links tokens and a deadline into a single token
+             *
+             * @param tokens The tokens to link
+             * @param deadline The deadline to cancel at
+             *
+             * @return GroupMe::Util::Cancellation::Link
+             *
+             */
+            static Link link(std::initializer_list<pplx::cancellation_token> tokens, const Deadline& deadline = Deadline());
+
+            /**
+             * This should be used instead of `std::this_thread::sleep_for` in
+             * polling loops so that cancelling the token wakes the thread.
+             *
+             * @brief Sleeps until the duration passes or the token is cancelled
+             *
+             * @param duration How long to sleep for
+             * @param token The token that can cut the sleep short
+             *
+             * @return bool `false` if the token was cancelled
+             *
+             */
+            static bool sleepFor(std::chrono::milliseconds duration, const pplx::cancellation_token& token);
+    };
+}
@@ -0,0 +1,157 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <functional>
+
+namespace GroupMe::Util {
+
+    /**
+     * Lock free structures can't free memory that they unlink right away,
+     * since a reader might still be looking at it. Readers pin the current
+     * epoch while they read, and memory that is retired is only reclaimed
+     * once every reader that was pinned when it was retired has left. The
+     * global epoch only moves forward once every pinned reader has seen it,
+     * so something retired in epoch `e` is safe once the epoch is `e + 2`.
+     *
+     * Pinning only writes to a slot that belongs to the calling thread, so
+     * readers never contend with each other or with writers. Pins nest.
+     *
+     * For example:
+     * `{ auto guard = GroupMe::Util::Epoch::pin(); ...read... }`
+     *
+     * @brief Epoch based memory reclamation
+     *
+     */
+    class Epoch {
+        public:
+            Epoch() = delete;
+
+            /**
+             * @brief Keeps the thread pinned for as long as it's alive
+             *
+             */
+            class Guard {
+                public:
+                    Guard();
+
+                    Guard(const Guard& other) = delete;
+
+                    Guard(Guard&& other) noexcept;
+
+                    Guard& operator=(const Guard& other) = delete;
+
+                    Guard& operator=(Guard&& other) noexcept;
+
+                    ~Guard();
+
+                private:
+                    friend class Epoch;
+
+                    void release();
+
+                    bool m_pinned;
+            };
+
+            /**
+             * Nothing that is reachable when this is called is reclaimed
+             * until the guard is destroyed. Guards must be destroyed on the
+             * thread that made them.
+             *
+             * @brief Pins the calling thread to the current epoch
+             *
+             * @return GroupMe::Util::Epoch::Guard
+             *
+             */
+            static Guard pin();
+
+            /**
+             * The memory has to be unlinked already, so that no reader that
+             * pins after this can reach it.
+             *
+             * @brief Reclaims something once no reader can be looking at it
+             *
+             * @param reclaim Frees the memory
+             *
+             */
+            static void retire(std::function<void()> reclaim);
+
+            /**
+             * This is called by `retire`, so it only has to be called to
+             * reclaim sooner, like after the readers are done.
+             *
+             * @brief Moves the epoch forward if it can, and reclaims what is safe
+             *
+             * @return std::size_t The number of things that were reclaimed
+             *
+             */
+            static std::size_t collect();
+
+            /**
+             * @brief Gets the number of things that were retired but not reclaimed yet
+             *
+             * @return std::size_t
+             *
+             */
+            static std::size_t pending();
+
+        private:
+            // A slot for one thread, they are never freed but they are reused
+            // once their thread exits
+            struct alignas(64) Participant {
+                // The epoch the thread is pinned to, 0 when it isn't pinned
+                std::atomic<uint64_t> epoch{0};
+
+                std::atomic<bool> used{false};
+
+                // Only touched by the thread that owns the slot
+                unsigned int depth = 0;
+
+                Participant* next = nullptr;
+            };
+
+            struct Retired {
+                uint64_t epoch;
+
+                std::function<void()> reclaim;
+            };
+
+            class Registration;
+
+            static Participant& local();
+
+            // Expects `s_mutex` to be held
+            static bool advance();
+
+            // The epoch starts at 1 so that 0 can mean not pinned
+            static std::atomic<uint64_t> s_epoch;
+
+            static std::atomic<Participant*> s_participants;
+
+            // Guards the retired list
+            static std::mutex s_mutex;
+
+            static std::vector<Retired> s_retired;
+    };
+}
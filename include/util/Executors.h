@@ -0,0 +1,140 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+
+#include <pplx/pplxtasks.h>
+
+#include "util/ThreadPool.h"
+
+namespace GroupMe::Util {
+
+    /**
+     * This class holds the schedulers that the library runs its work on.
+     * Work is split into three kinds so that they don't compete with
+     * each other:
+     * - I/O, which runs continuations of network requests
+     * - CPU, which runs video probing, hashing and JSON parsing
+     * - Blocking, which runs blocking file reads
+     *
+     * Any of these can be replaced with a user supplied scheduler before
+     * any other objects of the library are created. If nothing is set, the
+     * I/O scheduler is the default pplx scheduler, the CPU scheduler is a
+     * `GroupMe::Util::ThreadPool` with one thread per hardware thread, and
+     * the blocking scheduler is a `GroupMe::Util::ThreadPool` with four threads.
+     *
+     * For example:
+     * `GroupMe::Util::Executors::setCPU(std::make_shared<GroupMe::Util::ThreadPool>(options));`
+     *
+     * @brief Holds the schedulers used by the library
+     *
+     */
+    class Executors {
+        public:
+            Executors() = delete;
+
+            /**
+             * @brief Gets the scheduler used for network continuations
+             *
+             * @return std::shared_ptr<pplx::scheduler_interface>
+             *
+             */
+            static std::shared_ptr<pplx::scheduler_interface> io();
+
+            /**
+             * @brief Gets the scheduler used for CPU heavy work
+             *
+             * @return std::shared_ptr<pplx::scheduler_interface>
+             *
+             */
+            static std::shared_ptr<pplx::scheduler_interface> cpu();
+
+            /**
+             * @brief Gets the scheduler used for blocking file reads
+             *
+             * @return std::shared_ptr<pplx::scheduler_interface>
+             *
+             */
+            static std::shared_ptr<pplx::scheduler_interface> blocking();
+
+            /**
+             * @brief Creates task options that run on a scheduler and are cancelled by a token
+             *
+             * @param scheduler The scheduler to run on
+             * @param token The token that cancels the task
+             *
+             * @return pplx::task_options
+             *
+             */
+            static pplx::task_options options(const std::shared_ptr<pplx::scheduler_interface>& scheduler, const pplx::cancellation_token& token);
+
+            /**
+             * @brief Sets the scheduler used for network continuations
+             *
+             * @param scheduler The new scheduler, or `nullptr` to use the default
+             *
+             */
+            static void setIO(const std::shared_ptr<pplx::scheduler_interface>& scheduler);
+
+            /**
+             * @brief Sets the scheduler used for CPU heavy work
+             *
+             * @param scheduler The new scheduler, or `nullptr` to use the default
+             *
+             */
+            static void setCPU(const std::shared_ptr<pplx::scheduler_interface>& scheduler);
+
+            /**
+             * @brief Sets the scheduler used for blocking file reads
+             *
+             * @param scheduler The new scheduler, or `nullptr` to use the default pool
+             *
+             */
+            static void setBlocking(const std::shared_ptr<pplx::scheduler_interface>& scheduler);
+
+            /**
+             * @brief Replaces the CPU scheduler with a new `GroupMe::Util::ThreadPool`
+             *
+             * @param options The options for the new pool
+             *
+             */
+            static void configureCPU(const ThreadPool::Options& options);
+
+            /**
+             * @brief Replaces the blocking scheduler with a new `GroupMe::Util::ThreadPool`
+             *
+             * @param options The options for the new pool
+             *
+             */
+            static void configureBlocking(const ThreadPool::Options& options);
+
+        private:
+            static std::mutex s_mutex;
+
+            static std::shared_ptr<pplx::scheduler_interface> s_io;
+
+            static std::shared_ptr<pplx::scheduler_interface> s_cpu;
+
+            static std::shared_ptr<pplx::scheduler_interface> s_blocking;
+    };
+}
@@ -0,0 +1,340 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <array>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "ID.h"
+
+namespace GroupMe::Util {
+
+    /**
+     * Tables of these are declared `constexpr` next to the classes they
+     * describe, and `GroupMe::Util::readFields` and `GroupMe::Util::writeFields`
+     * turn a table into a single pass decoder and an encoder. Adding a key
+     * to a class is one line in its table.
+     *
+     * For example:
+     * `GroupMe::Util::Field<User>("image_url", &User::m_userProfileImageURL)`
+     *
+     * @brief Describes how a JSON key maps to a member of `Object`
+     *
+     */
+    template <class Object>
+    class Field {
+        public:
+            /**
+             * @brief Whether a field is read from responses, written to requests, or both
+             *
+             */
+            enum Access : uint8_t {
+                Read = 1 << 0,
+                Write = 1 << 1,
+                ReadWrite = Read | Write
+            };
+
+            constexpr Field(std::string_view key, std::string Object::* member, uint8_t access = ReadWrite) :
+                m_key(key),
+                m_type(Type::String),
+                m_access(access),
+                m_string(member)
+            {
+
+            }
+
+            constexpr Field(std::string_view key, unsigned int Object::* member, uint8_t access = ReadWrite) :
+                m_key(key),
+                m_type(Type::UnsignedInt),
+                m_access(access),
+                m_unsignedInt(member)
+            {
+
+            }
+
+            constexpr Field(std::string_view key, uint64_t Object::* member, uint8_t access = ReadWrite) :
+                m_key(key),
+                m_type(Type::Unsigned64),
+                m_access(access),
+                m_unsigned64(member)
+            {
+
+            }
+
+            constexpr Field(std::string_view key, bool Object::* member, uint8_t access = ReadWrite) :
+                m_key(key),
+                m_type(Type::Boolean),
+                m_access(access),
+                m_boolean(member)
+            {
+
+            }
+
+            constexpr Field(std::string_view key, GroupMe::ID Object::* member, uint8_t access = ReadWrite) :
+                m_key(key),
+                m_type(Type::Identifier),
+                m_access(access),
+                m_identifier(member)
+            {
+
+            }
+
+            /**
+             * @brief Gets the JSON key of the field
+             *
+             * @return std::string_view
+             *
+             */
+            constexpr std::string_view key() const {
+                return m_key;
+            }
+
+            constexpr bool isReadable() const {
+                return (m_access & Read) != 0;
+            }
+
+            constexpr bool isWritable() const {
+                return (m_access & Write) != 0;
+            }
+
+            /**
+             * @brief Reads the field out of a JSON value into an object
+             *
+             * @param value A `GroupMe::Util::Json::Value` that isn't null
+             * @param object The object to store the field in
+             *
+             */
+            template <class Value>
+            void read(Value& value, Object& object) const {
+                switch (m_type) {
+                    case Type::String:
+                        object.*m_string = value.getString();
+                        break;
+                    case Type::UnsignedInt:
+                        object.*m_unsignedInt = static_cast<unsigned int>(value.getUnsigned());
+                        break;
+                    case Type::Unsigned64:
+                        object.*m_unsigned64 = value.getUnsigned();
+                        break;
+                    case Type::Boolean:
+                        object.*m_boolean = value.getBool();
+                        break;
+                    case Type::Identifier:
+                        object.*m_identifier = GroupMe::ID(value.getString());
+                        break;
+                }
+            }
+
+            /**
+             * The visitor is called as `visitor(std::string_view key, const T& value)`
+             * where `T` is the type of the member.
+             *
+             * @brief Writes the field of an object to a visitor
+             *
+             * @param object The object to write the field of
+             * @param visitor The visitor to write to
+             *
+             */
+            template <class Visitor>
+            void write(const Object& object, Visitor&& visitor) const {
+                switch (m_type) {
+                    case Type::String:
+                        visitor(m_key, object.*m_string);
+                        break;
+                    case Type::UnsignedInt:
+                        visitor(m_key, object.*m_unsignedInt);
+                        break;
+                    case Type::Unsigned64:
+                        visitor(m_key, object.*m_unsigned64);
+                        break;
+                    case Type::Boolean:
+                        visitor(m_key, object.*m_boolean);
+                        break;
+                    case Type::Identifier:
+                        visitor(m_key, object.*m_identifier);
+                        break;
+                }
+            }
+
+        private:
+            enum class Type : uint8_t {
+                String,
+                UnsignedInt,
+                Unsigned64,
+                Boolean,
+                Identifier
+            };
+
+            std::string_view m_key;
+
+            Type m_type;
+
+            uint8_t m_access;
+
+            // Only the one that matches `m_type` is set
+            std::string Object::* m_string = nullptr;
+
+            unsigned int Object::* m_unsignedInt = nullptr;
+
+            uint64_t Object::* m_unsigned64 = nullptr;
+
+            bool Object::* m_boolean = nullptr;
+
+            GroupMe::ID Object::* m_identifier = nullptr;
+    };
+
+    /**
+     * Null values are skipped. Keys that aren't readable fields of the table
+     * are passed to `fallback` as `fallback(std::string_view key, Value& value)`,
+     * for the fields that can't be described by a table.
+     *
+     * @brief Reads every field in the table out of a JSON object in a single pass
+     *
+     * @param fields The table of fields
+     * @param json The `GroupMe::Util::Json::Value` of the object
+     * @param object The object to store the fields in
+     * @param fallback Called for every key that isn't in the table
+     *
+     */
+    template <class Object, std::size_t N, class Value, class Target, class Fallback>
+    void readFields(const std::array<Field<Object>, N>& fields, Value& json, Target& object, Fallback&& fallback) {
+        static_assert(std::is_base_of_v<Object, Target>, "The fields don't belong to the object");
+
+        json.forEachField([&fields, &object, &fallback](std::string_view key, Value& value) {
+            for (const auto& field : fields) {
+                if (field.isReadable() && field.key() == key) {
+                    if (!value.isNull()) {
+                        field.read(value, object);
+                    }
+                    return;
+                }
+            }
+            fallback(key, value);
+        });
+    }
+
+    /**
+     * Fields whose bit isn't set are skipped, so they keep whatever the
+     * object already had. Keys that aren't in the table still go to `fallback`.
+     *
+     * @brief Reads the fields in the table whose bit is set in `mask` out of a JSON object
+     *
+     * @param fields The table of fields
+     * @param json The `GroupMe::Util::Json::Value` of the object
+     * @param object The object to store the fields in
+     * @param fallback Called for every key that isn't in the table
+     * @param mask Bit `i` selects `fields[i]`, see `GroupMe::Util::indexOf`
+     *
+     */
+    template <class Object, std::size_t N, class Value, class Target, class Fallback>
+    void readFields(const std::array<Field<Object>, N>& fields, Value& json, Target& object, Fallback&& fallback, uint64_t mask) {
+        static_assert(std::is_base_of_v<Object, Target>, "The fields don't belong to the object");
+        static_assert(N <= 64, "The table is too big for a mask");
+
+        json.forEachField([&fields, &object, &fallback, mask](std::string_view key, Value& value) {
+            for (std::size_t i = 0; i < N; i++) {
+                if (fields[i].isReadable() && fields[i].key() == key) {
+                    if ((mask & (uint64_t(1) << i)) != 0 && !value.isNull()) {
+                        fields[i].read(value, object);
+                    }
+                    return;
+                }
+            }
+            fallback(key, value);
+        });
+    }
+
+    /**
+     * @brief Reads every field in the table out of a JSON object in a single pass
+     *
+     * @param fields The table of fields
+     * @param json The `GroupMe::Util::Json::Value` of the object
+     * @param object The object to store the fields in
+     *
+     */
+    template <class Object, std::size_t N, class Value, class Target>
+    void readFields(const std::array<Field<Object>, N>& fields, Value& json, Target& object) {
+        readFields(fields, json, object, [](std::string_view, Value&) {});
+    }
+
+    /**
+     * @brief Writes every writable field in the table to a visitor, in the order of the table
+     *
+     * @param fields The table of fields
+     * @param object The object to write the fields of
+     * @param visitor Called as `visitor(std::string_view key, const T& value)`
+     *
+     */
+    template <class Object, std::size_t N, class Target, class Visitor>
+    void writeFields(const std::array<Field<Object>, N>& fields, const Target& object, Visitor&& visitor) {
+        static_assert(std::is_base_of_v<Object, Target>, "The fields don't belong to the object");
+
+        for (const auto& field : fields) {
+            if (field.isWritable()) {
+                field.write(object, visitor);
+            }
+        }
+    }
+
+    /**
+     * @brief Writes the writable fields in the table whose bit is set in `mask`, in the order of the table
+     *
+     * @param fields The table of fields
+     * @param object The object to write the fields of
+     * @param visitor Called as `visitor(std::string_view key, const T& value)`
+     * @param mask Bit `i` selects `fields[i]`, see `GroupMe::Util::indexOf`
+     *
+     */
+    template <class Object, std::size_t N, class Target, class Visitor>
+    void writeFields(const std::array<Field<Object>, N>& fields, const Target& object, Visitor&& visitor, uint64_t mask) {
+        static_assert(std::is_base_of_v<Object, Target>, "The fields don't belong to the object");
+        static_assert(N <= 64, "The table is too big for a mask");
+
+        for (std::size_t i = 0; i < N; i++) {
+            if ((mask & (uint64_t(1) << i)) != 0 && fields[i].isWritable()) {
+                fields[i].write(object, visitor);
+            }
+        }
+    }
+
+    /**
+     * @brief Finds the index of a key in a table, at compile time when the key is a constant
+     *
+     * @param fields The table of fields
+     * @param key The JSON key to look for
+     *
+     * @return std::size_t The index of the key, or `N` if it isn't in the table
+     *
+     */
+    template <class Object, std::size_t N>
+    constexpr std::size_t indexOf(const std::array<Field<Object>, N>& fields, std::string_view key) {
+        for (std::size_t i = 0; i < N; i++) {
+            if (fields[i].key() == key) {
+                return i;
+            }
+        }
+        return N;
+    }
+}
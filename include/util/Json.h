@@ -0,0 +1,327 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#ifdef GROUPME_SIMDJSON
+#include <simdjson.h>
+#else
+#include <nlohmann/json.hpp>
+#endif
+
+/*
+ * The JSON backend is picked when the library is built. By default responses
+ * are parsed with nlohmann json. Configuring with `-DGROUPME_SIMDJSON=ON`
+ * parses them with the simdjson On Demand parser instead, which only parses
+ * what is actually read and never builds a DOM.
+ *
+ * Both backends are read through the same single pass interface: fields of
+ * an object and elements of an array are visited in the order they appear,
+ * and every value can only be read once.
+ */
+namespace GroupMe::Util::Json {
+
+    /**
+     * @brief Gets the name of the backend the library was built with
+     *
+     * @return const char*
+     *
+     */
+    constexpr const char* backend() {
+#ifdef GROUPME_SIMDJSON
+        return "simdjson";
+#else
+        return "nlohmann";
+#endif
+    }
+
+    /**
+     * A value is only valid for as long as the `GroupMe::Util::Json::Document`
+     * it came from, and strings returned from it point into that document.
+     *
+     * @brief A JSON value inside of a `GroupMe::Util::Json::Document`
+     *
+     */
+    class Value {
+        public:
+#ifdef GROUPME_SIMDJSON
+            explicit Value(simdjson::ondemand::value value) :
+                m_value(std::move(value))
+            {
+
+            }
+#else
+            explicit Value(const nlohmann::json& value) :
+                m_value(&value)
+            {
+
+            }
+#endif
+
+            /**
+             * If the value isn't null it can still be read afterwards.
+             *
+             * @brief Returns whether or not the value is null
+             *
+             * @return bool
+             *
+             */
+            bool isNull() {
+#ifdef GROUPME_SIMDJSON
+                return static_cast<bool>(m_value.is_null());
+#else
+                return m_value->is_null();
+#endif
+            }
+
+            /**
+             * @brief Gets the value as a string
+             *
+             * @return std::string_view
+             *
+             */
+            std::string_view getString() {
+#ifdef GROUPME_SIMDJSON
+                return std::string_view(m_value.get_string());
+#else
+                return m_value->get_ref<const std::string&>();
+#endif
+            }
+
+            /**
+             * @brief Gets the value as an unsigned integer
+             *
+             * @return uint64_t
+             *
+             */
+            uint64_t getUnsigned() {
+#ifdef GROUPME_SIMDJSON
+                return static_cast<uint64_t>(m_value.get_uint64());
+#else
+                return m_value->get<uint64_t>();
+#endif
+            }
+
+            /**
+             * @brief Gets the value as a signed integer
+             *
+             * @return int64_t
+             *
+             */
+            int64_t getInteger() {
+#ifdef GROUPME_SIMDJSON
+                return static_cast<int64_t>(m_value.get_int64());
+#else
+                return m_value->get<int64_t>();
+#endif
+            }
+
+            /**
+             * @brief Gets the value as a boolean
+             *
+             * @return bool
+             *
+             */
+            bool getBool() {
+#ifdef GROUPME_SIMDJSON
+                return static_cast<bool>(m_value.get_bool());
+#else
+                return m_value->get<bool>();
+#endif
+            }
+
+            /**
+             * The function is called as `function(std::string_view key, GroupMe::Util::Json::Value& value)`
+             * for every field of the object, in order.
+             *
+             * @brief Visits every field of the object
+             *
+             * @param function The function to call for every field
+             *
+             */
+            template <class Function>
+            void forEachField(Function&& function) {
+#ifdef GROUPME_SIMDJSON
+                for (auto field : m_value.get_object()) {
+                    std::string_view key = field.unescaped_key();
+                    Value value(field.value());
+                    function(key, value);
+                }
+#else
+                for (const auto& [key, element] : m_value->get_ref<const nlohmann::json::object_t&>()) {
+                    Value value(element);
+                    function(std::string_view(key), value);
+                }
+#endif
+            }
+
+            /**
+             * The function is called as `function(GroupMe::Util::Json::Value& value)`
+             * for every element of the array, in order.
+             *
+             * @brief Visits every element of the array
+             *
+             * @param function The function to call for every element
+             *
+             */
+            template <class Function>
+            void forEachElement(Function&& function) {
+#ifdef GROUPME_SIMDJSON
+                for (auto element : m_value.get_array()) {
+                    Value value(element);
+                    function(value);
+                }
+#else
+                for (const auto& element : m_value->get_ref<const nlohmann::json::array_t&>()) {
+                    Value value(element);
+                    function(value);
+                }
+#endif
+            }
+
+        private:
+#ifdef GROUPME_SIMDJSON
+            simdjson::ondemand::value m_value;
+#else
+            const nlohmann::json* m_value;
+#endif
+    };
+
+    /**
+     * @brief A parsed JSON document
+     *
+     */
+    class Document {
+        public:
+            /**
+             * @brief Parses a JSON document
+             *
+             * @param body The JSON to parse
+             *
+             */
+            explicit Document(std::string_view body) :
+#ifdef GROUPME_SIMDJSON
+                m_body(body),
+                m_document(m_parser.iterate(m_body))
+#else
+                m_document(nlohmann::json::parse(body))
+#endif
+            {
+
+            }
+
+            Document(const Document& other) = delete;
+
+            Document(Document&& other) = delete;
+
+            Document& operator=(const Document& other) = delete;
+
+            Document& operator=(Document&& other) = delete;
+
+            /**
+             * @brief Returns whether or not the root of the document is an array
+             *
+             * @return bool
+             *
+             */
+            bool isArray() {
+#ifdef GROUPME_SIMDJSON
+                return m_document.type() == simdjson::ondemand::json_type::array;
+#else
+                return m_document.is_array();
+#endif
+            }
+
+            /**
+             * @brief Visits every field of the root object
+             *
+             * @param function The function to call as `function(std::string_view key, GroupMe::Util::Json::Value& value)`
+             *
+             */
+            template <class Function>
+            void forEachField(Function&& function) {
+#ifdef GROUPME_SIMDJSON
+                for (auto field : m_document.get_object()) {
+                    std::string_view key = field.unescaped_key();
+                    Value value(field.value());
+                    function(key, value);
+                }
+#else
+                Value(m_document).forEachField(std::forward<Function>(function));
+#endif
+            }
+
+            /**
+             * @brief Visits every element of the root array
+             *
+             * @param function The function to call as `function(GroupMe::Util::Json::Value& value)`
+             *
+             */
+            template <class Function>
+            void forEachElement(Function&& function) {
+#ifdef GROUPME_SIMDJSON
+                for (auto element : m_document.get_array()) {
+                    Value value(element);
+                    function(value);
+                }
+#else
+                Value(m_document).forEachElement(std::forward<Function>(function));
+#endif
+            }
+
+            /**
+             * This should be used when only a single value is needed out of
+             * a document, like the URL in an upload response.
+             *
+             * For example:
+             * `Document(body).getString("/payload/picture_url");`
+             *
+             * @brief Gets the string at a JSON pointer
+             *
+             * @param pointer The JSON pointer to the string
+             *
+             * @return std::string
+             *
+             */
+            std::string getString(const std::string& pointer) {
+#ifdef GROUPME_SIMDJSON
+                return std::string(std::string_view(m_document.at_pointer(pointer).get_string()));
+#else
+                return m_document.at(nlohmann::json::json_pointer(pointer)).get<std::string>();
+#endif
+            }
+
+        private:
+#ifdef GROUPME_SIMDJSON
+            simdjson::ondemand::parser m_parser;
+
+            simdjson::padded_string m_body;
+
+            simdjson::ondemand::document m_document;
+#else
+            nlohmann::json m_document;
+#endif
+    };
+}
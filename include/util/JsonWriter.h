@@ -0,0 +1,194 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace GroupMe {
+    class User;
+
+    class Message;
+
+    class Attachment;
+
+    class ID;
+}
+
+namespace GroupMe::Util {
+
+    /**
+     * Values are serialized straight into a buffer that is kept between
+     * bodies, so once the buffer is big enough writing a body doesn't
+     * allocate. Commas are added on their own, and strings are escaped
+     * the way JSON needs. Strings are expected to be UTF-8 already.
+     *
+     * For example:
+     * `writer.beginObject(); writer.field("text", text); writer.endObject();`
+     *
+     * @brief Writes JSON into a reusable buffer without building a DOM
+     *
+     */
+    class JsonWriter {
+        public:
+            /**
+             * @brief Constructs a new `GroupMe::Util::JsonWriter` object
+             *
+             * @param capacity The number of bytes to reserve up front
+             *
+             */
+            explicit JsonWriter(std::size_t capacity = 1024);
+
+            /**
+             * @brief Empties the buffer, keeping its memory for the next body
+             *
+             */
+            void clear();
+
+            /**
+             * The view is only valid until the writer is written to or cleared.
+             *
+             * @brief Gets the JSON written so far
+             *
+             * @return std::string_view
+             *
+             */
+            std::string_view view() const;
+
+            /**
+             * @brief Gets the number of bytes that fit in the buffer before it grows
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t capacity() const;
+
+            void beginObject();
+
+            void endObject();
+
+            void beginArray();
+
+            void endArray();
+
+            /**
+             * @brief Writes the key of the next value in an object
+             *
+             * @param key The key, which is escaped
+             *
+             */
+            void key(std::string_view key);
+
+            /**
+             * @brief Writes a string value
+             *
+             * @param string The string, which is escaped
+             *
+             */
+            void value(std::string_view string);
+
+            // Without this a string literal would pick the `bool` overload
+            void value(const char* string);
+
+            void value(bool boolean);
+
+            // IDs are strings in the API, even the numeric ones
+            void value(const GroupMe::ID& id);
+
+            /**
+             * @brief Writes an integer value
+             *
+             * @param number The integer to write
+             *
+             */
+            template <class Integer, std::enable_if_t<std::is_integral_v<Integer> && !std::is_same_v<Integer, bool>, int> = 0>
+            void value(Integer number) {
+                separate();
+
+                char digits[24];
+                std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), number);
+                m_buffer.append(digits, result.ptr);
+
+                m_comma = true;
+            }
+
+            void null();
+
+            /**
+             * @brief Writes a key and its value
+             *
+             * @param key The key of the value
+             * @param value The value to write
+             *
+             */
+            template <class T>
+            void field(std::string_view key, const T& value) {
+                this->key(key);
+                this->value(value);
+            }
+
+        private:
+            // Adds the comma between the values of an object or array
+            void separate();
+
+            void writeString(std::string_view string);
+
+            std::string m_buffer;
+
+            // Whether the next value or key needs a comma before it
+            bool m_comma;
+    };
+
+    /**
+     * @brief Writes a `users/update` body with the writable profile fields selected by `mask`
+     *
+     * @param writer The writer to write to
+     * @param user The user to write the profile of
+     * @param mask Bit `i` selects `GroupMe::User::Schema::profile[i]`
+     *
+     */
+    void writeProfile(JsonWriter& writer, const GroupMe::User& user, uint64_t mask = ~uint64_t(0));
+
+    /**
+     * @brief Writes the body that sends a message, with its text and attachments
+     *
+     * @param writer The writer to write to
+     * @param message The message to send
+     *
+     */
+    void writeMessage(JsonWriter& writer, const GroupMe::Message& message);
+
+    /**
+     * Attachments are written the way they are sent with a message,
+     * pictures and videos by URL and files by their ID.
+     *
+     * @brief Writes an array of attachments
+     *
+     * @param writer The writer to write to
+     * @param attachments The attachments to write
+     *
+     */
+    void writeAttachments(JsonWriter& writer, const std::vector<GroupMe::Attachment>& attachments);
+}
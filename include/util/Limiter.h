@@ -0,0 +1,137 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <exception>
+
+#include <pplx/pplxtasks.h>
+
+namespace GroupMe::Util {
+
+    /**
+     * A limiter hands out a fixed number of permits to tasks. Tasks that
+     * ask for a permit when none are left wait, without blocking a thread,
+     * until one is released. It's meant to be shared between everything
+     * that should count against the same budget, like all of the requests
+     * of a backfill.
+     *
+     * For example:
+     * `limiter->run([&client, request]() { return client.request(request); });`
+     *
+     * @brief An asynchronous semaphore for pplx tasks
+     *
+     */
+    class Limiter : public std::enable_shared_from_this<Limiter> {
+        public:
+            /**
+             * @brief Constructs a `GroupMe::Util::Limiter`
+             *
+             * @param permits The number of permits, at least 1
+             *
+             * @return std::shared_ptr<GroupMe::Util::Limiter>
+             *
+             */
+            static std::shared_ptr<Limiter> create(std::size_t permits);
+
+            Limiter(const Limiter& other) = delete;
+
+            Limiter& operator=(const Limiter& other) = delete;
+
+            /**
+             * Waiters are served in the order they asked. A waiter whose token
+             * is cancelled is cancelled the next time a permit is released.
+             *
+             * @brief Waits for a permit
+             *
+             * @param token A token to stop waiting with
+             *
+             * @return pplx::task<void> A task that completes once the permit is held
+             *
+             */
+            pplx::task<void> acquire(const pplx::cancellation_token& token = pplx::cancellation_token::none());
+
+            /**
+             * @brief Gives a permit back
+             *
+             */
+            void release();
+
+            /**
+             * @brief Gets the number of permits that aren't held
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t available() const;
+
+            /**
+             * The permit is released when the task that is started finishes,
+             * whether it succeeds or not.
+             *
+             * @brief Starts a task once a permit is held
+             *
+             * @param start A function that starts the task
+             * @param token A token to stop waiting with
+             *
+             * @return The task that `start` returns
+             *
+             */
+            template <typename Start>
+            auto run(Start start, const pplx::cancellation_token& token = pplx::cancellation_token::none()) -> decltype(start()) {
+                using Task = decltype(start());
+
+                std::shared_ptr<Limiter> self = shared_from_this();
+
+                return acquire(token).then([self, start]() mutable {
+                    Task task;
+                    try {
+                        task = start();
+                    }
+                    catch (...) {
+                        self->release();
+                        throw;
+                    }
+
+                    return task.then([self](Task finished) {
+                        self->release();
+                        return finished.get();
+                    });
+                });
+            }
+
+        private:
+            explicit Limiter(std::size_t permits);
+
+            struct Waiter {
+                pplx::task_completion_event<void> ready;
+
+                pplx::cancellation_token token;
+            };
+
+            mutable std::mutex m_mutex;
+
+            std::size_t m_available;
+
+            std::deque<Waiter> m_waiters;
+    };
+}
@@ -0,0 +1,261 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <nlohmann/json.hpp>
+
+#include "Message.h"
+#include "UserSet.hpp"
+#include "MemberDirectory.h"
+#include "util/Json.h"
+#include "util/Fields.h"
+
+namespace GroupMe::Util {
+
+    /**
+     * Fields can come in any order, so they are held here until the
+     * message object ends and then turned into a `GroupMe::Message`.
+     *
+     * @brief The fields of a message that is being parsed
+     *
+     */
+    struct MessageFields {
+        std::string id;
+
+        uint64_t createdAt = 0;
+
+        std::string userID;
+
+        std::string name;
+
+        std::string avatarURL;
+
+        std::string text;
+
+        std::vector<std::string> favoritedBy;
+
+        // Attachments are kept as they were sent so that they can be
+        // read without building a `GroupMe::Attachment`
+        struct AttachmentFields {
+            std::string type;
+
+            std::string url;
+
+            std::string fileID;
+        };
+
+        std::vector<AttachmentFields> attachments;
+
+        // The fields that are read straight out of a message object, the
+        // rest are arrays that need more than a table
+        static const std::array<GroupMe::Util::Field<MessageFields>, 6> s_fields;
+
+        static const std::array<GroupMe::Util::Field<AttachmentFields>, 3> s_attachmentFields;
+
+        /**
+         * The strings keep their capacity, so reusing one `GroupMe::Util::MessageFields`
+         * for a whole page doesn't allocate for every message.
+         *
+         * @brief Clears all of the fields
+         *
+         */
+        void clear();
+
+        /**
+         * @brief Reads the fields of a message object
+         *
+         * @param json The message object
+         *
+         */
+        void read(GroupMe::Util::Json::Value& json);
+
+        /**
+         * @brief Builds the message
+         *
+         * @param users The users that are in the group that the message was sent in
+         *
+         * @return GroupMe::Message
+         *
+         */
+        GroupMe::Message build(const GroupMe::UserSet& users) const;
+
+        /**
+         * @brief Builds the message, building only the members it refers to
+         *
+         * @param members The members of the group that the message was sent in
+         *
+         * @return GroupMe::Message
+         *
+         */
+        GroupMe::Message build(const GroupMe::MemberDirectory& members) const;
+    };
+
+    /**
+     * This class is an event handler for `nlohmann::json::sax_parse` that
+     * hands every message of a page to a function as soon as its object
+     * ends, without ever building a `nlohmann::json`.
+     *
+     * It looks for the first array under a `"messages"` key, so it can be
+     * given the whole response body from the messages endpoint. A bare
+     * array of messages works as well. Everything else is skipped.
+     *
+     * For example:
+     * `GroupMe::Util::MessagePageParser parser([](GroupMe::Util::MessageFields& message) { ... });`
+     * `nlohmann::json::sax_parse(body, &parser);`
+     *
+     * @brief A SAX handler that parses a page of messages
+     *
+     */
+    class MessagePageParser {
+        public:
+            using number_integer_t = nlohmann::json::number_integer_t;
+            using number_unsigned_t = nlohmann::json::number_unsigned_t;
+            using number_float_t = nlohmann::json::number_float_t;
+            using string_t = nlohmann::json::string_t;
+            using binary_t = nlohmann::json::binary_t;
+
+            using Handler = std::function<void(GroupMe::Util::MessageFields&)>;
+
+            /**
+             * The fields are only valid until the handler returns.
+             *
+             * @brief Constructs a new `GroupMe::Util::MessagePageParser` object
+             *
+             * @param handler The function that is called with every parsed message
+             *
+             */
+            explicit MessagePageParser(Handler handler);
+
+            bool null();
+
+            bool boolean(bool value);
+
+            bool number_integer(number_integer_t value);
+
+            bool number_unsigned(number_unsigned_t value);
+
+            bool number_float(number_float_t value, const string_t& string);
+
+            bool string(string_t& value);
+
+            bool binary(binary_t& value);
+
+            bool start_object(std::size_t elements);
+
+            bool end_object();
+
+            bool start_array(std::size_t elements);
+
+            bool end_array();
+
+            bool key(string_t& value);
+
+            template <class Exception>
+            bool parse_error(std::size_t position, const std::string& lastToken, const Exception& exception) {
+                static_cast<void>(position);
+                static_cast<void>(lastToken);
+                throw exception;
+            }
+
+        private:
+            // The arrays of a message that can't be described by a table
+            enum class Array {
+                None,
+                FavoritedBy,
+                Attachments
+            };
+
+            // Lets the field tables read the scalars handed to the events.
+            // A value of the wrong type reads as empty
+            struct Scalar {
+                std::string_view string;
+
+                uint64_t number = 0;
+
+                bool boolean = false;
+
+                std::string_view getString() const {
+                    return string;
+                }
+
+                uint64_t getUnsigned() const {
+                    return number;
+                }
+
+                bool getBool() const {
+                    return boolean;
+                }
+            };
+
+            // Reads a scalar into the field the last key belongs to, if any
+            void read(const Scalar& value);
+
+            void finishMessage();
+
+            void finishAttachment();
+
+            // Called for every value so that a key only applies to one
+            void consume();
+
+            Handler m_handler;
+
+            // The depth of the values inside the messages array,
+            // zero until the array is found
+            std::size_t m_messagesDepth;
+
+            std::size_t m_depth;
+
+            bool m_done;
+
+            bool m_expectMessages;
+
+            // The field the next value belongs to
+            const GroupMe::Util::Field<MessageFields>* m_field;
+
+            const GroupMe::Util::Field<MessageFields::AttachmentFields>* m_attachmentField;
+
+            // The array the next value is, and the one that's currently open
+            Array m_nextArray;
+
+            Array m_array;
+
+            MessageFields m_pending;
+
+            MessageFields::AttachmentFields m_attachment;
+    };
+
+    /**
+     * Uses simdjson when the library is built with `GROUPME_SIMDJSON`,
+     * and `GroupMe::Util::MessagePageParser` otherwise.
+     *
+     * @brief Parses a page of messages from the messages endpoint
+     *
+     * @param page The body of the response, or a bare array of messages
+     * @param handler The function that is called with every parsed message
+     *
+     */
+    void parseMessagePage(std::string_view page, const MessagePageParser::Handler& handler);
+}
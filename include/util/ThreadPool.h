@@ -0,0 +1,176 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+
+#include <pplx/pplxtasks.h>
+
+namespace GroupMe::Util {
+
+    /**
+     * This class is a fixed size pool of worker threads that can be used as
+     * a scheduler for pplx tasks. Tasks that are created with a
+     * `pplx::task_options` holding one of these will run on the pool
+     * instead of the default pplx scheduler.
+     *
+     * Every worker has its own queue. Work posted from a worker goes on the
+     * back of its own queue and is taken from the back again, so
+     * continuations stay hot in its cache. Work posted from anywhere else is
+     * spread over the queues. A worker that runs out of work steals from the
+     * front of the other queues, so uneven work still keeps every thread busy.
+     *
+     * @brief A bounded pool of worker threads
+     *
+     */
+    class ThreadPool : public pplx::scheduler_interface {
+        public:
+            /**
+             * @brief Options used to create a `GroupMe::Util::ThreadPool`
+             *
+             */
+            struct Options {
+                /**
+                 * @brief The amount of worker threads. Zero uses the amount of hardware threads
+                 *
+                 */
+                std::size_t threads = 0;
+
+                /**
+                 * The CPUs the worker threads are allowed to run on. If this is
+                 * empty the threads can run on any CPU. This is only supported
+                 * on Linux, and is ignored everywhere else.
+                 *
+                 * @brief The CPUs to pin the worker threads to
+                 *
+                 */
+                std::vector<unsigned int> affinity;
+
+                /**
+                 * @brief The name given to the worker threads, used for debugging
+                 *
+                 */
+                std::string name = "groupme";
+            };
+
+            /**
+             * @brief Constructs a new `GroupMe::Util::ThreadPool` object
+             *
+             * @param options The options for the pool
+             *
+             */
+            explicit ThreadPool(const Options& options);
+
+            ThreadPool(const ThreadPool& other) = delete;
+
+            ThreadPool(ThreadPool&& other) = delete;
+
+            /**
+             * Waits for the queued work to finish and then joins all of the
+             * worker threads.
+             *
+             * @brief The destructor
+             *
+             */
+            ~ThreadPool() override;
+
+            ThreadPool& operator=(const ThreadPool& other) = delete;
+
+            ThreadPool& operator=(ThreadPool&& other) = delete;
+
+            /**
+             * This is called by pplx to run a task on this pool
+             *
+             * @brief Schedules a function to run on the pool
+             *
+             * @param proc The function to run
+             * @param param The parameter to pass to the function
+             *
+             */
+            void schedule(pplx::TaskProc_t proc, void* param) override;
+
+            /**
+             * @brief Schedules a function to run on the pool
+             *
+             * @param work The function to run
+             *
+             */
+            void post(std::function<void()> work);
+
+            /**
+             * @brief Gets the amount of worker threads in the pool
+             *
+             * @return std::size_t
+             *
+             */
+            std::size_t size() const;
+
+        private:
+            struct Queue {
+                std::deque<std::function<void()>> work;
+
+                std::mutex mutex;
+            };
+
+            // Owned by the workers as well as the pool so that a worker
+            // can outlive the pool if it was the one that destroyed it
+            struct Shared {
+                explicit Shared(std::size_t threads);
+
+                // Takes work from the worker's own queue, or steals it
+                bool take(std::size_t index, std::function<void()>& work);
+
+                // One per worker, never resized once the workers start
+                std::vector<std::unique_ptr<Queue>> queues;
+
+                // The amount of work that was posted but not taken yet
+                std::atomic<std::size_t> pending;
+
+                // Where the next work from outside the pool goes
+                std::atomic<std::size_t> next;
+
+                // Only used to sleep and wake up the workers
+                std::mutex mutex;
+
+                std::condition_variable cv;
+
+                bool stopping = false;
+            };
+
+            static void run(const std::shared_ptr<Shared>& shared, const Options& options, std::size_t index);
+
+            Options m_options;
+
+            std::shared_ptr<Shared> m_shared;
+
+            std::vector<std::thread> m_threads;
+    };
+}
@@ -57,6 +57,8 @@ namespace web::http{
             
             const std::string &generateBody();
 
+            void clear();
+
         private:
             static std::pair<std::string, std::string> getFileNameTypes(const std::string &filePath);
 
@@ -20,9 +20,26 @@
 
 using namespace GroupMe;
 
+Attachment::Content::Content(std::string value) :
+    value(std::move(value))
+{
+
+}
+
+std::string Attachment::Content::get() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return value;
+}
+
+void Attachment::Content::set(std::string content) {
+    std::lock_guard<std::mutex> lock(mutex);
+    value = std::move(content);
+}
+
 Attachment::Attachment(const std::filesystem::path& contentPath, const Attachment::Types& type, const std::string& accessToken) :
     m_type(type),
     m_contentPath(contentPath),
+    m_content(std::make_shared<Content>(std::string())),
     m_accessToken(accessToken)
 {
 
@@ -30,6 +47,7 @@ Attachment::Attachment(const std::filesystem::path& contentPath, const Attachmen
 
 Attachment::Attachment(const std::vector<unsigned char>& contentBinary, const Attachment::Types& type, const std::string& accessToken) :
     m_type(type),
+    m_content(std::make_shared<Content>(std::string())),
     m_contentBinary(contentBinary),
     m_accessToken(accessToken)
 {
@@ -38,7 +56,7 @@ Attachment::Attachment(const std::vector<unsigned char>& contentBinary, const At
 
 Attachment::Attachment(const web::uri& contentURL, const Attachment::Types& type, const std::string& accessToken) :
     m_type(type),
-    m_content(contentURL.to_string()),
+    m_content(std::make_shared<Content>(contentURL.to_string())),
     m_accessToken(accessToken)
 {
 
@@ -46,26 +64,35 @@ Attachment::Attachment(const web::uri& contentURL, const Attachment::Types& type
 
 Attachment::Attachment(const web::uri &contentURL, const Attachment::Types &type) :
     m_type(type),
-    m_content(contentURL.to_string())
+    m_content(std::make_shared<Content>(contentURL.to_string()))
 {
 
 }
 
 Attachment::Attachment(const std::string &content, const Attachment::Types &type) :
     m_type(type),
-    m_content(content)
+    m_content(std::make_shared<Content>(content))
 {
 
 }
 
-Attachment::Types Attachment::getType() {
+Attachment::Types Attachment::getType() const {
     return m_type;
 }
 
+std::string Attachment::getContent() const {
+    // A moved from attachment has no content
+    if (m_content == nullptr) {
+        return std::string();
+    }
+    return m_content->get();
+}
+
 web::uri Attachment::getContentURL() {
-    return m_content;
+    return getContent();
 }
 
 void Attachment::setContentURL(const web::uri &url) {
-    m_content = url.to_string();
+    // Copies keep the content they shared
+    m_content = std::make_shared<Content>(url.to_string());
 }
@@ -0,0 +1,153 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ContactRegistry.h"
+
+#include <atomic>
+
+using namespace GroupMe;
+
+ContactRegistry::ContactRegistry() :
+    m_contacts(std::make_shared<const UserSet>())
+{
+
+}
+
+ContactRegistry::ContactRegistry(ContactRegistry&& other) noexcept :
+    ContactRegistry()
+{
+    *this = std::move(other);
+}
+
+ContactRegistry& ContactRegistry::operator=(ContactRegistry&& other) noexcept {
+    if (this != &other) {
+        std::scoped_lock lock(m_writer, other.m_writer);
+
+        std::shared_ptr<const UserSet> contacts = other.load();
+        other.publish(std::make_shared<const UserSet>());
+        publish(std::move(contacts));
+    }
+    return *this;
+}
+
+std::shared_ptr<const UserSet> ContactRegistry::snapshot() const {
+    return load();
+}
+
+std::shared_ptr<const User> ContactRegistry::find(std::string_view id) const {
+    return find(ID(id));
+}
+
+std::shared_ptr<const User> ContactRegistry::find(const ID& id) const {
+    std::shared_ptr<const UserSet> contacts = load();
+
+    UserSet::const_iterator contact = contacts->find(id);
+    if (contact == contacts->end()) {
+        return nullptr;
+    }
+    return *contact;
+}
+
+std::shared_ptr<const UserRecord> ContactRegistry::findRecord(const ID& id) const {
+    return load()->findRecord(id);
+}
+
+std::size_t ContactRegistry::size() const {
+    return load()->size();
+}
+
+bool ContactRegistry::insert(const std::shared_ptr<User>& contact) {
+    std::lock_guard<std::mutex> lock(m_writer);
+
+    // Nothing is copied when the contact is already there
+    std::shared_ptr<const UserSet> current = load();
+    if (current->contains(contact->getCompactID())) {
+        return false;
+    }
+
+    auto next = std::make_shared<UserSet>(*current);
+    next->insert(std::make_shared<User>(*contact));
+    publish(std::move(next));
+    return true;
+}
+
+void ContactRegistry::assign(const User& contact) {
+    std::lock_guard<std::mutex> lock(m_writer);
+
+    auto next = std::make_shared<UserSet>(*load());
+    next->erase(contact.getCompactID());
+    next->insert(std::make_shared<User>(contact));
+    publish(std::move(next));
+}
+
+void ContactRegistry::merge(UserSet& set) {
+    if (set.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_writer);
+
+    auto next = std::make_shared<UserSet>(*load());
+    next->reserve(next->size() + set.size());
+
+    // The caller can still hold the users of `set`, so copies are published
+    UserSet left;
+    for (const auto& user : set) {
+        if (next->contains(user->getCompactID())) {
+            left.insert(user);
+        }
+        else {
+            next->insert(std::make_shared<User>(*user));
+        }
+    }
+    set = std::move(left);
+
+    publish(std::move(next));
+}
+
+void ContactRegistry::update(const std::function<void(UserSet&)>& update) {
+    std::lock_guard<std::mutex> lock(m_writer);
+
+    auto next = std::make_shared<UserSet>(*load());
+    update(*next);
+    publish(std::move(next));
+}
+
+UserSet::Diff ContactRegistry::replace(UserSet contacts) {
+    // The caller can still hold the users, so copies are published
+    UserSet copies;
+    copies.reserve(contacts.size());
+    for (const auto& user : contacts) {
+        copies.insert(std::make_shared<User>(*user));
+    }
+
+    std::lock_guard<std::mutex> lock(m_writer);
+
+    auto next = std::make_shared<const UserSet>(std::move(copies));
+    UserSet::Diff diff = UserSet::diff(*load(), *next);
+    publish(std::move(next));
+    return diff;
+}
+
+std::shared_ptr<const UserSet> ContactRegistry::load() const {
+    return std::atomic_load_explicit(&m_contacts, std::memory_order_acquire);
+}
+
+void ContactRegistry::publish(std::shared_ptr<const UserSet> contacts) {
+    std::atomic_store_explicit(&m_contacts, std::move(contacts), std::memory_order_release);
+}
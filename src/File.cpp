@@ -17,6 +17,7 @@
  */
 
 #include "File.h"
+#include "util/Json.h"
 
 using namespace GroupMe;
 
@@ -28,134 +29,197 @@ std::string File::getURL(std::string conversationID, std::string filename) {
     return url;
 }
 
+File::State::State(const web::uri& endpoint) :
+    client(endpoint),
+    owners(1)
+{
+    request.set_method(web::http::methods::POST);
+}
 
 File::File(std::string accessToken, std::filesystem::path path, std::string conversationID) :
     Attachment(path, Attachment::Types::File, accessToken),
-    m_request(),
     m_conversationID(conversationID),
-    m_task(),
-    m_json(),
-    m_client(getURL(m_conversationID, path.filename().string()))
+    m_state(std::make_shared<State>(getURL(m_conversationID, path.filename().string())))
 {
     if (!std::filesystem::exists(path)) {
         throw std::filesystem::filesystem_error("File does not exist", std::make_error_code(std::errc::no_such_file_or_directory));
     }
 
-    m_content = m_client.base_uri().to_string();
+    Util::Cancellation::Link link = Util::Cancellation::link({m_state->cancellation.get_token(), m_state->preparation.get_token()});
+    pplx::cancellation_token token = link.getToken();
+
+    m_content->set(m_state->client.base_uri().to_string());
+
+    m_state->content = m_content;
 
-    m_task = pplx::task<void>([this, path]() -> void {
-        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    m_state->request.headers().add("X-Access-Token", m_accessToken);
+    m_state->request.headers().add("Content-Type", "application/json");
+    m_state->request.headers().add("Accept-Encoding", "gzip, deflate");
+    m_state->request.headers().add("Connection", "close");
 
-        m_contentBinary.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_state->task = pplx::task<void>([state = m_state, path]() -> void {
+        std::fstream file(path, std::ios::in | std::ios::binary);
 
-        m_request.set_method(web::http::methods::POST);
-        m_request.headers().add("X-Access-Token", m_accessToken);
-        m_request.headers().add("Content-Type", "application/json");
-        m_request.headers().add("Accept-Encoding", "gzip, deflate");
-        m_request.headers().add("Connection", "close");
+        state->contentBinary.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
 
-    });
+    }, Util::Executors::options(Util::Executors::blocking(), token));
+
+    link.attach(m_state->task);
 }
 
 File::File(std::string accessToken, std::vector<unsigned char> contentVector, std::string conversationID) :
     Attachment(contentVector, Attachment::Types::File, accessToken),
-    m_request(),
     m_conversationID(conversationID),
-    m_task(),
-    m_json(),
-    m_client(getURL(m_conversationID, "file"))
+    m_state(std::make_shared<State>(getURL(m_conversationID, "file")))
 {
-    m_contentBinary = contentVector;
+    m_state->content = m_content;
 
-    m_task = pplx::task<void>([this]() -> void {
+    // The state keeps the only copy, so the one in the attachment isn't needed
+    m_state->contentBinary = std::move(m_contentBinary);
 
-        m_request.set_method(web::http::methods::POST);
-        m_request.headers().add("X-Access-Token", m_accessToken);
-        m_request.headers().add("Content-Type", "application/json");
-        m_request.headers().add("Accept-Encoding", "gzip, deflate");
-        m_request.headers().add("Connection", "close");
+    m_state->request.headers().add("X-Access-Token", m_accessToken);
+    m_state->request.headers().add("Content-Type", "application/json");
+    m_state->request.headers().add("Accept-Encoding", "gzip, deflate");
+    m_state->request.headers().add("Connection", "close");
 
-    });
+    m_state->task = pplx::task_from_result();
 }
 
 File::File(std::string accessToken, web::uri contentURL, std::string conversationID) :
     Attachment(contentURL, Attachment::Types::File, accessToken),
-    m_request(),
     m_conversationID(conversationID),
-    m_task(),
-    m_json(),
-    m_client(contentURL)
+    m_state(std::make_shared<State>(contentURL))
 {
-    m_task = pplx::task<void>([this, contentURL]() -> void {
-        m_request.set_method(web::http::methods::GET);
-
-        m_client.request(m_request).then([this](web::http::http_response response) {
-            std::stringstream strm;
-
-            strm << response.extract_string(true).get();
-
-            m_contentBinary.assign(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
-        }).wait();
-        m_client = web::http::client::http_client(getURL(m_conversationID, contentURL.split_path(contentURL.path()).at(contentURL.split_path(contentURL.path()).size() - 1)));
-        m_request.set_body("");
-
-        m_request.set_method(web::http::methods::POST);
-        m_request.headers().add("X-Access-Token", m_accessToken);
-        m_request.headers().add("Content-Type", "application/json");
-        m_request.headers().add("Accept-Encoding", "gzip, deflate");
-        m_request.headers().add("Connection", "close");
-        m_request.set_body("");
-    });
-}
-
-File::~File() {
-    m_task.wait();
-}
+    Util::Cancellation::Link link = Util::Cancellation::link({m_state->cancellation.get_token(), m_state->preparation.get_token()});
+    pplx::cancellation_token token = link.getToken();
 
-pplx::task<std::string> File::upload() {
-    m_task.wait();
+    m_state->content = m_content;
 
-    m_request.set_body(m_contentBinary);
+    m_state->request.set_method(web::http::methods::GET);
 
-    return pplx::task<std::string>([this]() -> std::string{
+    m_state->task = m_state->client.request(m_state->request, token).then([](const web::http::http_response& response) {
+        return response.extract_vector();
+    }, Util::Executors::options(Util::Executors::io(), token)).then([state = m_state, accessToken = m_accessToken, conversationID = m_conversationID, contentURL](const std::vector<unsigned char>& content) {
+        state->contentBinary = content;
 
-        m_json = nlohmann::json::parse(m_client.request(m_request).get().extract_string(true).get());
+        state->client = web::http::client::http_client(getURL(conversationID, contentURL.split_path(contentURL.path()).at(contentURL.split_path(contentURL.path()).size() - 1)));
+        state->request.set_body("");
 
-        m_content = m_json["status_url"].dump();
+        state->request.set_method(web::http::methods::POST);
+        state->request.headers().add("X-Access-Token", accessToken);
+        state->request.headers().add("Content-Type", "application/json");
+        state->request.headers().add("Accept-Encoding", "gzip, deflate");
+        state->request.headers().add("Connection", "close");
+        state->request.set_body("");
+    }, Util::Executors::options(Util::Executors::io(), token));
 
-        m_content.erase(std::remove(m_content.begin(), m_content.end(), '"'), m_content.end());
+    link.attach(m_state->task);
+}
 
-        m_client = web::http::client::http_client(m_content);
+File::File(const File& other) :
+    Attachment(other),
+    m_conversationID(other.m_conversationID),
+    m_state(other.m_state)
+{
+    acquire();
+}
 
-        m_request.set_method(web::http::methods::GET);
+File::~File() {
+    release();
+}
 
-        m_request.set_body("");
+File& File::operator=(const File& other) {
+    if (this != &other) {
+        release();
+        Attachment::operator=(other);
+        m_conversationID = other.m_conversationID;
+        m_state = other.m_state;
+        acquire();
+    }
+    return *this;
+}
 
-        bool done = false;
+File& File::operator=(File&& other) noexcept {
+    if (this != &other) {
+        release();
+        Attachment::operator=(std::move(other));
+        m_conversationID = std::move(other.m_conversationID);
+        m_state = std::move(other.m_state);
+    }
+    return *this;
+}
 
-        while(!done) {
-            m_client.request(m_request).then([&done, this](web::http::http_response response) {
-                if (response.status_code() == web::http::status_codes::OK) {
+void File::acquire() {
+    if (m_state != nullptr) {
+        m_state->owners.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
-                    std::string content;
+void File::release() {
+    release(m_state);
+    m_state = nullptr;
+}
 
-                    m_json.clear();
+void File::release(const std::shared_ptr<State>& state) {
+    if (state == nullptr || state->owners.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
 
-                    m_json = nlohmann::json::parse(response.extract_string(true).get());
+    state->preparation.cancel();
 
-                    content = m_json["file_id"].dump();
+    // The preparation might still be writing to the buffers, so they're
+    // only freed after it has stopped
+    state->task.then([state](const pplx::task<void>&) {
+        state->contentBinary.clear();
+        state->contentBinary.shrink_to_fit();
+    }, Util::Executors::options(Util::Executors::io(), pplx::cancellation_token::none()));
+}
 
-                    content.erase(std::remove(content.begin(), content.end(), '"'), content.end());
+pplx::task<std::string> File::upload(const pplx::cancellation_token& token, const Util::Deadline& deadline) {
+    Util::Cancellation::Link link = Util::Cancellation::link({token, m_state->cancellation.get_token()}, deadline);
+    pplx::cancellation_token linked = link.getToken();
+
+    // Setting the body copies the whole file, so that part runs on the
+    // CPU scheduler and everything after it is network continuations
+    pplx::task<std::string> upload = m_state->task.then([state = m_state, linked]() {
+        state->request.set_body(state->contentBinary);
+        return state->client.request(state->request, linked);
+    }, Util::Executors::options(Util::Executors::cpu(), linked)).then([](const web::http::http_response& response) {
+        return response.extract_string(true);
+    }, Util::Executors::options(Util::Executors::io(), linked)).then([linked](const std::string& body) {
+        return poll(std::make_shared<web::http::client::http_client>(Util::Json::Document(body).getString("/status_url")), linked);
+    }, Util::Executors::options(Util::Executors::io(), linked)).then([state = m_state](const std::string& content) {
+        state->content->set(content);
+        return content;
+    }, Util::Executors::options(Util::Executors::io(), linked));
+
+    // A running upload keeps the preparation alive just like a copy does
+    m_state->owners.fetch_add(1, std::memory_order_relaxed);
+    upload.then([state = m_state](const pplx::task<std::string>&) {
+        release(state);
+    }, Util::Executors::options(Util::Executors::io(), pplx::cancellation_token::none()));
+
+    return link.attach(upload);
+}
 
-                    m_content = content;
+// Keeps checking the status url until the file is processed. The wait
+// between checks is on the timer, not on a worker.
+pplx::task<std::string> File::poll(const std::shared_ptr<web::http::client::http_client>& client, const pplx::cancellation_token& token) {
+    web::http::http_request request(web::http::methods::GET);
 
-                    done = true;
-                }
-                else {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(300));
-                }
-            }).wait();
+    return client->request(request, token).then([client, token](const web::http::http_response& response) -> pplx::task<std::string> {
+        if (response.status_code() == web::http::status_codes::OK) {
+            return response.extract_string(true).then([](const std::string& body) {
+                return Util::Json::Document(body).getString("/file_id");
+            }, Util::Executors::options(Util::Executors::io(), token));
         }
-        return m_content;
-    });
+
+        return Util::Timer::delay(std::chrono::milliseconds(300), token).then([client, token]() {
+            return poll(client, token);
+        }, Util::Executors::options(Util::Executors::io(), token));
+    }, Util::Executors::options(Util::Executors::io(), token));
+}
+
+void File::cancel() {
+    m_state->cancellation.cancel();
 }
@@ -0,0 +1,163 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Group.h"
+#include "util/Json.h"
+
+#include <memory>
+#include <vector>
+
+using namespace GroupMe;
+
+Group::Group() :
+    m_createdAt(0),
+    m_updatedAt(0),
+    m_messageCount(0)
+{
+
+}
+
+Group Group::createFromJson(Util::Json::Value& json, std::size_t directoryThreshold) {
+    Group group;
+
+    Util::readFields(Schema::group, json, group, [&group, directoryThreshold](std::string_view key, Util::Json::Value& value) {
+        if (value.isNull()) {
+            return;
+        }
+
+        if (key == "members") {
+            std::vector<std::shared_ptr<User>> members;
+            std::shared_ptr<MemberDirectory> directory;
+
+            value.forEachElement([&members, &directory, directoryThreshold](Util::Json::Value& member) {
+                if (directory != nullptr) {
+                    directory->read(member);
+                    return;
+                }
+
+                auto user = std::make_shared<User>();
+                Util::readFields(User::Schema::member, member, *user);
+                members.push_back(std::move(user));
+
+                // The size isn't known until the array ends, so once there are
+                // too many the ones so far are moved into a directory
+                if (members.size() > directoryThreshold) {
+                    directory = std::make_shared<MemberDirectory>();
+                    for (const auto& read : members) {
+                        if (!read->getCompactID().empty()) {
+                            directory->add(read->getID(), read->getNickname(), read->getProfileImageURL());
+                        }
+                    }
+                    members.clear();
+                }
+            });
+
+            if (directory != nullptr) {
+                directory->seal();
+                group.m_directory = std::move(directory);
+            }
+            else {
+                group.m_members = UserSet(std::move(members));
+            }
+        }
+        else if (key == "messages") {
+            value.forEachField([&group](std::string_view key, Util::Json::Value& value) {
+                if (value.isNull()) {
+                    return;
+                }
+
+                if (key == "count") {
+                    group.m_messageCount = static_cast<unsigned int>(value.getUnsigned());
+                }
+                else if (key == "last_message_id") {
+                    group.m_lastMessageID = ID(value.getString());
+                }
+            });
+        }
+    });
+
+    return group;
+}
+
+const ID& Group::getID() const {
+    return m_id;
+}
+
+const std::string& Group::getName() const {
+    return m_name;
+}
+
+const std::string& Group::getType() const {
+    return m_type;
+}
+
+const std::string& Group::getDescription() const {
+    return m_description;
+}
+
+const std::string& Group::getImageURL() const {
+    return m_imageURL;
+}
+
+const std::string& Group::getShareURL() const {
+    return m_shareURL;
+}
+
+const ID& Group::getCreatorID() const {
+    return m_creatorID;
+}
+
+unsigned int Group::getCreatedAt() const {
+    return m_createdAt;
+}
+
+unsigned int Group::getUpdatedAt() const {
+    return m_updatedAt;
+}
+
+unsigned int Group::getMessageCount() const {
+    return m_messageCount;
+}
+
+const ID& Group::getLastMessageID() const {
+    return m_lastMessageID;
+}
+
+const UserSet& Group::getMembers() const {
+    return m_members;
+}
+
+std::shared_ptr<const MemberDirectory> Group::getMemberDirectory() const {
+    return m_directory;
+}
+
+std::shared_ptr<User> Group::findMember(std::string_view userID) const {
+    if (m_directory != nullptr) {
+        return m_directory->find(userID);
+    }
+
+    UserSet::const_iterator member = m_members.find(userID);
+    if (member == m_members.end()) {
+        return nullptr;
+    }
+    return *member;
+}
+
+std::size_t Group::getMemberCount() const {
+    return m_directory != nullptr ? m_directory->size() : m_members.size();
+}
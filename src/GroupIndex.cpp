@@ -0,0 +1,185 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "GroupIndex.h"
+#include "util/Json.h"
+
+using namespace GroupMe;
+
+GroupIndex::State::State() :
+    client(web::uri("https://api.groupme.com/v3/groups"))
+{
+
+}
+
+GroupIndex::GroupIndex(const std::string& accessToken, std::size_t perPage, std::size_t concurrency, std::size_t directoryThreshold) :
+    m_state(std::make_shared<State>())
+{
+    m_state->accessToken = accessToken;
+    // A page size of 0 would never come back short, so paging would never stop
+    m_state->perPage = perPage > 0 && perPage <= 100 ? perPage : 100;
+    m_state->concurrency = concurrency > 0 ? concurrency : 1;
+    m_state->directoryThreshold = directoryThreshold;
+}
+
+GroupIndex::~GroupIndex() {
+    // Nothing can use the results anymore
+    if (m_state != nullptr) {
+        m_state->cancellation.cancel();
+    }
+}
+
+pplx::task<GroupIndex::Groups> GroupIndex::refresh(const pplx::cancellation_token& token, const Util::Deadline& deadline) {
+    Util::Cancellation::Link link = Util::Cancellation::link({token, m_state->cancellation.get_token()}, deadline);
+    pplx::cancellation_token linked = link.getToken();
+
+    auto batch = std::make_shared<Batch>();
+
+    pplx::task<Groups> refreshed = fetchPages(m_state, batch, 1, linked).then([state = m_state, batch]() {
+        Groups groups;
+        for (const auto& page : batch->pages) {
+            groups.insert(groups.end(), page.groups.begin(), page.groups.end());
+        }
+
+        std::unordered_map<ID, std::shared_ptr<const Group>> byID;
+        byID.reserve(groups.size());
+        for (const auto& group : groups) {
+            byID.emplace(group->getID(), group);
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->pages = std::move(batch->pages);
+        state->groups = groups;
+        state->byID = std::move(byID);
+        state->fetchedAt = Util::Deadline::Clock::now();
+        state->fetched = true;
+
+        return groups;
+    }, Util::Executors::options(Util::Executors::cpu(), linked));
+
+    return link.attach(refreshed);
+}
+
+pplx::task<GroupIndex::Groups> GroupIndex::get(std::chrono::seconds maxAge, const pplx::cancellation_token& token, const Util::Deadline& deadline) {
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (m_state->fetched && Util::Deadline::Clock::now() - m_state->fetchedAt < maxAge) {
+            return pplx::task_from_result(m_state->groups);
+        }
+    }
+    return refresh(token, deadline);
+}
+
+std::shared_ptr<const Group> GroupIndex::find(const ID& id) const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+
+    auto group = m_state->byID.find(id);
+    if (group == m_state->byID.end()) {
+        return nullptr;
+    }
+    return group->second;
+}
+
+GroupIndex::Groups GroupIndex::getCached() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->groups;
+}
+
+void GroupIndex::cancel() {
+    m_state->cancellation.cancel();
+}
+
+pplx::task<void> GroupIndex::fetchPages(const std::shared_ptr<State>& state, const std::shared_ptr<Batch>& batch, std::size_t first, const pplx::cancellation_token& token) {
+    std::vector<pplx::task<Page>> tasks;
+    tasks.reserve(state->concurrency);
+    for (std::size_t page = first; page < first + state->concurrency; page++) {
+        tasks.push_back(fetchPage(state, page, token));
+    }
+
+    return pplx::when_all(tasks.begin(), tasks.end()).then([state, batch, first, token](std::vector<Page> pages) {
+        // A page that isn't full is the last one, the pages after it are empty
+        for (auto& page : pages) {
+            bool last = page.groups.size() < state->perPage;
+            batch->pages.push_back(std::move(page));
+            if (last) {
+                return pplx::task_from_result();
+            }
+        }
+        return fetchPages(state, batch, first + pages.size(), token);
+    }, Util::Executors::options(Util::Executors::cpu(), token));
+}
+
+pplx::task<GroupIndex::Page> GroupIndex::fetchPage(const std::shared_ptr<State>& state, std::size_t page, const pplx::cancellation_token& token) {
+    std::string etag;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (page <= state->pages.size()) {
+            etag = state->pages[page - 1].etag;
+        }
+    }
+
+    web::uri_builder uri;
+    uri.append_query("page", page);
+    uri.append_query("per_page", state->perPage);
+
+    web::http::http_request request(web::http::methods::GET);
+
+    request.set_request_uri(uri.to_uri());
+    request.headers().add("X-Access-Token", state->accessToken);
+
+    // The server answers with 304 and no body if the page is the same
+    if (!etag.empty()) {
+        request.headers().add("If-None-Match", etag);
+    }
+
+    return state->client.request(request, token).then([state, page, token](const web::http::http_response& response) {
+        if (response.status_code() == web::http::status_codes::NotModified) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+
+            // The cache was replaced by a refresh with fewer pages
+            if (page > state->pages.size()) {
+                throw web::http::http_exception(response.status_code());
+            }
+            return pplx::task_from_result(state->pages[page - 1]);
+        }
+
+        if (response.status_code() != web::http::status_codes::OK) {
+            throw web::http::http_exception(response.status_code());
+        }
+
+        Page result;
+        response.headers().match("ETag", result.etag);
+
+        // Parsing is CPU work, so it is moved off of the I/O scheduler
+        std::size_t directoryThreshold = state->directoryThreshold;
+        return response.extract_string(true).then([result = std::move(result), directoryThreshold](const std::string& body) mutable {
+            Util::Json::Document document(body);
+
+            document.forEachField([&result, directoryThreshold](std::string_view key, Util::Json::Value& value) {
+                // The response section of the JSON will be null if a problem occured
+                if (key == "response" && !value.isNull()) {
+                    value.forEachElement([&result, directoryThreshold](Util::Json::Value& group) {
+                        result.groups.push_back(std::make_shared<const Group>(Group::createFromJson(group, directoryThreshold)));
+                    });
+                }
+            });
+
+            return std::move(result);
+        }, Util::Executors::options(Util::Executors::cpu(), token));
+    }, Util::Executors::options(Util::Executors::io(), token));
+}
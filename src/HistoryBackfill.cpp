@@ -0,0 +1,173 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "HistoryBackfill.h"
+#include "util/Executors.h"
+
+using namespace GroupMe;
+
+double HistoryBackfill::Progress::pagesPerSecond() const {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? static_cast<double>(pages) / seconds : 0;
+}
+
+double HistoryBackfill::Progress::bytesPerSecond() const {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? static_cast<double>(bytes) / seconds : 0;
+}
+
+void HistoryBackfill::Counters::add(const MessagePage& page) {
+    pages.fetch_add(1, std::memory_order_relaxed);
+    messages.fetch_add(page.size(), std::memory_order_relaxed);
+    bytes.fetch_add(page.getBody().size(), std::memory_order_relaxed);
+}
+
+HistoryBackfill::Progress HistoryBackfill::Counters::snapshot() const {
+    Progress progress;
+    progress.pages = pages.load(std::memory_order_relaxed);
+    progress.messages = messages.load(std::memory_order_relaxed);
+    progress.bytes = bytes.load(std::memory_order_relaxed);
+    progress.elapsed = Util::Deadline::Clock::now() - started;
+    return progress;
+}
+
+HistoryBackfill::State::State() :
+    client(web::uri("https://api.groupme.com/v3/groups"))
+{
+
+}
+
+HistoryBackfill::HistoryBackfill(const std::string& accessToken, std::size_t concurrency, std::size_t limit) :
+    m_state(std::make_shared<State>())
+{
+    m_state->accessToken = accessToken;
+    m_state->limit = limit > 0 && limit <= 100 ? limit : 100;
+    m_state->limiter = Util::Limiter::create(concurrency);
+}
+
+HistoryBackfill::~HistoryBackfill() {
+    // Nothing can receive the pages anymore
+    if (m_state != nullptr) {
+        m_state->cancellation.cancel();
+    }
+}
+
+pplx::task<HistoryBackfill::Progress> HistoryBackfill::run(const ID& group, Sink sink, const ID& beforeID, const pplx::cancellation_token& token, const Util::Deadline& deadline) {
+    Util::Cancellation::Link link = Util::Cancellation::link({token, m_state->cancellation.get_token()}, deadline);
+    pplx::cancellation_token linked = link.getToken();
+
+    auto run = std::make_shared<Run>();
+    run->sink = std::move(sink);
+
+    pplx::task<Progress> progress = backfill(m_state, run, group, beforeID, pplx::task_from_result(), linked).then([run]() {
+        return run->counters.snapshot();
+    });
+
+    return link.attach(progress);
+}
+
+pplx::task<HistoryBackfill::Progress> HistoryBackfill::run(const std::vector<ID>& groups, Sink sink, const pplx::cancellation_token& token, const Util::Deadline& deadline) {
+    Util::Cancellation::Link link = Util::Cancellation::link({token, m_state->cancellation.get_token()}, deadline);
+    pplx::cancellation_token linked = link.getToken();
+
+    auto run = std::make_shared<Run>();
+    run->sink = std::move(sink);
+
+    std::vector<pplx::task<void>> tasks;
+    tasks.reserve(groups.size());
+    for (const auto& group : groups) {
+        tasks.push_back(backfill(m_state, run, group, ID(), pplx::task_from_result(), linked));
+    }
+
+    pplx::task<Progress> progress = pplx::when_all(tasks.begin(), tasks.end()).then([run]() {
+        return run->counters.snapshot();
+    });
+
+    return link.attach(progress);
+}
+
+HistoryBackfill::Progress HistoryBackfill::getProgress() const {
+    return m_state->total.snapshot();
+}
+
+void HistoryBackfill::cancel() {
+    m_state->cancellation.cancel();
+}
+
+pplx::task<std::shared_ptr<MessagePage>> HistoryBackfill::fetchPage(const std::shared_ptr<State>& state, const ID& group, const ID& beforeID, const pplx::cancellation_token& token) {
+    web::uri_builder uri;
+    uri.append_path(group.toString());
+    uri.append_path("messages");
+    uri.append_query("limit", state->limit);
+    if (!beforeID.empty()) {
+        uri.append_query("before_id", beforeID.toString());
+    }
+
+    web::http::http_request request(web::http::methods::GET);
+
+    request.set_request_uri(uri.to_uri());
+    request.headers().add("X-Access-Token", state->accessToken);
+
+    // The body is read while the permit is held, so the budget counts whole downloads
+    return state->limiter->run([state, request, token]() {
+        return state->client.request(request, token).then([](const web::http::http_response& response) {
+            // The server answers with 304 once there are no messages before `before_id`
+            if (response.status_code() == web::http::status_codes::NotModified) {
+                return pplx::task_from_result(std::string());
+            }
+
+            if (response.status_code() != web::http::status_codes::OK) {
+                throw web::http::http_exception(response.status_code());
+            }
+
+            return response.extract_string(true);
+        }, Util::Executors::options(Util::Executors::io(), token));
+    }, token).then([](const std::string& body) -> std::shared_ptr<MessagePage> {
+        if (body.empty()) {
+            return nullptr;
+        }
+        return std::make_shared<MessagePage>(MessagePage::parse(body));
+    }, Util::Executors::options(Util::Executors::cpu(), token));
+}
+
+pplx::task<void> HistoryBackfill::backfill(const std::shared_ptr<State>& state, const std::shared_ptr<Run>& run, const ID& group, const ID& beforeID, pplx::task<void> delivered, const pplx::cancellation_token& token) {
+    return fetchPage(state, group, beforeID, token).then([state, run, group, delivered, token](const std::shared_ptr<MessagePage>& page) {
+        if (page == nullptr || page->empty()) {
+            return delivered;
+        }
+
+        // Pages come newest first, so the last message is where the next page starts
+        ID oldest((*page)[page->size() - 1].getID());
+        bool last = page->size() < state->limit;
+
+        pplx::task<void> handed = delivered.then([state, run, group, page]() {
+            run->sink(group, *page);
+            run->counters.add(*page);
+            state->total.add(*page);
+        }, Util::Executors::options(Util::Executors::cpu(), token));
+
+        if (last) {
+            return handed;
+        }
+
+        // The next request only waits for the page before this one, so it's
+        // in flight while this page is in the sink
+        return delivered.then([state, run, group, oldest, handed, token]() {
+            return backfill(state, run, group, oldest, handed, token);
+        }, Util::Executors::options(Util::Executors::cpu(), token));
+    }, Util::Executors::options(Util::Executors::cpu(), token));
+}
@@ -0,0 +1,240 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ID.h"
+
+#include <charconv>
+#include <cstring>
+#include <utility>
+
+using namespace GroupMe;
+
+namespace {
+    // The most digits a 64 bit integer can have
+    constexpr std::size_t s_maxDigits = 20;
+
+    // Only canonical decimal is stored as a number, so that the text
+    // comes back out exactly the same
+    bool parseNumber(std::string_view text, uint64_t& number) {
+        if (text.empty() || text.size() > s_maxDigits) {
+            return false;
+        }
+        if (text[0] == '0' && text.size() > 1) {
+            return false;
+        }
+
+        std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), number);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    // Sequential IDs would fill neighbouring slots of a hash table
+    // otherwise, this spreads them out (the splitmix64 finalizer)
+    std::size_t mix(uint64_t number) {
+        number ^= number >> 30;
+        number *= 0xbf58476d1ce4e5b9ULL;
+        number ^= number >> 27;
+        number *= 0x94d049bb133111ebULL;
+        number ^= number >> 31;
+        return static_cast<std::size_t>(number);
+    }
+}
+
+ID::ID() noexcept :
+    m_number(0),
+    m_length(0),
+    m_kind(Kind::Empty)
+{
+
+}
+
+ID::ID(std::string_view id) :
+    ID()
+{
+    if (id.empty()) {
+        return;
+    }
+
+    uint64_t number;
+    if (parseNumber(id, number)) {
+        m_number = number;
+        m_kind = Kind::Number;
+    }
+    else {
+        assignText(id);
+    }
+}
+
+ID::ID(const ID& other) :
+    ID()
+{
+    *this = other;
+}
+
+ID::ID(ID&& other) noexcept :
+    ID()
+{
+    *this = std::move(other);
+}
+
+ID::~ID() {
+    release();
+}
+
+ID& ID::operator=(const ID& other) {
+    if (this == &other) {
+        return *this;
+    }
+
+    if (other.m_kind == Kind::Short || other.m_kind == Kind::Long) {
+        assignText(other.text());
+        return *this;
+    }
+
+    release();
+    m_number = other.m_number;
+    m_kind = other.m_kind;
+    return *this;
+}
+
+ID& ID::operator=(ID&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    release();
+
+    // The whole union is copied, which moves a long ID's pointer over
+    std::memcpy(static_cast<void*>(m_short), static_cast<const void*>(other.m_short), sizeof(m_short));
+    m_length = other.m_length;
+    m_kind = other.m_kind;
+
+    other.m_kind = Kind::Empty;
+    other.m_number = 0;
+    other.m_length = 0;
+    return *this;
+}
+
+ID ID::fromNumber(uint64_t number) {
+    ID id;
+    id.m_number = number;
+    id.m_kind = Kind::Number;
+    return id;
+}
+
+bool ID::empty() const {
+    return m_kind == Kind::Empty;
+}
+
+bool ID::isNumber() const {
+    return m_kind == Kind::Number;
+}
+
+uint64_t ID::getNumber() const {
+    return m_kind == Kind::Number ? m_number : 0;
+}
+
+std::string ID::toString() const {
+    std::string string;
+    appendTo(string);
+    return string;
+}
+
+void ID::appendTo(std::string& out) const {
+    switch (m_kind) {
+        case Kind::Empty:
+            break;
+        case Kind::Number: {
+            char digits[s_maxDigits];
+            std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), m_number);
+            out.append(digits, result.ptr);
+            break;
+        }
+        case Kind::Short:
+        case Kind::Long:
+            out.append(text());
+            break;
+    }
+}
+
+std::size_t ID::hash() const {
+    switch (m_kind) {
+        case Kind::Empty:
+            return 0;
+        case Kind::Number:
+            return mix(m_number);
+        case Kind::Short:
+        case Kind::Long:
+            break;
+    }
+    return std::hash<std::string_view>()(text());
+}
+
+int ID::compare(const ID& other) const {
+    // Short and long are both text, so they rank the same
+    auto rank = [](Kind kind) {
+        return kind == Kind::Long ? static_cast<int>(Kind::Short) : static_cast<int>(kind);
+    };
+
+    int difference = rank(m_kind) - rank(other.m_kind);
+    if (difference != 0) {
+        return difference;
+    }
+
+    switch (m_kind) {
+        case Kind::Empty:
+            return 0;
+        case Kind::Number:
+            return m_number < other.m_number ? -1 : (m_number > other.m_number ? 1 : 0);
+        case Kind::Short:
+        case Kind::Long:
+            break;
+    }
+    return text().compare(other.text());
+}
+
+std::string_view ID::text() const {
+    if (m_kind == Kind::Long) {
+        return std::string_view(m_long.data, m_long.size);
+    }
+    return std::string_view(m_short, m_length);
+}
+
+void ID::assignText(std::string_view text) {
+    release();
+
+    if (text.size() <= s_shortCapacity) {
+        std::memcpy(m_short, text.data(), text.size());
+        m_length = static_cast<uint8_t>(text.size());
+        m_kind = Kind::Short;
+    }
+    else {
+        char* data = new char[text.size()];
+        std::memcpy(data, text.data(), text.size());
+        m_long = {data, text.size()};
+        m_kind = Kind::Long;
+    }
+}
+
+void ID::release() {
+    if (m_kind == Kind::Long) {
+        delete[] m_long.data;
+    }
+    m_kind = Kind::Empty;
+    m_number = 0;
+    m_length = 0;
+}
@@ -0,0 +1,156 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "IdentityTable.h"
+
+#include <mutex>
+
+using namespace GroupMe;
+
+IdentityTable& IdentityTable::global() {
+    static IdentityTable s_table;
+    return s_table;
+}
+
+IdentityTable::Entry::Entry(const ID& id) :
+    id(id)
+{
+
+}
+
+UserHandle IdentityTable::intern(const ID& userID) {
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+        UserHandle handle = findLocked(userID);
+        if (handle.isValid()) {
+            return handle;
+        }
+    }
+
+    return insert(userID);
+}
+
+UserHandle IdentityTable::intern(std::string_view userID) {
+    return intern(ID(userID));
+}
+
+UserHandle IdentityTable::intern(std::string_view userID, std::string_view nickname, std::string_view avatarURL) {
+    ID id(userID);
+
+    UserHandle handle;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        handle = findLocked(id);
+    }
+
+    if (!handle.isValid()) {
+        handle = insert(id);
+    }
+
+    // Almost every message is from a user that was already seen with the
+    // same nickname and avatar, so that's only a compare under the entry's lock
+    Entry& current = entry(handle);
+
+    std::lock_guard<std::mutex> lock(current.mutex);
+    if (current.nickname != nickname || current.avatarURL != avatarURL) {
+        current.nickname = nickname;
+        current.avatarURL = avatarURL;
+
+        // Users that were already handed out keep the old identity
+        current.user.reset();
+    }
+
+    return handle;
+}
+
+UserHandle IdentityTable::insert(const ID& userID) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    // Someone else could have interned it while the lock was let go
+    UserHandle handle = findLocked(userID);
+    if (handle.isValid()) {
+        return handle;
+    }
+
+    m_entries.emplace_back(userID);
+
+    handle = UserHandle(static_cast<uint32_t>(m_entries.size()));
+    m_handles.emplace(userID, handle.value());
+
+    return handle;
+}
+
+UserHandle IdentityTable::find(std::string_view userID) const {
+    ID id(userID);
+
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return findLocked(id);
+}
+
+UserHandle IdentityTable::findLocked(const ID& userID) const {
+    auto found = m_handles.find(userID);
+    if (found == m_handles.end()) {
+        return UserHandle();
+    }
+
+    return UserHandle(found->second);
+}
+
+const ID& IdentityTable::getID(UserHandle handle) const {
+    return entry(handle).id;
+}
+
+std::string IdentityTable::getNickname(UserHandle handle) const {
+    const Entry& current = entry(handle);
+
+    std::lock_guard<std::mutex> lock(current.mutex);
+    return current.nickname;
+}
+
+std::string IdentityTable::getAvatarURL(UserHandle handle) const {
+    const Entry& current = entry(handle);
+
+    std::lock_guard<std::mutex> lock(current.mutex);
+    return current.avatarURL;
+}
+
+std::shared_ptr<User> IdentityTable::getUser(UserHandle handle) {
+    Entry& current = entry(handle);
+
+    std::lock_guard<std::mutex> lock(current.mutex);
+
+    std::shared_ptr<User> user = current.user.lock();
+    if (user == nullptr) {
+        user = std::make_shared<User>(current.id.toString(), current.nickname, current.avatarURL, "", "", "");
+        current.user = user;
+    }
+
+    return user;
+}
+
+std::size_t IdentityTable::size() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+IdentityTable::Entry& IdentityTable::entry(UserHandle handle) const {
+    // Taken just long enough to index, the entry itself never moves
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_entries[handle.value() - 1];
+}
@@ -0,0 +1,293 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "MemberDirectory.h"
+#include "util/Json.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace GroupMe;
+
+MemberDirectory::MemberDirectory(std::size_t capacity) :
+    m_capacity(capacity)
+{
+
+}
+
+MemberDirectory::MemberDirectory(MemberDirectory&& other) noexcept :
+    MemberDirectory(0)
+{
+    *this = std::move(other);
+}
+
+MemberDirectory& MemberDirectory::operator=(MemberDirectory&& other) noexcept {
+    if (this != &other) {
+        std::scoped_lock lock(m_mutex, other.m_mutex);
+
+        m_entries = std::move(other.m_entries);
+        m_text = std::move(other.m_text);
+        m_capacity = other.m_capacity;
+        m_recent = std::move(other.m_recent);
+        m_cache = std::move(other.m_cache);
+        m_live = std::move(other.m_live);
+
+        other.m_entries.clear();
+        other.m_text.clear();
+        other.m_recent.clear();
+        other.m_cache.clear();
+        other.m_live.clear();
+    }
+    return *this;
+}
+
+MemberDirectory MemberDirectory::createFromJson(Util::Json::Value& members, std::size_t capacity) {
+    MemberDirectory directory(capacity);
+
+    members.forEachElement([&directory](Util::Json::Value& member) {
+        directory.read(member);
+    });
+
+    directory.seal();
+
+    return directory;
+}
+
+std::shared_ptr<User> MemberDirectory::find(const ID& id) const {
+    const Entry* entry = lookup(id);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+
+    uint32_t index = static_cast<uint32_t>(entry - m_entries.data());
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::shared_ptr<User> user = reuse(index);
+        if (user != nullptr) {
+            return user;
+        }
+    }
+
+    // Built outside of the lock, if another thread beat us to it we use theirs
+    std::shared_ptr<User> user = build(*entry);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::shared_ptr<User> existing = reuse(index);
+    if (existing != nullptr) {
+        return existing;
+    }
+
+    remember(index, user);
+
+    return user;
+}
+
+std::shared_ptr<User> MemberDirectory::find(std::string_view id) const {
+    return find(ID(id));
+}
+
+bool MemberDirectory::contains(const ID& id) const {
+    return lookup(id) != nullptr;
+}
+
+std::size_t MemberDirectory::size() const {
+    return m_entries.size();
+}
+
+std::size_t MemberDirectory::cached() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recent.size();
+}
+
+std::size_t MemberDirectory::capacity() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_capacity;
+}
+
+void MemberDirectory::setCapacity(std::size_t capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity;
+    evict();
+}
+
+UserSet MemberDirectory::toUserSet() const {
+    std::vector<std::shared_ptr<User>> users;
+    users.reserve(m_entries.size());
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (std::size_t i = 0; i < m_entries.size(); i++) {
+            auto cached = m_cache.find(static_cast<uint32_t>(i));
+            if (cached != m_cache.end()) {
+                users.push_back(cached->second->user);
+            }
+            else {
+                users.push_back(i < m_live.size() ? m_live[i].lock() : nullptr);
+            }
+        }
+    }
+
+    std::vector<uint32_t> built;
+    for (std::size_t i = 0; i < m_entries.size(); i++) {
+        if (users[i] == nullptr) {
+            users[i] = build(m_entries[i]);
+            built.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    // Later lookups hand out the same users as the set, as long as it's alive
+    if (!built.empty()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_live.empty()) {
+            m_live.resize(m_entries.size());
+        }
+        for (uint32_t index : built) {
+            std::shared_ptr<User> existing = m_live[index].lock();
+            if (existing != nullptr) {
+                users[index] = existing;
+            }
+            else {
+                m_live[index] = users[index];
+            }
+        }
+    }
+
+    return UserSet(std::move(users));
+}
+
+void MemberDirectory::add(std::string_view userID, std::string_view nickname, std::string_view imageURL) {
+    constexpr std::size_t maxLength = std::numeric_limits<uint16_t>::max();
+
+    nickname = nickname.substr(0, maxLength);
+    imageURL = imageURL.substr(0, maxLength);
+
+    m_entries.push_back({ID(userID), static_cast<uint32_t>(m_text.size()), static_cast<uint16_t>(nickname.size()), static_cast<uint16_t>(imageURL.size())});
+
+    m_text.append(nickname);
+    m_text.append(imageURL);
+}
+
+void MemberDirectory::read(Util::Json::Value& member) {
+    std::string_view userID;
+    std::string_view nickname;
+    std::string_view imageURL;
+
+    // The views are only used before the next member is read
+    member.forEachField([&](std::string_view key, Util::Json::Value& value) {
+        if (value.isNull()) {
+            return;
+        }
+
+        if (key == "user_id") {
+            userID = value.getString();
+        }
+        else if (key == "nickname") {
+            nickname = value.getString();
+        }
+        else if (key == "image_url") {
+            imageURL = value.getString();
+        }
+    });
+
+    if (!userID.empty()) {
+        add(userID, nickname, imageURL);
+    }
+}
+
+void MemberDirectory::seal() {
+    // Stable, so the first of the duplicates is the one that's kept
+    std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.id < rhs.id;
+    });
+
+    m_entries.erase(std::unique(m_entries.begin(), m_entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.id == rhs.id;
+    }), m_entries.end());
+
+    m_entries.shrink_to_fit();
+    m_text.shrink_to_fit();
+}
+
+const MemberDirectory::Entry* MemberDirectory::lookup(const ID& id) const {
+    auto entry = std::lower_bound(m_entries.begin(), m_entries.end(), id, [](const Entry& lhs, const ID& rhs) {
+        return lhs.id < rhs;
+    });
+
+    if (entry == m_entries.end() || entry->id != id) {
+        return nullptr;
+    }
+    return &*entry;
+}
+
+std::shared_ptr<User> MemberDirectory::build(const Entry& entry) const {
+    std::string_view text(m_text);
+
+    auto user = std::make_shared<User>();
+    user->setID(entry.id.toString());
+    user->setNickname(std::string(text.substr(entry.offset, entry.nicknameLength)));
+    user->setProfileImageURL(std::string(text.substr(entry.offset + entry.nicknameLength, entry.imageLength)));
+
+    return user;
+}
+
+std::shared_ptr<User> MemberDirectory::reuse(uint32_t index) const {
+    auto cached = m_cache.find(index);
+    if (cached != m_cache.end()) {
+        m_recent.splice(m_recent.begin(), m_recent, cached->second);
+        return cached->second->user;
+    }
+
+    if (index >= m_live.size()) {
+        return nullptr;
+    }
+
+    // It was evicted, but a message or a set still holds it
+    std::shared_ptr<User> user = m_live[index].lock();
+    if (user != nullptr && m_capacity > 0) {
+        m_recent.push_front({index, user});
+        m_cache.emplace(index, m_recent.begin());
+        evict();
+    }
+    return user;
+}
+
+void MemberDirectory::remember(uint32_t index, const std::shared_ptr<User>& user) const {
+    if (m_live.empty()) {
+        m_live.resize(m_entries.size());
+    }
+    m_live[index] = user;
+
+    if (m_capacity == 0) {
+        return;
+    }
+
+    m_recent.push_front({index, user});
+    m_cache.emplace(index, m_recent.begin());
+    evict();
+}
+
+void MemberDirectory::evict() const {
+    while (m_recent.size() > m_capacity) {
+        m_cache.erase(m_recent.back().entry);
+        m_recent.pop_back();
+    }
+}
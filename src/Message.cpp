@@ -17,6 +17,11 @@
 */
 
 #include "Message.h"
+#include "util/MessageParser.h"
+#include "util/Json.h"
+
+#include <algorithm>
+#include <queue>
 
 using namespace GroupMe;
 
@@ -26,6 +31,7 @@ Message::Message(const std::shared_ptr<GroupMe::User> &sender, const std::string
     m_pinned(),
     m_pinnedAt(),
     m_sender(sender),
+    m_senderHandle(sender != nullptr ? IdentityTable::global().intern(sender->getCompactID()) : UserHandle()),
     m_text(message)
 {
 
@@ -46,7 +52,8 @@ Message::Message(const std::shared_ptr<GroupMe::User> &sender, const std::string
     m_createdAt(),
     m_pinned(),
     m_pinnedAt(),
-    m_sender(sender)
+    m_sender(sender),
+    m_senderHandle(sender != nullptr ? IdentityTable::global().intern(sender->getCompactID()) : UserHandle())
 {
 
 }
@@ -61,51 +68,149 @@ Message::Message(const std::string& GUID) :
 }
 
 Message Message::createFromJson(const nlohmann::json &json, const UserSet &users) {
-    Message message;
+    Util::MessageFields fields;
 
-    message.setID(json["id"]);
-    message.setCreatedAt(json["created_at"]);
+    fields.id = json["id"];
+    fields.createdAt = json["created_at"];
+    fields.userID = json["user_id"];
+    fields.name = json["name"];
+    fields.avatarURL = json["avatar_url"];
 
-    UserSet::iterator sender = users.find(json["user_id"]);
-
-    if (sender != users.cend()) {
-        message.setSender(*sender);
-    }
-    else {
-        message.setSender(std::make_shared<User>(json["user_id"], json["name"], json["avatar_url"], "", "", ""));
+    if (!json["text"].is_null()) {
+        fields.text = json["text"];
     }
-    
-    message.attach(json["text"]);
 
     for (const auto& user : json["favorited_by"]) {
-        UserSet::iterator itUser = users.find(user);
-        if (itUser != users.cend()) {
-            message.addFavorited(*itUser);
-        }
+        fields.favoritedBy.push_back(user);
     }
 
     if (!json["attachments"].is_null()) {
         for (const auto& attachment : json["attachments"]) {
-            if (attachment["type"] == "image") {
-                message.attach(Attachment(web::uri(attachment["url"]), Attachment::Types::Picture));
-            }
-            else if (attachment["type"] == "file") {
-                message.attach(Attachment(std::string(attachment["file_id"]), Attachment::Types::File));
+            fields.attachments.push_back({attachment.value("type", ""), attachment.value("url", ""), attachment.value("file_id", "")});
+        }
+    }
+    return fields.build(users);
+}
+
+Message Message::createFromJson(Util::Json::Value& json, const UserSet& users) {
+    Util::MessageFields fields;
+
+    fields.read(json);
+
+    return fields.build(users);
+}
+
+Message Message::createFromJson(Util::Json::Value& json, const MemberDirectory& members) {
+    Util::MessageFields fields;
+
+    fields.read(json);
+
+    return fields.build(members);
+}
+
+std::vector<Message> Message::createFromPage(const std::string& page, const UserSet& users) {
+    std::vector<Message> messages;
+
+    Util::parseMessagePage(page, [&messages, &users](Util::MessageFields& message) {
+        messages.push_back(message.build(users));
+    });
+
+    return messages;
+}
+
+std::vector<Message> Message::createFromPage(const std::string& page, const MemberDirectory& members) {
+    std::vector<Message> messages;
+
+    Util::parseMessagePage(page, [&messages, &members](Util::MessageFields& message) {
+        messages.push_back(message.build(members));
+    });
+
+    return messages;
+}
+
+pplx::task<std::vector<Message>> Message::createFromPages(std::vector<std::string> pages, const UserSet& users, const std::shared_ptr<pplx::scheduler_interface>& scheduler, const pplx::cancellation_token& token) {
+    // Shared by the tasks so the caller doesn't have to keep anything alive.
+    // Every page gets its own slot, so the tasks never write to the same thing
+    struct Batch {
+        std::vector<std::string> pages;
+
+        UserSet users;
+
+        std::vector<std::vector<Message>> decoded;
+    };
+
+    auto batch = std::make_shared<Batch>();
+    batch->pages = std::move(pages);
+    batch->users = users;
+    batch->decoded.resize(batch->pages.size());
+
+    pplx::task_options options = Util::Executors::options(scheduler, token);
+
+    std::vector<pplx::task<void>> tasks;
+    tasks.reserve(batch->pages.size());
+
+    for (std::size_t i = 0; i < batch->pages.size(); i++) {
+        tasks.push_back(pplx::create_task([batch, i]() {
+            std::vector<Message> messages = createFromPage(batch->pages[i], batch->users);
+
+            // Pages come newest first, so this is usually just a reverse
+            std::reverse(messages.begin(), messages.end());
+            std::stable_sort(messages.begin(), messages.end(), [](const Message& lhs, const Message& rhs) {
+                return lhs.getCreatedAt() < rhs.getCreatedAt();
+            });
+
+            batch->decoded[i] = std::move(messages);
+        }, options));
+    }
+
+    return pplx::when_all(tasks.begin(), tasks.end(), options).then([batch]() {
+        // A k way merge of the sorted pages, ties go to the earlier page
+        using Cursor = std::pair<std::size_t, std::size_t>;
+
+        auto later = [&batch](const Cursor& lhs, const Cursor& rhs) {
+            unsigned int left = batch->decoded[lhs.first][lhs.second].getCreatedAt();
+            unsigned int right = batch->decoded[rhs.first][rhs.second].getCreatedAt();
+            return left != right ? left > right : lhs.first > rhs.first;
+        };
+
+        std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heads(later);
+
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < batch->decoded.size(); i++) {
+            total += batch->decoded[i].size();
+            if (!batch->decoded[i].empty()) {
+                heads.emplace(i, 0);
             }
-            else if (attachment["type"] == "video") {
-                message.attach(Attachment(std::string(attachment["url"]), Attachment::Types::Video));
+        }
+
+        std::vector<Message> messages;
+        messages.reserve(total);
+
+        while (!heads.empty()) {
+            Cursor head = heads.top();
+            heads.pop();
+
+            messages.push_back(std::move(batch->decoded[head.first][head.second]));
+
+            if (++head.second < batch->decoded[head.first].size()) {
+                heads.push(head);
             }
         }
-    }
-    return message;
+
+        return messages;
+    }, options);
 }
 
 std::string Message::getID() const {
-    return m_id;
+    return m_id.toString();
 }
 
 void Message::setID(const std::string& id) {
-    m_id = id;
+    m_id = GroupMe::ID(id);
+}
+
+const GroupMe::ID& Message::getCompactID() const {
+    return m_id;
 }
 
 unsigned int Message::getCreatedAt() const {
@@ -136,10 +241,26 @@ std::shared_ptr<const GroupMe::User> Message::getSender() const {
     return std::const_pointer_cast<const GroupMe::User>(m_sender);
 }
 
+std::shared_ptr<const GroupMe::UserRecord> Message::getSenderRecord() const {
+    if (m_sender == nullptr) {
+        return nullptr;
+    }
+    return m_sender->getRecord();
+}
+
 void Message::setSender(const std::shared_ptr<GroupMe::User>& sender) {
     m_sender = sender;
+    m_senderHandle = sender != nullptr ? IdentityTable::global().intern(sender->getCompactID()) : UserHandle();
+}
+
+UserHandle Message::getSenderHandle() const {
+    return m_senderHandle;
 }
 
 void Message::addFavorited(const std::shared_ptr<GroupMe::User> &favoritedBy) {
     m_favoritedBy.push_back(favoritedBy);
 }
+
+const std::vector<std::shared_ptr<GroupMe::User>>& Message::getFavorited() const {
+    return m_favoritedBy;
+}
@@ -0,0 +1,1018 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "MessageLog.h"
+#include "util/MessageParser.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace GroupMe;
+
+namespace {
+    // The file names in the directory of a log
+    constexpr const char* s_idIndexName = "ids.idx";
+    constexpr const char* s_timeIndexName = "time.idx";
+    constexpr const char* s_segmentExtension = ".log";
+
+    // Every record starts with the length of its payload and a checksum of it
+    constexpr std::size_t s_recordHeader = 8;
+
+    // The smallest segment, so that any message fits in one
+    constexpr std::size_t s_minSegmentSize = 1024 * 1024;
+
+    constexpr uint64_t s_idIndexMagic = 0x31584449474f4c4d;
+    constexpr uint64_t s_initialCapacity = 1024;
+
+    // The start of `ids.idx`, followed by `capacity` slots
+    struct IDIndexHeader {
+        uint64_t magic;
+
+        uint64_t capacity;
+
+        uint64_t count;
+
+        // The records before this were all indexed
+        uint32_t coveredSegment;
+
+        uint32_t coveredOffset;
+
+        uint64_t reserved[4];
+    };
+
+    // An empty slot has a location of 0, otherwise it's `(segment << 32 | offset) + 1`
+    struct IDIndexSlot {
+        uint64_t key;
+
+        uint64_t location;
+    };
+
+    // IDs are stored with a tag, numbers as a varint and anything else as a string
+    enum IDTag : uint8_t {
+        Number = 0,
+        Text = 1
+    };
+
+    [[noreturn]] void fail(const char* what) {
+        throw std::fstream::failure(what, std::error_code(errno, std::generic_category()));
+    }
+
+    void writeVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    bool readVarint(std::string_view& in, uint64_t& value) {
+        value = 0;
+        for (unsigned int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(in.front());
+            in.remove_prefix(1);
+
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void writeString(std::string& out, std::string_view string) {
+        writeVarint(out, string.size());
+        out.append(string);
+    }
+
+    bool readString(std::string_view& in, std::string_view& string) {
+        uint64_t length;
+        if (!readVarint(in, length) || length > in.size()) {
+            return false;
+        }
+        string = in.substr(0, length);
+        in.remove_prefix(length);
+        return true;
+    }
+
+    void writeID(std::string& out, const ID& id) {
+        if (id.isNumber()) {
+            out.push_back(static_cast<char>(IDTag::Number));
+            writeVarint(out, id.getNumber());
+        }
+        else {
+            out.push_back(static_cast<char>(IDTag::Text));
+            writeString(out, id.toString());
+        }
+    }
+
+    bool readID(std::string_view& in, ID& id) {
+        if (in.empty()) {
+            return false;
+        }
+
+        uint8_t tag = static_cast<uint8_t>(in.front());
+        in.remove_prefix(1);
+
+        if (tag == IDTag::Number) {
+            uint64_t number;
+            if (!readVarint(in, number)) {
+                return false;
+            }
+            id = ID::fromNumber(number);
+            return true;
+        }
+
+        std::string_view text;
+        if (tag != IDTag::Text || !readString(in, text)) {
+            return false;
+        }
+        id = ID(text);
+        return true;
+    }
+
+    uint32_t checksum(std::string_view data) {
+        // FNV-1a, it only has to catch records that were cut off
+        uint32_t hash = 2166136261u;
+        for (char byte : data) {
+            hash ^= static_cast<uint8_t>(byte);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // The key of an ID in the hash table. This is stored on disk, so it
+    // can't use `std::hash`, which can change between builds
+    uint64_t indexKey(const ID& id) {
+        if (id.isNumber()) {
+            return id.getNumber();
+        }
+
+        uint64_t hash = 14695981039346656037ull;
+        for (char byte : id.toString()) {
+            hash ^= static_cast<uint8_t>(byte);
+            hash *= 1099511628211ull;
+        }
+        return hash | (uint64_t(1) << 63);
+    }
+
+    // Numbers are mostly sequential, so they're mixed before they pick a slot
+    uint64_t mix(uint64_t key) {
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ull;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebull;
+        key ^= key >> 31;
+        return key;
+    }
+
+    std::string segmentName(uint32_t segment) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "%08u", segment);
+        return std::string(name) + s_segmentExtension;
+    }
+
+    uint32_t readUint32(const char* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+}
+
+const ID& MessageLog::Record::getID() const {
+    return m_id;
+}
+
+uint64_t MessageLog::Record::getCreatedAt() const {
+    return m_createdAt;
+}
+
+const ID& MessageLog::Record::getUserID() const {
+    return m_userID;
+}
+
+std::string_view MessageLog::Record::getName() const {
+    return m_name;
+}
+
+std::string_view MessageLog::Record::getAvatarURL() const {
+    return m_avatarURL;
+}
+
+std::string_view MessageLog::Record::getText() const {
+    return m_text;
+}
+
+const std::vector<ID>& MessageLog::Record::getFavoritedBy() const {
+    return m_favoritedBy;
+}
+
+const std::vector<MessagePage::AttachmentView>& MessageLog::Record::getAttachments() const {
+    return m_attachments;
+}
+
+namespace {
+    Util::MessageFields toFields(const MessageLog::Record& record) {
+        Util::MessageFields fields;
+
+        fields.id = record.getID().toString();
+        fields.createdAt = record.getCreatedAt();
+        fields.userID = record.getUserID().toString();
+        fields.name = record.getName();
+        fields.avatarURL = record.getAvatarURL();
+        fields.text = record.getText();
+
+        for (const auto& user : record.getFavoritedBy()) {
+            fields.favoritedBy.push_back(user.toString());
+        }
+
+        for (const auto& attachment : record.getAttachments()) {
+            fields.attachments.push_back({std::string(attachment.type), std::string(attachment.url), std::string(attachment.fileID)});
+        }
+
+        return fields;
+    }
+}
+
+Message MessageLog::Record::toMessage(const UserSet& users) const {
+    return toFields(*this).build(users);
+}
+
+Message MessageLog::Record::toMessage(const MemberDirectory& members) const {
+    return toFields(*this).build(members);
+}
+
+MessageLog::File::File(int descriptor) :
+    m_descriptor(descriptor)
+{
+
+}
+
+MessageLog::File::File(File&& other) noexcept :
+    m_descriptor(std::exchange(other.m_descriptor, -1))
+{
+
+}
+
+MessageLog::File& MessageLog::File::operator=(File&& other) noexcept {
+    if (this != &other) {
+        if (m_descriptor >= 0) {
+            ::close(m_descriptor);
+        }
+        m_descriptor = std::exchange(other.m_descriptor, -1);
+    }
+    return *this;
+}
+
+MessageLog::File::~File() {
+    if (m_descriptor >= 0) {
+        ::close(m_descriptor);
+    }
+}
+
+int MessageLog::File::get() const {
+    return m_descriptor;
+}
+
+MessageLog::Mapping::Mapping(const File& file, std::size_t length, bool writable) :
+    m_length(length)
+{
+    void* data = ::mmap(nullptr, length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file.get(), 0);
+    if (data == MAP_FAILED) {
+        fail("Failed to map file.");
+    }
+    m_data = static_cast<char*>(data);
+}
+
+MessageLog::Mapping::Mapping(Mapping&& other) noexcept :
+    m_data(std::exchange(other.m_data, nullptr)),
+    m_length(std::exchange(other.m_length, 0))
+{
+
+}
+
+MessageLog::Mapping& MessageLog::Mapping::operator=(Mapping&& other) noexcept {
+    if (this != &other) {
+        if (m_data != nullptr) {
+            ::munmap(m_data, m_length);
+        }
+        m_data = std::exchange(other.m_data, nullptr);
+        m_length = std::exchange(other.m_length, 0);
+    }
+    return *this;
+}
+
+MessageLog::Mapping::~Mapping() {
+    if (m_data != nullptr) {
+        ::munmap(m_data, m_length);
+    }
+}
+
+char* MessageLog::Mapping::data() const {
+    return m_data;
+}
+
+std::size_t MessageLog::Mapping::length() const {
+    return m_length;
+}
+
+namespace {
+    IDIndexHeader* headerOf(char* index) {
+        return reinterpret_cast<IDIndexHeader*>(index);
+    }
+
+    IDIndexSlot* slotsOf(char* index) {
+        return reinterpret_cast<IDIndexSlot*>(index + sizeof(IDIndexHeader));
+    }
+
+    std::size_t indexSize(uint64_t capacity) {
+        return sizeof(IDIndexHeader) + capacity * sizeof(IDIndexSlot);
+    }
+
+    void writeAll(int descriptor, const char* data, std::size_t length, off_t offset) {
+        while (length > 0) {
+            ssize_t written = ::pwrite(descriptor, data, length, offset);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                fail("Failed to write file.");
+            }
+            data += written;
+            length -= static_cast<std::size_t>(written);
+            offset += written;
+        }
+    }
+}
+
+MessageLog::MessageLog(const std::filesystem::path& directory) :
+    MessageLog(directory, Options())
+{
+
+}
+
+MessageLog::MessageLog(const std::filesystem::path& directory, const Options& options) :
+    m_directory(directory),
+    m_options(options),
+    m_open()
+{
+    m_options.segmentSize = std::clamp<std::size_t>(options.segmentSize, s_minSegmentSize, std::numeric_limits<uint32_t>::max());
+    m_options.blockRecords = std::max<std::size_t>(options.blockRecords, 1);
+
+    std::filesystem::create_directories(m_directory);
+
+    openSegments();
+    openTimeIndex();
+    openIDIndex();
+    recover();
+}
+
+bool MessageLog::append(const Message& message) {
+    Fields fields;
+
+    fields.id = message.getCompactID();
+    fields.createdAt = message.getCreatedAt();
+
+    // Kept alive until the record is encoded
+    std::string name;
+    std::string avatarURL;
+    std::string text = message.getText();
+
+    std::shared_ptr<const User> sender = message.getSender();
+    if (sender != nullptr) {
+        fields.userID = sender->getCompactID();
+        name = sender->getNickname();
+        avatarURL = sender->getProfileImageURL();
+    }
+
+    fields.name = name;
+    fields.avatarURL = avatarURL;
+    fields.text = text;
+
+    for (const auto& user : message.getFavorited()) {
+        if (user != nullptr) {
+            fields.favoritedBy.push_back(user->getCompactID());
+        }
+    }
+
+    // An upload can still change the content, so each one is read once and
+    // kept alive here. Reserved so that the views stay valid.
+    std::vector<std::string> contents;
+    contents.reserve(message.getAttachments().size());
+
+    for (const auto& attachment : message.getAttachments()) {
+        const std::string& content = contents.emplace_back(attachment.getContent());
+
+        switch (attachment.getType()) {
+            case Attachment::Types::Picture:
+                fields.attachments.push_back({"image", content, {}});
+                break;
+            case Attachment::Types::Video:
+                fields.attachments.push_back({"video", content, {}});
+                break;
+            case Attachment::Types::File:
+                fields.attachments.push_back({"file", {}, content});
+                break;
+        }
+    }
+
+    return append(fields);
+}
+
+std::size_t MessageLog::append(const MessagePage& page) {
+    std::size_t appended = 0;
+
+    // Reused for the whole page, so the vectors keep their capacity
+    Fields fields;
+
+    for (const auto& message : page) {
+        fields.id = ID(message.getID());
+        fields.createdAt = message.getCreatedAt();
+        fields.userID = ID(message.getUserID());
+        fields.name = message.getName();
+        fields.avatarURL = message.getAvatarURL();
+        fields.text = message.getText();
+
+        fields.favoritedBy.clear();
+        for (std::string_view user : message.getFavoritedBy()) {
+            fields.favoritedBy.emplace_back(user);
+        }
+
+        fields.attachments.assign(message.getAttachments().begin(), message.getAttachments().end());
+
+        if (append(fields)) {
+            appended++;
+        }
+    }
+
+    return appended;
+}
+
+bool MessageLog::contains(const ID& id) const {
+    return lookup(id).has_value();
+}
+
+std::optional<MessageLog::Record> MessageLog::find(const ID& id) const {
+    std::optional<Position> position = lookup(id);
+    if (!position.has_value()) {
+        return std::nullopt;
+    }
+
+    Record record;
+    if (!decode(payloadAt(*position), record)) {
+        return std::nullopt;
+    }
+    return record;
+}
+
+void MessageLog::scan(uint64_t from, uint64_t to, const Visitor& visitor) const {
+    if (from >= to) {
+        return;
+    }
+
+    for (const auto& block : m_blocks) {
+        visitBlock(block, from, to, visitor);
+    }
+
+    if (m_open.count > 0) {
+        visitBlock(m_open, from, to, visitor);
+    }
+}
+
+void MessageLog::forEach(const Visitor& visitor) const {
+    scan(0, std::numeric_limits<uint64_t>::max(), visitor);
+}
+
+std::size_t MessageLog::size() const {
+    return headerOf(m_ids.data())->count;
+}
+
+std::size_t MessageLog::segments() const {
+    return m_segments.size();
+}
+
+void MessageLog::flush() {
+    for (const auto& segment : m_segments) {
+        if (::fdatasync(segment.file.get()) != 0) {
+            fail("Failed to sync file.");
+        }
+    }
+
+    if (::msync(m_ids.data(), m_ids.length(), MS_SYNC) != 0 || ::fdatasync(m_timeFile.get()) != 0) {
+        fail("Failed to sync file.");
+    }
+}
+
+void MessageLog::openSegments() {
+    std::vector<uint32_t> numbers;
+
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory)) {
+        std::filesystem::path name = entry.path().filename();
+        if (name.extension() != s_segmentExtension) {
+            continue;
+        }
+
+        std::string stem = name.stem().string();
+        if (stem.size() != 8 || !std::all_of(stem.begin(), stem.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+        numbers.push_back(static_cast<uint32_t>(std::stoul(stem)));
+    }
+
+    std::sort(numbers.begin(), numbers.end());
+
+    // Segments are numbered from 0 without gaps, anything after a gap isn't part of the log
+    for (std::size_t i = 0; i < numbers.size() && numbers[i] == i; i++) {
+        int descriptor = ::open((m_directory / segmentName(numbers[i])).c_str(), O_RDWR | O_CLOEXEC);
+        if (descriptor < 0) {
+            fail("Failed to open file.");
+        }
+
+        Segment segment;
+        segment.file = File(descriptor);
+
+        struct stat status;
+        if (::fstat(descriptor, &status) != 0) {
+            fail("Failed to open file.");
+        }
+        segment.size = static_cast<std::size_t>(status.st_size);
+
+        // Mapped at the full segment size, so appends show up without remapping
+        segment.mapping = Mapping(segment.file, std::max(segment.size, m_options.segmentSize), false);
+
+        m_segments.push_back(std::move(segment));
+    }
+
+    if (m_segments.empty()) {
+        addSegment();
+    }
+}
+
+void MessageLog::openTimeIndex() {
+    int descriptor = ::open((m_directory / s_timeIndexName).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (descriptor < 0) {
+        fail("Failed to open file.");
+    }
+    m_timeFile = File(descriptor);
+
+    struct stat status;
+    if (::fstat(descriptor, &status) != 0) {
+        fail("Failed to open file.");
+    }
+
+    m_blocks.resize(static_cast<std::size_t>(status.st_size) / sizeof(Block));
+
+    std::size_t length = m_blocks.size() * sizeof(Block);
+    if (length > 0 && ::pread(descriptor, m_blocks.data(), length, 0) != static_cast<ssize_t>(length)) {
+        fail("Failed to read file.");
+    }
+
+    // Blocks that point past the end of their segment were written before a crash cut the segment off
+    while (!m_blocks.empty()) {
+        const Block& block = m_blocks.back();
+        if (block.segment < m_segments.size() && static_cast<std::size_t>(block.offset) + block.length <= m_segments[block.segment].size) {
+            break;
+        }
+        m_blocks.pop_back();
+    }
+
+    if (::ftruncate(descriptor, static_cast<off_t>(m_blocks.size() * sizeof(Block))) != 0) {
+        fail("Failed to write file.");
+    }
+}
+
+void MessageLog::openIDIndex() {
+    std::filesystem::path path = m_directory / s_idIndexName;
+
+    int descriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (descriptor < 0) {
+        fail("Failed to open file.");
+    }
+    m_idFile = File(descriptor);
+
+    struct stat status;
+    if (::fstat(descriptor, &status) != 0) {
+        fail("Failed to open file.");
+    }
+
+    IDIndexHeader header = {};
+    bool valid = static_cast<std::size_t>(status.st_size) >= sizeof(header) && ::pread(descriptor, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+
+    valid = valid && header.magic == s_idIndexMagic;
+    valid = valid && header.capacity >= s_initialCapacity && (header.capacity & (header.capacity - 1)) == 0;
+    valid = valid && static_cast<std::size_t>(status.st_size) == indexSize(header.capacity);
+    valid = valid && header.coveredSegment < m_segments.size() && header.coveredOffset <= m_segments[header.coveredSegment].size;
+
+    // A missing or damaged index is rebuilt from the segments
+    if (!valid) {
+        header = {};
+        header.magic = s_idIndexMagic;
+        header.capacity = s_initialCapacity;
+
+        if (::ftruncate(descriptor, 0) != 0 || ::ftruncate(descriptor, static_cast<off_t>(indexSize(header.capacity))) != 0) {
+            fail("Failed to write file.");
+        }
+        writeAll(descriptor, reinterpret_cast<const char*>(&header), sizeof(header), 0);
+    }
+
+    m_ids = Mapping(m_idFile, indexSize(header.capacity), true);
+}
+
+void MessageLog::recover() {
+    IDIndexHeader* header = headerOf(m_ids.data());
+
+    auto before = [](const Position& lhs, const Position& rhs) {
+        return lhs.segment != rhs.segment ? lhs.segment < rhs.segment : lhs.offset < rhs.offset;
+    };
+
+    Position covered = {header->coveredSegment, header->coveredOffset};
+
+    Position blocksEnd;
+    if (!m_blocks.empty()) {
+        blocksEnd = {m_blocks.back().segment, m_blocks.back().offset + m_blocks.back().length};
+    }
+
+    Position start = before(covered, blocksEnd) ? covered : blocksEnd;
+
+    for (uint32_t number = start.segment; number < m_segments.size(); number++) {
+        Segment& segment = m_segments[number];
+
+        std::size_t offset = number == start.segment ? start.offset : 0;
+        while (segment.size - offset >= s_recordHeader) {
+            const char* data = segment.mapping.data() + offset;
+
+            uint32_t length = readUint32(data);
+            if (length > segment.size - offset - s_recordHeader) {
+                break;
+            }
+
+            std::string_view payload(data + s_recordHeader, length);
+            if (checksum(payload) != readUint32(data + 4)) {
+                break;
+            }
+
+            // Only the time and the ID are needed to index it
+            uint64_t createdAt;
+            ID id;
+            if (!readVarint(payload, createdAt) || !readID(payload, id)) {
+                break;
+            }
+
+            Position position = {number, static_cast<uint32_t>(offset)};
+
+            if (!lookup(id).has_value()) {
+                insert(indexKey(id), position);
+            }
+
+            if (!before(position, blocksEnd)) {
+                extendBlock(position, static_cast<uint32_t>(s_recordHeader + length), createdAt);
+            }
+
+            offset += s_recordHeader + length;
+        }
+
+        // Whatever is left was cut off by a crash
+        if (offset < segment.size) {
+            if (::ftruncate(segment.file.get(), static_cast<off_t>(offset)) != 0) {
+                fail("Failed to write file.");
+            }
+            segment.size = offset;
+        }
+    }
+
+    header = headerOf(m_ids.data());
+    header->coveredSegment = static_cast<uint32_t>(m_segments.size() - 1);
+    header->coveredOffset = static_cast<uint32_t>(m_segments.back().size);
+}
+
+void MessageLog::addSegment() {
+    uint32_t number = static_cast<uint32_t>(m_segments.size());
+
+    int descriptor = ::open((m_directory / segmentName(number)).c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (descriptor < 0) {
+        fail("Failed to open file.");
+    }
+
+    Segment segment;
+    segment.file = File(descriptor);
+    segment.mapping = Mapping(segment.file, m_options.segmentSize, false);
+
+    m_segments.push_back(std::move(segment));
+}
+
+bool MessageLog::append(const Fields& fields) {
+    if (lookup(fields.id).has_value()) {
+        return false;
+    }
+
+    encode(fields);
+
+    if (m_buffer.size() > m_options.segmentSize) {
+        throw std::length_error("The message is too big for a segment.");
+    }
+
+    if (m_segments.back().size + m_buffer.size() > m_options.segmentSize) {
+        closeBlock();
+        addSegment();
+    }
+
+    Segment& segment = m_segments.back();
+    Position position = {static_cast<uint32_t>(m_segments.size() - 1), static_cast<uint32_t>(segment.size)};
+
+    // If this fails part way, the next append writes over what was written
+    writeAll(segment.file.get(), m_buffer.data(), m_buffer.size(), static_cast<off_t>(segment.size));
+    segment.size += m_buffer.size();
+
+    if (m_options.sync && ::fdatasync(segment.file.get()) != 0) {
+        fail("Failed to sync file.");
+    }
+
+    insert(indexKey(fields.id), position);
+
+    IDIndexHeader* header = headerOf(m_ids.data());
+    header->coveredSegment = position.segment;
+    header->coveredOffset = static_cast<uint32_t>(segment.size);
+
+    extendBlock(position, static_cast<uint32_t>(m_buffer.size()), fields.createdAt);
+
+    return true;
+}
+
+void MessageLog::encode(const Fields& fields) {
+    m_buffer.clear();
+
+    // Filled in once the length of the payload is known
+    m_buffer.append(s_recordHeader, '\0');
+
+    writeVarint(m_buffer, fields.createdAt);
+    writeID(m_buffer, fields.id);
+    writeID(m_buffer, fields.userID);
+    writeString(m_buffer, fields.name);
+    writeString(m_buffer, fields.avatarURL);
+    writeString(m_buffer, fields.text);
+
+    writeVarint(m_buffer, fields.favoritedBy.size());
+    for (const auto& user : fields.favoritedBy) {
+        writeID(m_buffer, user);
+    }
+
+    writeVarint(m_buffer, fields.attachments.size());
+    for (const auto& attachment : fields.attachments) {
+        writeString(m_buffer, attachment.type);
+        writeString(m_buffer, attachment.url);
+        writeString(m_buffer, attachment.fileID);
+    }
+
+    std::string_view payload = std::string_view(m_buffer).substr(s_recordHeader);
+
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    uint32_t sum = checksum(payload);
+
+    std::memcpy(m_buffer.data(), &length, sizeof(length));
+    std::memcpy(m_buffer.data() + sizeof(length), &sum, sizeof(sum));
+}
+
+bool MessageLog::decode(std::string_view payload, Record& record) {
+    if (!readVarint(payload, record.m_createdAt) || !readID(payload, record.m_id) || !readID(payload, record.m_userID)) {
+        return false;
+    }
+
+    if (!readString(payload, record.m_name) || !readString(payload, record.m_avatarURL) || !readString(payload, record.m_text)) {
+        return false;
+    }
+
+    // Every entry takes at least a byte, so a count bigger than what's left is damaged
+    uint64_t count;
+    if (!readVarint(payload, count) || count > payload.size()) {
+        return false;
+    }
+
+    record.m_favoritedBy.resize(count);
+    for (auto& user : record.m_favoritedBy) {
+        if (!readID(payload, user)) {
+            return false;
+        }
+    }
+
+    if (!readVarint(payload, count) || count > payload.size()) {
+        return false;
+    }
+
+    record.m_attachments.resize(count);
+    for (auto& attachment : record.m_attachments) {
+        if (!readString(payload, attachment.type) || !readString(payload, attachment.url) || !readString(payload, attachment.fileID)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string_view MessageLog::payloadAt(Position position) const {
+    const char* data = m_segments[position.segment].mapping.data() + position.offset;
+    return std::string_view(data + s_recordHeader, readUint32(data));
+}
+
+std::optional<MessageLog::Position> MessageLog::lookup(const ID& id) const {
+    const IDIndexHeader* header = headerOf(m_ids.data());
+    const IDIndexSlot* slots = slotsOf(m_ids.data());
+
+    uint64_t key = indexKey(id);
+    uint64_t mask = header->capacity - 1;
+
+    for (uint64_t i = mix(key) & mask;; i = (i + 1) & mask) {
+        const IDIndexSlot& slot = slots[i];
+        if (slot.location == 0) {
+            return std::nullopt;
+        }
+
+        if (slot.key != key) {
+            continue;
+        }
+
+        Position position = {static_cast<uint32_t>((slot.location - 1) >> 32), static_cast<uint32_t>(slot.location - 1)};
+
+        // The index can be ahead of the segments after a crash, so a slot
+        // may point at a record that was cut off when the log was recovered
+        if (position.segment >= m_segments.size()) {
+            continue;
+        }
+
+        const Segment& segment = m_segments[position.segment];
+        if (position.offset > segment.size || segment.size - position.offset < s_recordHeader) {
+            continue;
+        }
+
+        const char* data = segment.mapping.data() + position.offset;
+        uint32_t length = readUint32(data);
+        if (length > segment.size - position.offset - s_recordHeader) {
+            continue;
+        }
+
+        // Even an exact key for a number has to match, since the slot could
+        // be from a record that was cut off and replaced by another one
+        std::string_view payload(data + s_recordHeader, length);
+
+        uint64_t createdAt;
+        ID stored;
+        if (readVarint(payload, createdAt) && readID(payload, stored) && stored == id) {
+            return position;
+        }
+    }
+}
+
+void MessageLog::insert(uint64_t key, Position position) {
+    // Kept at most half full, so probes stay short and always end
+    if ((headerOf(m_ids.data())->count + 1) * 2 > headerOf(m_ids.data())->capacity) {
+        growIDIndex();
+    }
+
+    IDIndexHeader* header = headerOf(m_ids.data());
+    IDIndexSlot* slots = slotsOf(m_ids.data());
+
+    uint64_t mask = header->capacity - 1;
+    uint64_t i = mix(key) & mask;
+    while (slots[i].location != 0) {
+        i = (i + 1) & mask;
+    }
+
+    slots[i].key = key;
+    slots[i].location = ((static_cast<uint64_t>(position.segment) << 32) | position.offset) + 1;
+    header->count++;
+}
+
+void MessageLog::growIDIndex() {
+    const IDIndexHeader* oldHeader = headerOf(m_ids.data());
+    const IDIndexSlot* oldSlots = slotsOf(m_ids.data());
+
+    uint64_t capacity = oldHeader->capacity * 2;
+
+    // Built next to the index and renamed over it, so there's always a whole index on disk
+    std::filesystem::path path = m_directory / s_idIndexName;
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+
+    int descriptor = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (descriptor < 0) {
+        fail("Failed to open file.");
+    }
+
+    File file(descriptor);
+    if (::ftruncate(descriptor, static_cast<off_t>(indexSize(capacity))) != 0) {
+        fail("Failed to write file.");
+    }
+
+    Mapping mapping(file, indexSize(capacity), true);
+
+    IDIndexHeader* header = headerOf(mapping.data());
+    IDIndexSlot* slots = slotsOf(mapping.data());
+
+    *header = *oldHeader;
+    header->capacity = capacity;
+
+    uint64_t mask = capacity - 1;
+    for (uint64_t slot = 0; slot < oldHeader->capacity; slot++) {
+        if (oldSlots[slot].location == 0) {
+            continue;
+        }
+
+        uint64_t i = mix(oldSlots[slot].key) & mask;
+        while (slots[i].location != 0) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = oldSlots[slot];
+    }
+
+    std::filesystem::rename(temporary, path);
+
+    m_ids = std::move(mapping);
+    m_idFile = std::move(file);
+}
+
+void MessageLog::extendBlock(Position position, uint32_t length, uint64_t createdAt) {
+    // A block only covers records that are next to each other in one segment
+    if (m_open.count > 0 && (m_open.segment != position.segment || m_open.offset + m_open.length != position.offset)) {
+        closeBlock();
+    }
+
+    if (m_open.count == 0) {
+        m_open.minCreatedAt = createdAt;
+        m_open.maxCreatedAt = createdAt;
+        m_open.segment = position.segment;
+        m_open.offset = position.offset;
+        m_open.length = 0;
+    }
+
+    m_open.minCreatedAt = std::min(m_open.minCreatedAt, createdAt);
+    m_open.maxCreatedAt = std::max(m_open.maxCreatedAt, createdAt);
+    m_open.length += length;
+    m_open.count++;
+
+    if (m_open.count >= m_options.blockRecords) {
+        closeBlock();
+    }
+}
+
+void MessageLog::closeBlock() {
+    if (m_open.count == 0) {
+        return;
+    }
+
+    writeAll(m_timeFile.get(), reinterpret_cast<const char*>(&m_open), sizeof(Block), static_cast<off_t>(m_blocks.size() * sizeof(Block)));
+
+    m_blocks.push_back(m_open);
+    m_open = Block();
+}
+
+void MessageLog::visitBlock(const Block& block, uint64_t from, uint64_t to, const Visitor& visitor) const {
+    if (block.maxCreatedAt < from || block.minCreatedAt >= to) {
+        return;
+    }
+
+    const char* data = m_segments[block.segment].mapping.data();
+
+    Record record;
+
+    std::size_t offset = block.offset;
+    std::size_t end = offset + block.length;
+    while (offset < end) {
+        uint32_t length = readUint32(data + offset);
+        std::string_view payload(data + offset + s_recordHeader, length);
+        offset += s_recordHeader + length;
+
+        // Records outside of the range only have their time decoded
+        std::string_view time = payload;
+        uint64_t createdAt;
+        if (!readVarint(time, createdAt) || createdAt < from || createdAt >= to) {
+            continue;
+        }
+
+        if (decode(payload, record)) {
+            visitor(record);
+        }
+    }
+}
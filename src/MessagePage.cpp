@@ -0,0 +1,192 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "MessagePage.h"
+#include "util/MessageParser.h"
+
+#include <cstring>
+
+using namespace GroupMe;
+
+namespace {
+    // The messages endpoint never sends more than this many in one page
+    constexpr std::size_t s_pageLimit = 100;
+}
+
+MessagePage::Storage::Storage(std::size_t initialSize) :
+    arena(initialSize),
+    messages(&arena)
+{
+
+}
+
+MessagePage::MessagePage(std::size_t bodySize) :
+    // The body, the decoded strings (which are never longer than the body)
+    // and the messages should all fit in the first block
+    m_storage(std::make_unique<Storage>(bodySize * 2 + s_pageLimit * sizeof(MessageView) + 1024))
+{
+
+}
+
+MessagePage MessagePage::parse(std::string_view body) {
+    MessagePage page(body.size());
+
+    Storage& storage = *page.m_storage;
+
+    storage.body = page.store(body);
+    storage.messages.reserve(s_pageLimit);
+
+    Util::parseMessagePage(storage.body, [&page, &storage](Util::MessageFields& fields) {
+        MessageView& message = storage.messages.emplace_back();
+
+        message.m_id = page.store(fields.id);
+        message.m_createdAt = fields.createdAt;
+        message.m_userID = page.store(fields.userID);
+        message.m_sender = IdentityTable::global().intern(fields.userID, fields.name, fields.avatarURL);
+        message.m_name = page.store(fields.name);
+        message.m_avatarURL = page.store(fields.avatarURL);
+        message.m_text = page.store(fields.text);
+
+        if (!fields.favoritedBy.empty()) {
+            std::pmr::polymorphic_allocator<std::string_view> allocator(&storage.arena);
+            std::string_view* favoritedBy = allocator.allocate(fields.favoritedBy.size());
+
+            for (std::size_t i = 0; i < fields.favoritedBy.size(); i++) {
+                new (favoritedBy + i) std::string_view(page.store(fields.favoritedBy[i]));
+            }
+
+            message.m_favoritedBy = Range<std::string_view>(favoritedBy, fields.favoritedBy.size());
+        }
+
+        if (!fields.attachments.empty()) {
+            std::pmr::polymorphic_allocator<AttachmentView> allocator(&storage.arena);
+            AttachmentView* attachments = allocator.allocate(fields.attachments.size());
+
+            for (std::size_t i = 0; i < fields.attachments.size(); i++) {
+                new (attachments + i) AttachmentView{page.store(fields.attachments[i].type), page.store(fields.attachments[i].url), page.store(fields.attachments[i].fileID)};
+            }
+
+            message.m_attachments = Range<AttachmentView>(attachments, fields.attachments.size());
+        }
+    });
+
+    return page;
+}
+
+std::string_view MessagePage::store(std::string_view string) {
+    if (string.empty()) {
+        return std::string_view();
+    }
+
+    char* data = static_cast<char*>(m_storage->arena.allocate(string.size(), alignof(char)));
+    std::memcpy(data, string.data(), string.size());
+
+    return std::string_view(data, string.size());
+}
+
+std::size_t MessagePage::size() const {
+    return m_storage->messages.size();
+}
+
+bool MessagePage::empty() const {
+    return m_storage->messages.empty();
+}
+
+const MessagePage::MessageView& MessagePage::operator[](std::size_t index) const {
+    return m_storage->messages[index];
+}
+
+MessagePage::const_iterator MessagePage::begin() const {
+    return m_storage->messages.cbegin();
+}
+
+MessagePage::const_iterator MessagePage::end() const {
+    return m_storage->messages.cend();
+}
+
+std::string_view MessagePage::getBody() const {
+    return m_storage->body;
+}
+
+std::vector<Message> MessagePage::toMessages(const UserSet& users) const {
+    std::vector<Message> messages;
+    messages.reserve(size());
+
+    for (const auto& message : *this) {
+        messages.push_back(message.toMessage(users));
+    }
+
+    return messages;
+}
+
+std::string_view MessagePage::MessageView::getID() const {
+    return m_id;
+}
+
+uint64_t MessagePage::MessageView::getCreatedAt() const {
+    return m_createdAt;
+}
+
+std::string_view MessagePage::MessageView::getUserID() const {
+    return m_userID;
+}
+
+UserHandle MessagePage::MessageView::getSender() const {
+    return m_sender;
+}
+
+std::string_view MessagePage::MessageView::getName() const {
+    return m_name;
+}
+
+std::string_view MessagePage::MessageView::getAvatarURL() const {
+    return m_avatarURL;
+}
+
+std::string_view MessagePage::MessageView::getText() const {
+    return m_text;
+}
+
+MessagePage::Range<std::string_view> MessagePage::MessageView::getFavoritedBy() const {
+    return m_favoritedBy;
+}
+
+MessagePage::Range<MessagePage::AttachmentView> MessagePage::MessageView::getAttachments() const {
+    return m_attachments;
+}
+
+Message MessagePage::MessageView::toMessage(const UserSet& users) const {
+    Util::MessageFields fields;
+
+    fields.id = m_id;
+    fields.createdAt = m_createdAt;
+    fields.userID = m_userID;
+    fields.name = m_name;
+    fields.avatarURL = m_avatarURL;
+    fields.text = m_text;
+
+    for (const auto& user : m_favoritedBy) {
+        fields.favoritedBy.emplace_back(user);
+    }
+
+    for (const auto& attachment : m_attachments) {
+        fields.attachments.push_back({std::string(attachment.type), std::string(attachment.url), std::string(attachment.fileID)});
+    }
+
+    return fields.build(users);
+}
@@ -0,0 +1,198 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "MessageStore.h"
+
+
+using namespace GroupMe;
+
+namespace {
+    uint8_t attachmentKind(std::string_view type) {
+        if (type == "image") {
+            return MessageStore::Picture;
+        }
+        else if (type == "video") {
+            return MessageStore::Video;
+        }
+        else if (type == "file") {
+            return MessageStore::File;
+        }
+        return MessageStore::Other;
+    }
+}
+
+void MessageStore::reserve(std::size_t messages, std::size_t textBytes) {
+    m_createdAt.reserve(messages);
+    m_senders.reserve(messages);
+    m_attachmentKinds.reserve(messages);
+    m_idOffsets.reserve(messages + 1);
+    m_textOffsets.reserve(messages + 1);
+    m_texts.reserve(textBytes);
+}
+
+void MessageStore::append(const Message& message) {
+    uint8_t kinds = 0;
+    for (const auto& attachment : message.getAttachments()) {
+        switch (attachment.getType()) {
+            case Attachment::Types::Picture:
+                kinds |= Picture;
+                break;
+            case Attachment::Types::Video:
+                kinds |= Video;
+                break;
+            case Attachment::Types::File:
+                kinds |= File;
+                break;
+        }
+    }
+
+    append(message.getID(), message.getCreatedAt(), message.getSenderHandle(), message.getText(), kinds);
+}
+
+void MessageStore::append(const MessagePage& page) {
+    reserve(size() + page.size(), m_texts.size() + page.getBody().size() / 2);
+
+    for (const auto& message : page) {
+        uint8_t kinds = 0;
+        for (const auto& attachment : message.getAttachments()) {
+            kinds |= attachmentKind(attachment.type);
+        }
+
+        append(message.getID(), message.getCreatedAt(), message.getSender(), message.getText(), kinds);
+    }
+}
+
+void MessageStore::append(std::string_view id, uint64_t createdAt, UserHandle sender, std::string_view text, uint8_t attachmentKinds) {
+    m_createdAt.push_back(createdAt);
+    m_senders.push_back(sender.value());
+    m_attachmentKinds.push_back(attachmentKinds);
+
+    m_ids.append(id);
+    m_idOffsets.push_back(m_ids.size());
+
+    m_texts.append(text);
+    m_textOffsets.push_back(m_texts.size());
+}
+
+std::size_t MessageStore::size() const {
+    return m_createdAt.size();
+}
+
+MessageStore::Scan MessageStore::scan() const {
+    return Scan(*this);
+}
+
+std::string_view MessageStore::getID(std::size_t row) const {
+    return std::string_view(m_ids).substr(m_idOffsets[row], m_idOffsets[row + 1] - m_idOffsets[row]);
+}
+
+uint64_t MessageStore::getCreatedAt(std::size_t row) const {
+    return m_createdAt[row];
+}
+
+UserHandle MessageStore::getSender(std::size_t row) const {
+    return UserHandle(m_senders[row]);
+}
+
+std::string_view MessageStore::getText(std::size_t row) const {
+    return std::string_view(m_texts).substr(m_textOffsets[row], m_textOffsets[row + 1] - m_textOffsets[row]);
+}
+
+uint8_t MessageStore::getAttachmentKinds(std::size_t row) const {
+    return m_attachmentKinds[row];
+}
+
+const std::vector<uint64_t>& MessageStore::getCreatedAtColumn() const {
+    return m_createdAt;
+}
+
+const std::vector<uint32_t>& MessageStore::getSenderColumn() const {
+    return m_senders;
+}
+
+MessageStore::Scan::Scan(const MessageStore& store) :
+    m_store(store),
+    m_selected(store.size(), 1)
+{
+
+}
+
+/*
+ * The filters below are kept free of branches and only read plain arrays
+ * through local pointers so that GCC and Clang vectorize them.
+ */
+
+MessageStore::Scan& MessageStore::Scan::between(uint64_t from, uint64_t to) {
+    const uint64_t* createdAt = m_store.m_createdAt.data();
+    uint8_t* selected = m_selected.data();
+    const std::size_t size = m_selected.size();
+
+    // `from <= value < to` as one unsigned compare
+    const uint64_t width = to > from ? to - from : 0;
+
+    for (std::size_t i = 0; i < size; i++) {
+        selected[i] &= static_cast<uint8_t>(createdAt[i] - from < width);
+    }
+    return *this;
+}
+
+MessageStore::Scan& MessageStore::Scan::sentBy(UserHandle sender) {
+    const uint32_t* senders = m_store.m_senders.data();
+    uint8_t* selected = m_selected.data();
+    const std::size_t size = m_selected.size();
+    const uint32_t value = sender.value();
+
+    for (std::size_t i = 0; i < size; i++) {
+        selected[i] &= static_cast<uint8_t>(senders[i] == value);
+    }
+    return *this;
+}
+
+MessageStore::Scan& MessageStore::Scan::withAttachments(uint8_t kinds) {
+    const uint8_t* attachmentKinds = m_store.m_attachmentKinds.data();
+    uint8_t* selected = m_selected.data();
+    const std::size_t size = m_selected.size();
+
+    for (std::size_t i = 0; i < size; i++) {
+        selected[i] &= static_cast<uint8_t>((attachmentKinds[i] & kinds) != 0);
+    }
+    return *this;
+}
+
+std::size_t MessageStore::Scan::count() const {
+    const uint8_t* selected = m_selected.data();
+    const std::size_t size = m_selected.size();
+
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        count += selected[i];
+    }
+    return count;
+}
+
+std::vector<std::size_t> MessageStore::Scan::rows() const {
+    std::vector<std::size_t> rows;
+    rows.reserve(count());
+
+    for (std::size_t i = 0; i < m_selected.size(); i++) {
+        if (m_selected[i] != 0) {
+            rows.push_back(i);
+        }
+    }
+    return rows;
+}
@@ -17,94 +17,162 @@
 */
 
 #include "Picture.h"
+#include "util/Json.h"
 
 using namespace GroupMe;
 
+Picture::State::State(const web::uri& endpoint) :
+    client(endpoint),
+    owners(1)
+{
+
+}
+
 Picture::Picture(const std::string& accessToken, const std::filesystem::path& path) :
     Attachment(path, Attachment::Types::Picture, accessToken),
-    m_client("https://image.groupme.com/pictures"),
-    m_file(path)
+    m_state(std::make_shared<State>(web::uri("https://image.groupme.com/pictures")))
 {
-    m_task = pplx::task<void>([this]() -> void {
-        m_request.set_method(web::http::methods::POST);
-        m_request.headers().add("X-Access-Token", m_accessToken);
-        m_request.headers().add("Content-Type", "image/jpeg");
+    Util::Cancellation::Link link = Util::Cancellation::link({m_state->cancellation.get_token(), m_state->preparation.get_token()});
+    pplx::cancellation_token token = link.getToken();
+
+    m_state->content = m_content;
+
+    m_state->request.set_method(web::http::methods::POST);
+    m_state->request.headers().add("X-Access-Token", m_accessToken);
+    m_state->request.headers().add("Content-Type", "image/jpeg");
+
+    // Reading the file blocks, so it is kept off of the I/O scheduler
+    m_state->task = pplx::task<void>([state = m_state, path]() -> void {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
 
-        if (!m_file) {
+        if (!file) {
             throw std::fstream::failure("Failed to open file.");
         }
 
-        m_contentBinary.assign(std::istreambuf_iterator<char>(m_file), std::istreambuf_iterator<char>());
+        state->contentBinary.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
 
-    });
+    }, Util::Executors::options(Util::Executors::blocking(), token));
+
+    link.attach(m_state->task);
 }
 
 Picture::Picture(const std::string& accessToken, const web::uri& contentURL) :
     Attachment(contentURL, Attachment::Types::Picture, accessToken),
-    m_client(m_content)
+    m_state(std::make_shared<State>(contentURL))
 {
-    m_task = pplx::task<void>([this]() -> void {
-        m_request.set_method(web::http::methods::GET);
+    Util::Cancellation::Link link = Util::Cancellation::link({m_state->cancellation.get_token(), m_state->preparation.get_token()});
+    pplx::cancellation_token token = link.getToken();
+
+    m_state->content = m_content;
 
-        m_client.request(m_request).then([this](const web::http::http_response& response) {
-            std::stringstream strm;
+    m_state->request.set_method(web::http::methods::GET);
 
-            strm << response.extract_string(true).get();
+    m_state->task = m_state->client.request(m_state->request, token).then([](const web::http::http_response& response) {
+        return response.extract_vector();
+    }, Util::Executors::options(Util::Executors::io(), token)).then([state = m_state, accessToken = m_accessToken](const std::vector<unsigned char>& content) {
+        state->contentBinary = content;
 
-            m_contentBinary.assign(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
-        }).wait();
+        state->client = web::http::client::http_client("https://image.groupme.com/pictures");
 
-        m_client = web::http::client::http_client("https://image.groupme.com/pictures");
+        state->request.set_method(web::http::methods::POST);
+        state->request.headers().add("X-Access-Token", accessToken);
+        state->request.headers().add("Content-Type", "image/jpeg");
+        state->request.set_body("");
+    }, Util::Executors::options(Util::Executors::io(), token));
 
-        m_request.set_method(web::http::methods::POST);
-        m_request.headers().add("X-Access-Token", m_accessToken);
-        m_request.headers().add("Content-Type", "image/jpeg");
-        m_request.set_body("");
-    });
+    link.attach(m_state->task);
 }
 
 Picture::Picture(const Picture& other) :
     Attachment(other),
-    m_request(other.m_request),
-    m_client(other.m_client),
-    m_json(other.m_json),
-    m_task(other.m_task)
+    m_state(other.m_state)
 {
-
+    acquire();
 }
 
 Picture::~Picture() {
-    m_task.wait();
+    release();
 }
 
 Picture& Picture::operator=(const Picture& other) {
     if(this != &other) {
+        release();
         Attachment::operator=(other);
-        m_request = other.m_request;
-        m_client = other.m_client;
-        m_json = other.m_json;
-        m_task = other.m_task;
+        m_state = other.m_state;
+        acquire();
+    }
+    return *this;
+}
+
+Picture& Picture::operator=(Picture&& other) noexcept {
+    if(this != &other) {
+        release();
+        Attachment::operator=(std::move(other));
+        m_state = std::move(other.m_state);
     }
     return *this;
 }
 
-pplx::task<std::string> Picture::upload() {
-    m_task.wait();
+void Picture::acquire() {
+    if (m_state != nullptr) {
+        m_state->owners.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Picture::release() {
+    release(m_state);
+    m_state = nullptr;
+}
+
+void Picture::release(const std::shared_ptr<State>& state) {
+    if (state == nullptr || state->owners.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    state->preparation.cancel();
+
+    // The preparation might still be writing to the buffers, so they're
+    // only freed after it has stopped
+    state->task.then([state](const pplx::task<void>&) {
+        state->contentBinary.clear();
+        state->contentBinary.shrink_to_fit();
+    }, Util::Executors::options(Util::Executors::io(), pplx::cancellation_token::none()));
+}
+
+pplx::task<std::string> Picture::upload(const pplx::cancellation_token& token, const Util::Deadline& deadline) {
+    Util::Cancellation::Link link = Util::Cancellation::link({token, m_state->cancellation.get_token()}, deadline);
+    pplx::cancellation_token linked = link.getToken();
+
+    // Chained onto the preparation task instead of waiting on it so
+    // that the calling thread is never blocked
+    pplx::task<std::string> upload = m_state->task.then([state = m_state, linked]() {
+        state->request.set_body(state->contentBinary);
+        return state->client.request(state->request, linked);
+    }, Util::Executors::options(Util::Executors::io(), linked)).then([](const web::http::http_response& response) {
+        if (response.status_code() != web::http::status_codes::OK) {
+            return pplx::task_from_result(std::string());
+        }
+        return response.extract_string(true);
+    }, Util::Executors::options(Util::Executors::io(), linked)).then([state = m_state](const std::string& body) -> std::string {
+        if (body.empty()) {
+            return state->content->get();
+        }
 
-    return pplx::task<std::string>([this]() -> std::string {
-        m_request.set_body(m_contentBinary);
-        m_client.request(m_request).then([this](const web::http::http_response& response) -> void {
-                if (response.status_code() != web::http::status_codes::OK) {
-                    return;
-                }
+        std::string content = Util::Json::Document(body).getString("/payload/picture_url");
+        state->content->set(content);
 
-                m_json = nlohmann::json::parse(response.extract_string(true).get());
+        return content;
+    }, Util::Executors::options(Util::Executors::cpu(), linked));
 
-                m_content = m_json["payload"]["picture_url"].dump();
+    // A running upload keeps the preparation alive just like a copy does
+    m_state->owners.fetch_add(1, std::memory_order_relaxed);
+    upload.then([state = m_state](const pplx::task<std::string>&) {
+        release(state);
+    }, Util::Executors::options(Util::Executors::io(), pplx::cancellation_token::none()));
 
-                m_content.erase(std::remove(m_content.begin(), m_content.end(), '"'), m_content.end());
+    return link.attach(upload);
+}
 
-        }).wait();
-        return m_content;
-    });
+void Picture::cancel() {
+    m_state->cancellation.cancel();
 }
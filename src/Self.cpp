@@ -17,274 +17,534 @@
 */
 
 #include "Self.h"
+#include "util/Json.h"
+#include "util/JsonWriter.h"
 
 using namespace GroupMe;
 
+namespace {
+    // The bit of a profile field in `Self::State::dirty`
+    constexpr uint64_t profileBit(std::string_view key) {
+        return uint64_t(1) << Util::indexOf(User::Schema::profile, key);
+    }
+}
+
 Self::Self(const std::string& accessToken) :
-    m_accessToken(accessToken),
-    m_client("https://api.groupme.com/v3/users/me")
+    m_state(std::make_shared<State>())
 {
-    m_task = pplx::task<void>([this]() -> void {
-        m_request.set_method(web::http::methods::GET);
+    m_state->accessToken = accessToken;
+    m_state->self = this;
 
-        m_request.headers().add("X-Access-Token", m_accessToken);
+    // The getters read the record, so there always has to be one
+    publishRecord();
 
-        m_client.request(m_request).then([this](const web::http::http_response& response) {
-            if (response.status_code() != web::http::status_codes::OK) {
-                throw web::http::http_exception(response.status_code());
-            }
+    web::http::client::http_client client("https://api.groupme.com/v3/users/me");
 
-            auto json = nlohmann::json::parse(response.extract_string(true).get());
+    web::http::http_request request(web::http::methods::GET);
 
-            if (json["response"] == "null") {
-                return;
-            }
+    request.headers().add("X-Access-Token", accessToken);
 
-            // This just grabs the responses from the json object and parses it
-            m_userID = json["response"]["id"];
-            m_userID.erase(std::remove(m_userID.begin(), m_userID.end(), '\"'), m_userID.end());
+    pplx::cancellation_token token = m_state->cancellation.get_token();
 
-            m_userPhoneNumber = json["response"]["phone_number"];
-            m_userPhoneNumber.erase(std::remove(m_userPhoneNumber.begin(), m_userPhoneNumber.end(), '\"'), m_userPhoneNumber.end());
+    m_state->task = client.request(request, token).then([](const web::http::http_response& response) {
+        if (response.status_code() != web::http::status_codes::OK) {
+            throw web::http::http_exception(response.status_code());
+        }
 
-            m_userProfileImageURL = json["response"]["image_url"];
-            m_userProfileImageURL.erase(std::remove(m_userProfileImageURL.begin(), m_userProfileImageURL.end(), '\"'), m_userProfileImageURL.end());
+        return response.extract_string(true);
+    }, Util::Executors::options(Util::Executors::io(), token)).then([state = m_state](const std::string& body) {
+        Util::Json::Document document(body);
 
-            m_createdAt = json["response"]["created_at"];
+        std::lock_guard<std::mutex> lock(state->mutex);
 
-            m_updatedAt = json["response"]["updated_at"];
+        // The user was destroyed while the request was in flight
+        Self* self = state->self;
+        if (self == nullptr) {
+            return;
+        }
 
-            m_userEmail = json["response"]["email"];
-            m_userEmail.erase(std::remove(m_userEmail.begin(), m_userEmail.end(), '\"'), m_userEmail.end());
+        document.forEachField([self](std::string_view key, Util::Json::Value& value) {
+            // The response section of the JSON will be null if a problem occured
+            if (key == "response" && !value.isNull()) {
+                self->readProfile(value);
+            }
+        });
+    }, Util::Executors::options(Util::Executors::cpu(), token));
+}
 
-            m_isSMS = json["response"]["sms"];
+Self::Self(Self&& other) noexcept :
+    m_state(nullptr)
+{
+    // A moved from user has no tasks that could write to it
+    if (other.m_state == nullptr) {
+        User::operator=(std::move(other));
+        m_contacts = std::move(other.m_contacts);
+        return;
+    }
+
+    // Holding the lock keeps the tasks from writing to `other` while it's moved
+    std::lock_guard<std::mutex> lock(other.m_state->mutex);
+
+    User::operator=(std::move(other));
+    m_contacts = std::move(other.m_contacts);
+    m_state = std::move(other.m_state);
+    m_state->self = this;
+}
 
-            m_locale = json["response"]["locale"];
-            m_locale.erase(std::remove(m_locale.begin(), m_locale.end(), '\"'), m_locale.end());
+Self::~Self() {
+    detach();
+}
 
-            m_shareURL = json["response"]["share_url"];
-            m_shareURL.erase(std::remove(m_locale.begin(), m_locale.end(), '\"'), m_locale.end());
+Self& Self::operator=(Self&& other) noexcept {
+    if (this != &other) {
+        detach();
 
-            m_shareQRCodeURL = json["response"]["share_qr_code_url"];
-            m_shareQRCodeURL.erase(std::remove(m_shareQRCodeURL.begin(), m_shareQRCodeURL.end(), '\"'), m_shareQRCodeURL.end());
+        if (other.m_state == nullptr) {
+            User::operator=(std::move(other));
+            m_contacts = std::move(other.m_contacts);
+            return *this;
+        }
 
+        std::lock_guard<std::mutex> lock(other.m_state->mutex);
 
-        }).wait();
-    });
+        User::operator=(std::move(other));
+        m_contacts = std::move(other.m_contacts);
+        m_state = std::move(other.m_state);
+        m_state->self = this;
+    }
+    return *this;
 }
 
-Self::~Self() {
-    // Waits for the task to finish so that we don't have the possibility
-    // of the main thread finishing before the task
-    m_task.wait();
+void Self::detach() {
+    if (m_state == nullptr) {
+        return;
+    }
+
+    std::string body;
+    uint64_t sent = 0;
+    pplx::task<void> previous;
+
+    // This only waits for a task that is in the middle of updating the
+    // user, never for the network
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+
+        // Changes that are waiting for the debouncer were going to be pushed,
+        // so they are written out while the user is still here
+        if (m_state->debouncing && m_state->dirty != 0) {
+            Util::JsonWriter writer;
+            Util::writeProfile(writer, *this, m_state->dirty);
+            body = std::string(writer.view());
+
+            sent = m_state->dirty;
+            m_state->dirty = 0;
+            m_state->pushing |= sent;
+            previous = m_state->task;
+        }
+
+        m_state->self = nullptr;
+    }
+
+    // Nothing can use the results anymore
+    m_state->cancellation.cancel();
+
+    // The last push isn't tied to the user's cancellation, and it goes out
+    // after the push that is running, whether that finishes or not. Nobody
+    // is waiting on it, so its errors are dropped.
+    if (sent != 0) {
+        previous.then([state = m_state, body = std::move(body), sent](const pplx::task<void>&) {
+            return sendProfile(state, body, sent, pplx::cancellation_token::none());
+        }, Util::Executors::options(Util::Executors::io(), pplx::cancellation_token::none())).then([](const pplx::task<web::http::status_code>& task) {
+            try {
+                task.get();
+            }
+            catch (...) {
+
+            }
+        });
+    }
+
+    m_state = nullptr;
 }
 
-pplx::task<web::http::status_code> Self::push() {
-    // Waits for the task to be complete just in case there are tasks happening
-    // that need to finish before we push
-    m_task.wait();
+pplx::task<web::http::status_code> Self::push(const pplx::cancellation_token& token, const Util::Deadline& deadline) {
+    return pushState(m_state, token, deadline);
+}
 
-    return pplx::task<web::http::status_code>([this]() -> web::http::status_code {
-        nlohmann::json json;
+pplx::task<web::http::status_code> Self::pushState(const std::shared_ptr<State>& state, const pplx::cancellation_token& token, const Util::Deadline& deadline) {
+    Util::Cancellation::Link link = Util::Cancellation::link({token, state->cancellation.get_token()}, deadline);
+    pplx::cancellation_token linked = link.getToken();
 
-        std::lock_guard<std::mutex> lock(m_mutex);
+    pplx::task<void> previous;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        previous = state->task;
+    }
 
-        // Adds stuff to the JSON object to push to the API
-        json["email"] = m_userEmail;
-        json["facebook_connected"] = m_isFacebookConnected;
-        json["image_url"] = m_userProfileImageURL;
-        json["locale"] = m_locale;
-        json["name"] = m_userNickname;
-        json["phone_number"] = m_userPhoneNumber;
-        json["sms"] = m_isSMS;
-        json["twitter_connected"] = m_isTwitterConnected;
-        json["zip_code"] = m_zipcode;
+    // Chained onto the task just in case there are tasks happening
+    // that need to finish before we push
+    pplx::task<web::http::status_code> pushed = previous.then([state, linked]() {
+        // Every push on this thread reuses the same buffer
+        thread_local Util::JsonWriter writer;
+        writer.clear();
 
-        m_request.set_method(web::http::methods::POST);
+        uint64_t sent;
 
-        m_request.set_body(json.dump());
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
 
-        // API endpoint
-        m_client = web::http::client::http_client("https://api.groupme.com/v3/users/update");
+            Self* self = state->self;
+            if (self == nullptr) {
+                pplx::cancel_current_task();
+            }
 
-        web::http::status_code statusCode = 0;
+            // Nothing changed, so there's nothing to send
+            sent = state->dirty;
+            if (sent == 0) {
+                return pplx::task_from_result<web::http::status_code>(web::http::status_codes::OK);
+            }
+            state->dirty = 0;
+            state->pushing |= sent;
 
-        m_client.request(m_request).then([&statusCode](const web::http::http_response& response) {
-            statusCode = response.status_code();
-            return;
-        }).wait();
-        return statusCode;
-    });
-}
+            // Writes the changed profile fields to push to the API
+            Util::writeProfile(writer, *self, sent);
+        }
 
-pplx::task<web::http::status_code> Self::pull() {
-    // Waits for the task to be complete just in case there are tasks happening
-    // that need to finish before we pull
-    m_task.wait();
+        return sendProfile(state, std::string(writer.view()), sent, linked);
+    }, Util::Executors::options(Util::Executors::io(), linked));
 
-    return pplx::task<web::http::status_code>([this]() -> web::http::status_code {
-        m_request.set_method(web::http::methods::GET);
+    return link.attach(pushed);
+}
 
-        // Resets the body of the request just incase theres
-        // old data in it.
-        m_request.set_body("");
+pplx::task<web::http::status_code> Self::sendProfile(const std::shared_ptr<State>& state, std::string body, uint64_t sent, const pplx::cancellation_token& token) {
+    // API endpoint
+    web::http::client::http_client client("https://api.groupme.com/v3/users/update");
 
-        web::http::status_code statusCode = 0;
+    web::http::http_request request(web::http::methods::POST);
 
-        // Again, the API endpoint
-        m_client = web::http::client::http_client("https://api.groupme.com/v3/users/me");
+    request.headers().add("X-Access-Token", state->accessToken);
 
-        m_client.request(m_request).then([&statusCode, this](const web::http::http_response& response) {
+    request.set_body(std::move(body));
 
-            statusCode = response.status_code();
+    return client.request(request, token).then([state, sent](const pplx::task<web::http::http_response>& task) {
+        // The fields didn't make it to the server, so the next push sends
+        // them again. Ones that were changed again since are dirty anyway
+        auto finish = [&state, sent](bool failed) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->pushing &= ~sent;
+            if (failed) {
+                state->dirty |= sent;
+            }
+        };
+
+        web::http::status_code statusCode;
+        try {
+            statusCode = task.get().status_code();
+        }
+        catch (...) {
+            finish(true);
+            throw;
+        }
+
+        finish(statusCode != web::http::status_codes::OK);
+        return statusCode;
+    }, Util::Executors::options(Util::Executors::io(), token));
+}
 
-            if (statusCode != web::http::status_codes::OK) {
+void Self::debouncePush(const std::weak_ptr<State>& weak, Util::Deadline::Clock::time_point time) {
+    Util::Timer::schedule(time, [weak]() {
+        // The user was destroyed while we were waiting
+        std::shared_ptr<State> state = weak.lock();
+        if (state == nullptr) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->self == nullptr) {
+                state->debouncing = false;
                 return;
             }
 
-            auto json = nlohmann::json::parse(response.extract_string(true).get());
-
-            // The response section of the JSON will be null
-            // if a problem occured
-            if (json["response"] == "null") {
-                //TODO Add checking to the errors section of the JSON if the resonse is null
+            // More changes came in, so wait for those too
+            Util::Deadline::Clock::time_point due = state->lastChange + state->debounce;
+            if (due > Util::Deadline::Clock::now()) {
+                debouncePush(weak, due);
                 return;
             }
+            state->debouncing = false;
+        }
+
+        // Nobody is waiting on this push, so errors are dropped here. The
+        // fields stay dirty when it fails. Later pushes and pulls are
+        // chained after it
+        pplx::task<void> pushed = pushState(state, pplx::cancellation_token::none(), Util::Deadline::none()).then([](const pplx::task<web::http::status_code>& task) {
+            try {
+                task.get();
+            }
+            catch (...) {
 
-            std::lock_guard<std::mutex> lock(m_mutex);
+            }
+        });
 
-            // This just grabs the responses from the json object and parses it
-            m_userID = json["response"]["id"];
-            m_userID.erase(std::remove(m_userID.begin(), m_userID.end(), '\"'), m_userID.end());
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->task = pushed;
+    });
+}
 
-            m_userPhoneNumber = json["response"]["phone_number"];
-            m_userPhoneNumber.erase(std::remove(m_userPhoneNumber.begin(), m_userPhoneNumber.end(), '\"'), m_userPhoneNumber.end());
+template <class T>
+void Self::change(T& member, const T& value, uint64_t bit) {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+
+    if (member == value) {
+        return;
+    }
+
+    member = value;
+    m_state->dirty |= bit;
+    publishRecord();
+
+    // Fields that are never pushed don't need to wake the debouncer
+    if (bit != 0 && m_state->debounce.count() > 0) {
+        m_state->lastChange = Util::Deadline::Clock::now();
+        if (!m_state->debouncing) {
+            m_state->debouncing = true;
+            debouncePush(m_state, m_state->lastChange + m_state->debounce);
+        }
+    }
+}
 
-            m_userProfileImageURL = json["response"]["image_url"];
-            m_userProfileImageURL.erase(std::remove(m_userProfileImageURL.begin(), m_userProfileImageURL.end(), '\"'), m_userProfileImageURL.end());
+void Self::setPushDebounce(std::chrono::milliseconds debounce) {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->debounce = debounce;
+}
 
-            m_createdAt = json["response"]["created_at"];
+bool Self::hasUnpushedChanges() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->dirty != 0;
+}
 
-            m_updatedAt = json["response"]["updated_at"];
+pplx::task<web::http::status_code> Self::pull(const pplx::cancellation_token& token, const Util::Deadline& deadline) {
+    Util::Cancellation::Link link = Util::Cancellation::link({token, m_state->cancellation.get_token()}, deadline);
+    pplx::cancellation_token linked = link.getToken();
 
-            m_userEmail = json["response"]["email"];
-            m_userEmail.erase(std::remove(m_userEmail.begin(), m_userEmail.end(), '\"'), m_userEmail.end());
+    // A debounced push can replace the task from the timer thread
+    pplx::task<void> previous;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        previous = m_state->task;
+    }
 
-            m_isSMS = json["response"]["sms"];
+    // Chained onto the task just in case there are tasks happening
+    // that need to finish before we pull
+    pplx::task<web::http::status_code> pulled = previous.then([state = m_state, linked]() {
+        // Again, the API endpoint
+        web::http::client::http_client client("https://api.groupme.com/v3/users/me");
 
-            m_locale = json["response"]["locale"];
-            m_locale.erase(std::remove(m_locale.begin(), m_locale.end(), '\"'), m_locale.end());
+        web::http::http_request request(web::http::methods::GET);
 
-            m_shareURL = json["response"]["share_url"];
-            m_shareURL.erase(std::remove(m_locale.begin(), m_locale.end(), '\"'), m_locale.end());
+        request.headers().add("X-Access-Token", state->accessToken);
 
-            m_shareQRCodeURL = json["response"]["share_qr_code_url"];
-            m_shareQRCodeURL.erase(std::remove(m_shareQRCodeURL.begin(), m_shareQRCodeURL.end(), '\"'), m_shareQRCodeURL.end());
+        return client.request(request, linked);
+    }, Util::Executors::options(Util::Executors::io(), linked)).then([state = m_state, linked](const web::http::http_response& response) {
+        web::http::status_code statusCode = response.status_code();
 
-        }).wait();
-        return statusCode;
-    });
+        if (statusCode != web::http::status_codes::OK) {
+            return pplx::task_from_result(statusCode);
+        }
+
+        // Parsing is CPU work, so it is moved off of the I/O scheduler
+        return response.extract_string(true).then([state, statusCode](const std::string& body) {
+            Util::Json::Document document(body);
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+
+            // The user was destroyed while the request was in flight
+            Self* self = state->self;
+            if (self == nullptr) {
+                return statusCode;
+            }
+
+            //TODO Add checking to the errors section of the JSON if the resonse is null
+            document.forEachField([self](std::string_view key, Util::Json::Value& value) {
+                // The response section of the JSON will be null if a problem occured
+                if (key == "response" && !value.isNull()) {
+                    self->readProfile(value);
+                }
+            });
+
+            return statusCode;
+        }, Util::Executors::options(Util::Executors::cpu(), linked));
+    }, Util::Executors::options(Util::Executors::io(), linked));
+
+    return link.attach(pulled);
+}
+
+void Self::readProfile(Util::Json::Value& response) {
+    // A setter that ran while a push or this pull was in flight has a
+    // newer value than the server, and it still has to be pushed
+    uint64_t local = m_state->dirty | m_state->pushing;
+
+    Util::readFields(User::Schema::profile, response, *this, [](std::string_view, Util::Json::Value&) {}, ~local);
+    publishRecord();
+}
+
+void Self::cancel() {
+    m_state->cancellation.cancel();
 }
 
 /*
  * Overridden functions to prevent data race senarios
- * Functions must be const for User::operator== and User::operator!=
- * But also must be thread safe. It would be inefficeint to have this in
- * the `User` class because this is the only time stuff is being accessed
- * in another thread
+ * The getters read the record that the setters and pulls publish while
+ * they hold the mutex, so reading never waits on a push or pull. The
+ * setters still take the mutex since the tasks write the same members
  */
 
 std::string Self::getNickname() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_userNickname;
+    return std::string(getRecord()->getNickname());
 }
 
 void Self::setNickname(const std::string& userNickname) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_userNickname = userNickname;
+    change(m_userNickname, userNickname, profileBit("name"));
 }
 
 std::string Self::getProfileImageURL() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_userProfileImageURL;
+    return std::string(getRecord()->getProfileImageURL());
 }
 
 void Self::setProfileImageURL(const std::string& userProfileImageURL) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_userProfileImageURL = userProfileImageURL;
+    change(m_userProfileImageURL, userProfileImageURL, profileBit("image_url"));
 }
 
 std::string Self::getPhoneNumber() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_userPhoneNumber;
+    return std::string(getRecord()->getPhoneNumber());
 }
 
 void Self::setPhoneNumber(const std::string& userPhoneNumber) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_userPhoneNumber = userPhoneNumber;
+    change(m_userPhoneNumber, userPhoneNumber, profileBit("phone_number"));
 }
 
 std::string Self::getEmail() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_userEmail;
+    return std::string(getRecord()->getEmail());
 }
 
 void Self::setEmail(const std::string& userEmail) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_userEmail = userEmail;
+    change(m_userEmail, userEmail, profileBit("email"));
 }
 
 std::string Self::getZipcode() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_zipcode;
+    return std::string(getRecord()->getZipcode());
 }
 
 void Self::setZipcode(const std::string& zipcode) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_zipcode = zipcode;
+    change(m_zipcode, zipcode, profileBit("zip_code"));
 }
 
 bool Self::usingSMS() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_isSMS;
+    return getRecord()->usingSMS();
 }
 
 void Self::setUsingSMS(bool usingSMS) {
     //TODO There should be stuff here to create SMS mode possibly.
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_isSMS = usingSMS;
+    change(m_isSMS, usingSMS, profileBit("sms"));
 }
 
 bool Self::getFacebookConnected() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_isFacebookConnected;
+    return getRecord()->getFacebookConnected();
 }
 
 void Self::setFacebookConnected(bool facebookConnected) {
     //TODO There should be stuff here to add Facebook to the users account
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_isFacebookConnected = facebookConnected;
+    change(m_isFacebookConnected, facebookConnected, profileBit("facebook_connected"));
 }
 
 bool Self::getTwitterConnected() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_isTwitterConnected;
+    return getRecord()->getTwitterConnected();
 }
 
 void Self::setTwitterConnected(bool twitterConnected) {
     //TODO There should be stuff here to add Twitter to the users account
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_isTwitterConnected = twitterConnected;
+    change(m_isTwitterConnected, twitterConnected, profileBit("twitter_connected"));
+}
+
+std::string Self::getID() const {
+    return getRecord()->getID().toString();
+}
+
+// The fields below are only ever set by the server, so changing them
+// takes the mutex and publishes the record but doesn't mark anything dirty
+void Self::setID(const std::string& userID) {
+    change(m_userID, GroupMe::ID(userID), 0);
+}
+
+std::string Self::getGUID() const {
+    return std::string(getRecord()->getGUID());
+}
+
+void Self::setGUID(const std::string& userGUID) {
+    change(m_userGUID, userGUID, 0);
+}
+
+std::string Self::getLocale() const {
+    return std::string(getRecord()->getLocale());
+}
+
+void Self::setLocal(const std::string& locale) {
+    change(m_locale, locale, profileBit("locale"));
+}
+
+std::string Self::getShareURL() const {
+    return std::string(getRecord()->getShareURL());
+}
+
+void Self::setShareURL(const std::string& shareURL) {
+    change(m_shareURL, shareURL, 0);
+}
+
+std::string Self::getShareQRCodeURL() const {
+    return std::string(getRecord()->getShareQRCodeURL());
+}
+
+void Self::setShareQRCodeURL(const std::string& shareQRCodeURL) {
+    change(m_shareQRCodeURL, shareQRCodeURL, 0);
 }
 
-std::pair<GroupMe::UserSet::const_iterator, bool> Self::addContact(const std::shared_ptr<GroupMe::User>& contact) {
+unsigned int Self::getCreatedAt() const {
+    return getRecord()->getCreatedAt();
+}
+
+void Self::setCreatedAt(unsigned int createdAt) {
+    change(m_createdAt, createdAt, 0);
+}
+
+unsigned int Self::getUpdatedAt() const {
+    return getRecord()->getUpdatedAt();
+}
+
+void Self::setUpdatedAt(unsigned int updatedAt) {
+    change(m_updatedAt, updatedAt, 0);
+}
+
+bool Self::addContact(const std::shared_ptr<GroupMe::User>& contact) {
     return m_contacts.insert(contact);
 }
 
-GroupMe::UserSet::const_iterator Self::findContact(const std::string& userID) const {
+std::shared_ptr<const GroupMe::User> Self::findContact(std::string_view userID) const {
     return m_contacts.find(userID);
 }
 
 void Self::mergeContacts(GroupMe::UserSet& set) {
     m_contacts.merge(set);
 }
+
+void Self::updateContacts(const std::function<void(GroupMe::UserSet&)>& update) {
+    m_contacts.update(update);
+}
+
+GroupMe::UserSet::Diff Self::replaceContacts(GroupMe::UserSet contacts) {
+    return m_contacts.replace(std::move(contacts));
+}
+
+std::shared_ptr<const GroupMe::UserSet> Self::getContacts() const {
+    return m_contacts.snapshot();
+}
@@ -0,0 +1,454 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "TailSync.h"
+#include "util/Executors.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace GroupMe;
+
+namespace {
+    // The most messages the endpoint returns at once, a full page means there are more
+    constexpr std::size_t s_pageLimit = 100;
+
+    [[noreturn]] void fail(const char* what) {
+        throw std::fstream::failure(what, std::error_code(errno, std::generic_category()));
+    }
+
+    // Writes the whole file and flushes it to the disk before returning
+    void writeSynced(const std::filesystem::path& path, const std::string& contents) {
+        int descriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (descriptor < 0) {
+            fail("Failed to open file.");
+        }
+
+        const char* data = contents.data();
+        std::size_t length = contents.size();
+        while (length > 0) {
+            ssize_t written = ::write(descriptor, data, length);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ::close(descriptor);
+                fail("Failed to write file.");
+            }
+            data += written;
+            length -= static_cast<std::size_t>(written);
+        }
+
+        if (::fsync(descriptor) != 0) {
+            ::close(descriptor);
+            fail("Failed to write file.");
+        }
+        ::close(descriptor);
+    }
+}
+
+TailSync::State::State() :
+    client(web::uri("https://api.groupme.com/v3/groups"))
+{
+
+}
+
+TailSync::TailSync(const std::string& accessToken, Sink sink) :
+    TailSync(accessToken, std::move(sink), Options())
+{
+
+}
+
+TailSync::TailSync(const std::string& accessToken, Sink sink, const Options& options) :
+    m_state(std::make_shared<State>())
+{
+    m_state->accessToken = accessToken;
+    m_state->sink = std::move(sink);
+    m_state->options = options;
+    m_state->options.minInterval = std::max(options.minInterval, std::chrono::milliseconds(1));
+    m_state->options.maxInterval = std::max(options.maxInterval, m_state->options.minInterval);
+    m_state->options.backoff = std::max(options.backoff, 1.0);
+    m_state->limiter = Util::Limiter::create(options.concurrency);
+}
+
+TailSync::~TailSync() {
+    if (m_state != nullptr) {
+        stop();
+    }
+}
+
+void TailSync::add(const ID& group, const ID& watermark) {
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+
+        auto inserted = m_state->conversations.try_emplace(group);
+        if (!inserted.second) {
+            return;
+        }
+
+        Conversation& conversation = inserted.first->second;
+        conversation.watermark = watermark;
+        conversation.interval = m_state->options.minInterval;
+
+        // It was removed while a poll was running, which polls it again once it's done
+        conversation.nudged = m_state->polling.count(group) > 0;
+
+        enqueue(m_state, group, conversation, Util::Deadline::Clock::now());
+    }
+    pump(m_state);
+}
+
+bool TailSync::remove(const ID& group) {
+    // Its entries in the queue are skipped once they come up
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->conversations.erase(group) > 0;
+}
+
+void TailSync::nudge(const ID& group) {
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+
+        auto conversation = m_state->conversations.find(group);
+        if (conversation == m_state->conversations.end()) {
+            return;
+        }
+
+        // A poll that's already running doesn't see messages sent after it started
+        if (m_state->polling.count(group) > 0) {
+            conversation->second.nudged = true;
+            return;
+        }
+
+        conversation->second.interval = m_state->options.minInterval;
+        enqueue(m_state, group, conversation->second, Util::Deadline::Clock::now());
+    }
+    pump(m_state);
+}
+
+void TailSync::start() {
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+
+        if (m_state->running) {
+            return;
+        }
+
+        m_state->running = true;
+        m_state->cancellation = pplx::cancellation_token_source();
+    }
+    pump(m_state);
+}
+
+void TailSync::stop() {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+
+    m_state->running = false;
+    m_state->cancellation.cancel();
+}
+
+ID TailSync::getWatermark(const ID& group) const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+
+    auto conversation = m_state->conversations.find(group);
+    if (conversation == m_state->conversations.end()) {
+        return ID();
+    }
+    return conversation->second.watermark;
+}
+
+std::chrono::milliseconds TailSync::getInterval(const ID& group) const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+
+    auto conversation = m_state->conversations.find(group);
+    if (conversation == m_state->conversations.end()) {
+        return std::chrono::milliseconds::zero();
+    }
+    return conversation->second.interval;
+}
+
+std::size_t TailSync::size() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->conversations.size();
+}
+
+TailSync::Stats TailSync::getStats() const {
+    Stats stats;
+    stats.requests = m_state->requests.load(std::memory_order_relaxed);
+    stats.idle = m_state->idle.load(std::memory_order_relaxed);
+    stats.messages = m_state->messages.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void TailSync::saveWatermarks(const std::filesystem::path& path) const {
+    // One `group watermark` pair per line, groups that were never polled are left out
+    std::string contents;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+
+        for (const auto& [group, conversation] : m_state->conversations) {
+            if (conversation.watermark.empty()) {
+                continue;
+            }
+            group.appendTo(contents);
+            contents.push_back(' ');
+            conversation.watermark.appendTo(contents);
+            contents.push_back('\n');
+        }
+    }
+
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+
+    // The data has to be on the disk before the rename is, or a crash
+    // could leave an empty file where the old watermarks used to be
+    writeSynced(temporary, contents);
+
+    std::filesystem::rename(temporary, path);
+
+    // Makes the rename itself durable
+    std::filesystem::path directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    int descriptor = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (descriptor >= 0) {
+        ::fsync(descriptor);
+        ::close(descriptor);
+    }
+}
+
+bool TailSync::loadWatermarks(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::vector<std::pair<ID, ID>> watermarks;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+
+        std::string group;
+        std::string watermark;
+        if (fields >> group >> watermark) {
+            watermarks.emplace_back(ID(group), ID(watermark));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+
+        for (const auto& [group, watermark] : watermarks) {
+            auto inserted = m_state->conversations.try_emplace(group);
+
+            Conversation& conversation = inserted.first->second;
+            conversation.watermark = watermark;
+
+            if (inserted.second) {
+                conversation.interval = m_state->options.minInterval;
+                conversation.nudged = m_state->polling.count(group) > 0;
+                enqueue(m_state, group, conversation, Util::Deadline::Clock::now());
+            }
+        }
+    }
+    pump(m_state);
+
+    return true;
+}
+
+void TailSync::enqueue(const std::shared_ptr<State>& state, const ID& group, Conversation& conversation, Util::Deadline::Clock::time_point time) {
+    conversation.generation++;
+    state->queue.push({time, group, conversation.generation});
+}
+
+void TailSync::arm(const std::shared_ptr<State>& state) {
+    if (!state->running || state->queue.empty()) {
+        return;
+    }
+
+    Util::Deadline::Clock::time_point time = state->queue.top().time;
+
+    // An earlier timer is already going to pick this one up
+    if (state->armed && state->armedAt <= time) {
+        return;
+    }
+
+    state->armed = true;
+    state->armedAt = time;
+
+    std::weak_ptr<State> weak = state;
+    Util::Timer::schedule(time, [weak, time]() {
+        std::shared_ptr<State> state = weak.lock();
+        if (state == nullptr) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->armed && state->armedAt == time) {
+                state->armed = false;
+            }
+        }
+        pump(state);
+    });
+}
+
+void TailSync::pump(const std::shared_ptr<State>& state) {
+    std::vector<std::pair<ID, ID>> due;
+    pplx::cancellation_token token = pplx::cancellation_token::none();
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+
+        if (!state->running) {
+            return;
+        }
+
+        token = state->cancellation.get_token();
+
+        Util::Deadline::Clock::time_point now = Util::Deadline::Clock::now();
+        while (!state->queue.empty() && state->queue.top().time <= now) {
+            Due next = state->queue.top();
+            state->queue.pop();
+
+            auto conversation = state->conversations.find(next.group);
+            if (conversation == state->conversations.end() || conversation->second.generation != next.generation || state->polling.count(next.group) > 0) {
+                continue;
+            }
+
+            state->polling.insert(next.group);
+            due.emplace_back(next.group, conversation->second.watermark);
+        }
+
+        arm(state);
+    }
+
+    // The limiter decides how many of these are actually in flight
+    for (const auto& [group, watermark] : due) {
+        poll(state, group, watermark, token);
+    }
+}
+
+void TailSync::poll(const std::shared_ptr<State>& state, const ID& group, const ID& watermark, const pplx::cancellation_token& token) {
+    web::uri_builder uri;
+    uri.append_path(group.toString());
+    uri.append_path("messages");
+    uri.append_query("limit", s_pageLimit);
+    if (!watermark.empty()) {
+        uri.append_query("after_id", watermark.toString());
+    }
+
+    web::http::http_request request(web::http::methods::GET);
+
+    request.set_request_uri(uri.to_uri());
+    request.headers().add("X-Access-Token", state->accessToken);
+
+    state->limiter->run([state, request, token]() {
+        state->requests.fetch_add(1, std::memory_order_relaxed);
+
+        return state->client.request(request, token).then([](const web::http::http_response& response) {
+            // The server answers with 304 when there's nothing new
+            if (response.status_code() == web::http::status_codes::NotModified) {
+                return pplx::task_from_result(std::string());
+            }
+
+            if (response.status_code() != web::http::status_codes::OK) {
+                throw web::http::http_exception(response.status_code());
+            }
+
+            return response.extract_string(true);
+        }, Util::Executors::options(Util::Executors::io(), token));
+    }, token).then([state, group, watermark](const std::string& body) {
+        if (body.empty()) {
+            return std::make_pair(watermark, std::size_t(0));
+        }
+
+        MessagePage page = MessagePage::parse(body);
+
+        ID newest = watermark;
+        for (const auto& message : page) {
+            ID id(message.getID());
+            if (newest.empty() || id > newest) {
+                newest = std::move(id);
+            }
+        }
+
+        if (!page.empty()) {
+            state->sink(group, page);
+        }
+
+        return std::make_pair(std::move(newest), page.size());
+    }, Util::Executors::options(Util::Executors::cpu(), token)).then([state, group, watermark](pplx::task<std::pair<ID, std::size_t>> result) {
+        // Failed polls, including a sink that threw, back off and try again from the same watermark
+        try {
+            std::pair<ID, std::size_t> polled = result.get();
+            finish(state, group, polled.first, polled.second, true);
+        }
+        catch (...) {
+            finish(state, group, watermark, 0, false);
+        }
+    });
+}
+
+void TailSync::finish(const std::shared_ptr<State>& state, const ID& group, const ID& newest, std::size_t messages, bool succeeded) {
+    if (succeeded) {
+        state->messages.fetch_add(messages, std::memory_order_relaxed);
+        if (messages == 0) {
+            state->idle.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+
+        state->polling.erase(group);
+
+        auto found = state->conversations.find(group);
+        if (found == state->conversations.end()) {
+            return;
+        }
+
+        Conversation& conversation = found->second;
+
+        const Options& options = state->options;
+        Util::Deadline::Clock::time_point now = Util::Deadline::Clock::now();
+
+        if (succeeded && messages > 0) {
+            conversation.watermark = newest;
+            conversation.interval = std::max(options.minInterval, std::chrono::milliseconds(static_cast<int64_t>(conversation.interval.count() / options.backoff)));
+        }
+        else {
+            conversation.interval = std::min(options.maxInterval, std::chrono::milliseconds(static_cast<int64_t>(conversation.interval.count() * options.backoff)));
+        }
+
+        // A full page means the group is behind, so there's no point in waiting
+        bool behind = succeeded && messages >= s_pageLimit && !newest.empty();
+
+        if (behind || conversation.nudged) {
+            conversation.nudged = false;
+            enqueue(state, group, conversation, now);
+        }
+        else {
+            enqueue(state, group, conversation, now + conversation.interval);
+        }
+    }
+    pump(state);
+}
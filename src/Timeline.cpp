@@ -0,0 +1,223 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Timeline.h"
+
+#include <algorithm>
+#include <new>
+
+using namespace GroupMe;
+
+// Messages are built in place, so a slot is only a message once `filled` passes it
+struct Timeline::Segment {
+    explicit Segment(uint64_t base) :
+        base(base),
+        next(nullptr),
+        filled(0)
+    {
+
+    }
+
+    ~Segment() {
+        for (std::size_t i = 0; i < filled; i++) {
+            slot(i)->~Message();
+        }
+    }
+
+    Message* slot(std::size_t index) {
+        return std::launder(reinterpret_cast<Message*>(storage + index * sizeof(Message)));
+    }
+
+    const Message* slot(std::size_t index) const {
+        return std::launder(reinterpret_cast<const Message*>(storage + index * sizeof(Message)));
+    }
+
+    // The position of the first message of the segment in the timeline
+    const uint64_t base;
+
+    std::atomic<Segment*> next;
+
+    // Only used by writers, readers go by the size of the timeline
+    std::size_t filled;
+
+    alignas(Message) unsigned char storage[sizeof(Message) * s_segmentSize];
+};
+
+Timeline::View::const_iterator::const_iterator() :
+    m_segment(nullptr),
+    m_index(0)
+{
+
+}
+
+Timeline::View::const_iterator::const_iterator(const Segment* segment, uint64_t index) :
+    m_segment(segment),
+    m_index(index)
+{
+
+}
+
+Timeline::View::const_iterator::reference Timeline::View::const_iterator::operator*() const {
+    return *m_segment->slot(m_index - m_segment->base);
+}
+
+Timeline::View::const_iterator::pointer Timeline::View::const_iterator::operator->() const {
+    return m_segment->slot(m_index - m_segment->base);
+}
+
+Timeline::View::const_iterator& Timeline::View::const_iterator::operator++() {
+    // The next segment is linked before any message in it is published
+    if (++m_index - m_segment->base == s_segmentSize) {
+        m_segment = m_segment->next.load(std::memory_order_acquire);
+    }
+    return *this;
+}
+
+Timeline::View::const_iterator Timeline::View::const_iterator::operator++(int) {
+    const_iterator previous = *this;
+    ++*this;
+    return previous;
+}
+
+uint64_t Timeline::View::const_iterator::index() const {
+    return m_index;
+}
+
+Timeline::View::View(Util::Epoch::Guard guard, const Segment* segment, uint64_t begin, uint64_t end) :
+    m_guard(std::move(guard)),
+    m_segment(segment),
+    m_begin(begin),
+    m_end(end)
+{
+
+}
+
+Timeline::View::const_iterator Timeline::View::begin() const {
+    return const_iterator(m_segment, m_begin);
+}
+
+Timeline::View::const_iterator Timeline::View::end() const {
+    return const_iterator(nullptr, m_end);
+}
+
+std::size_t Timeline::View::size() const {
+    return static_cast<std::size_t>(m_end - m_begin);
+}
+
+bool Timeline::View::empty() const {
+    return m_begin == m_end;
+}
+
+Timeline::Timeline(std::size_t retain) :
+    m_retain(retain),
+    m_head(new Segment(0)),
+    m_tail(m_head.load(std::memory_order_relaxed)),
+    m_size(0)
+{
+
+}
+
+Timeline::~Timeline() {
+    Segment* segment = m_head.load(std::memory_order_acquire);
+    while (segment != nullptr) {
+        Segment* next = segment->next.load(std::memory_order_relaxed);
+        delete segment;
+        segment = next;
+    }
+}
+
+uint64_t Timeline::append(Message message) {
+    std::lock_guard<std::mutex> lock(m_writer);
+
+    uint64_t index = m_size.load(std::memory_order_relaxed);
+    emplace(std::move(message), index);
+
+    // Publishes the message, readers that see the new size see it built
+    m_size.store(index + 1, std::memory_order_release);
+
+    trim();
+    return index;
+}
+
+uint64_t Timeline::append(std::vector<Message> messages) {
+    std::lock_guard<std::mutex> lock(m_writer);
+
+    uint64_t first = m_size.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < messages.size(); i++) {
+        emplace(std::move(messages[i]), first + i);
+    }
+
+    m_size.store(first + messages.size(), std::memory_order_release);
+
+    trim();
+    return first;
+}
+
+Timeline::View Timeline::view() const {
+    return recent(static_cast<std::size_t>(-1));
+}
+
+Timeline::View Timeline::recent(std::size_t count) const {
+    // Pinned before the head is loaded, so it can't be freed under us
+    Util::Epoch::Guard guard = Util::Epoch::pin();
+
+    const Segment* segment = m_head.load(std::memory_order_acquire);
+    uint64_t end = m_size.load(std::memory_order_acquire);
+
+    uint64_t begin = segment->base;
+    if (end - begin > count) {
+        begin = end - count;
+    }
+
+    while (begin < end && begin - segment->base >= s_segmentSize) {
+        segment = segment->next.load(std::memory_order_acquire);
+    }
+
+    return View(std::move(guard), segment, begin, end);
+}
+
+uint64_t Timeline::size() const {
+    return m_size.load(std::memory_order_acquire);
+}
+
+void Timeline::emplace(Message&& message, uint64_t index) {
+    if (index - m_tail->base == s_segmentSize) {
+        Segment* segment = new Segment(index);
+        m_tail->next.store(segment, std::memory_order_release);
+        m_tail = segment;
+    }
+
+    new (m_tail->slot(index - m_tail->base)) Message(std::move(message));
+    m_tail->filled++;
+}
+
+void Timeline::trim() {
+    uint64_t size = m_size.load(std::memory_order_relaxed);
+
+    Segment* head = m_head.load(std::memory_order_relaxed);
+    while (head != m_tail && head->base + s_segmentSize + m_retain <= size) {
+        Segment* next = head->next.load(std::memory_order_relaxed);
+
+        // Unlinked first, so readers that pin after this never reach it
+        m_head.store(next, std::memory_order_release);
+        Util::Epoch::retire([head]() {
+            delete head;
+        });
+
+        head = next;
+    }
+}
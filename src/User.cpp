@@ -47,11 +47,16 @@ User::User() :
 }
 
 std::string User::getID() const {
-    return m_userID;
+    return m_userID.toString();
 }
 
 void User::setID(const std::string& userID) {
-    m_userID = userID;
+    m_userID = GroupMe::ID(userID);
+    invalidateRecord();
+}
+
+const GroupMe::ID& User::getCompactID() const {
+    return m_userID;
 }
 
 std::string User::getNickname() const {
@@ -60,6 +65,7 @@ std::string User::getNickname() const {
 
 void User::setNickname(const std::string& userNickname) {
     m_userNickname = userNickname;
+    invalidateRecord();
 }
 
 std::string User::getProfileImageURL() const {
@@ -68,6 +74,7 @@ std::string User::getProfileImageURL() const {
 
 void User::setProfileImageURL(const std::string& userProfileImageURL) {
     m_userProfileImageURL = userProfileImageURL;
+    invalidateRecord();
 }
 
 std::string User::getPhoneNumber() const {
@@ -76,6 +83,7 @@ std::string User::getPhoneNumber() const {
 
 void User::setPhoneNumber(const std::string& userPhoneNumber) {
     m_userPhoneNumber = userPhoneNumber;
+    invalidateRecord();
 }
 
 std::string User::getEmail() const {
@@ -84,6 +92,7 @@ std::string User::getEmail() const {
 
 void User::setEmail(const std::string& userEmail) {
     m_userEmail = userEmail;
+    invalidateRecord();
 }
 
 std::string User::getGUID() const {
@@ -92,6 +101,7 @@ std::string User::getGUID() const {
 
 void User::setGUID(const std::string& userGUID) {
     m_userGUID = userGUID;
+    invalidateRecord();
 }
 
 std::string User::getLocale() const {
@@ -100,6 +110,7 @@ std::string User::getLocale() const {
 
 void User::setLocal(const std::string& locale) {
     m_locale = locale;
+    invalidateRecord();
 }
 
 std::string User::getZipcode() const {
@@ -108,6 +119,7 @@ std::string User::getZipcode() const {
 
 void User::setZipcode(const std::string& zipcode) {
     m_zipcode = zipcode;
+    invalidateRecord();
 }
 
 std::string User::getShareURL() const {
@@ -116,6 +128,7 @@ std::string User::getShareURL() const {
 
 void User::setShareURL(const std::string& shareURL) {
     m_shareURL = shareURL;
+    invalidateRecord();
 }
 
 std::string User::getShareQRCodeURL() const {
@@ -124,6 +137,7 @@ std::string User::getShareQRCodeURL() const {
 
 void User::setShareQRCodeURL(const std::string& shareQRCodeURL) {
     m_shareQRCodeURL = shareQRCodeURL;
+    invalidateRecord();
 }
 
 unsigned int User::getCreatedAt() const {
@@ -132,6 +146,7 @@ unsigned int User::getCreatedAt() const {
 
 void User::setCreatedAt(unsigned int createdAt) {
     m_createdAt = createdAt;
+    invalidateRecord();
 }
 
 unsigned int User::getUpdatedAt() const {
@@ -140,6 +155,7 @@ unsigned int User::getUpdatedAt() const {
 
 void User::setUpdatedAt(unsigned int updatedAt) {
     m_updatedAt = updatedAt;
+    invalidateRecord();
 }
 
 bool User::usingSMS() const {
@@ -148,6 +164,7 @@ bool User::usingSMS() const {
 
 void User::setUsingSMS(bool usingSMS) {
     m_isSMS = usingSMS;
+    invalidateRecord();
 }
 
 bool User::getFacebookConnected() const {
@@ -156,6 +173,7 @@ bool User::getFacebookConnected() const {
 
 void User::setFacebookConnected(bool facebookConnected) {
     m_isFacebookConnected = facebookConnected;
+    invalidateRecord();
 }
 
 bool User::getTwitterConnected() const {
@@ -164,25 +182,35 @@ bool User::getTwitterConnected() const {
 
 void User::setTwitterConnected(bool twitterConnected) {
     m_isTwitterConnected = twitterConnected;
+    invalidateRecord();
 }
 
 bool User::operator==(const User& user) const {
-    if (this->getGUID() != user.getGUID()) {
+    // Different fingerprints are never equal, but records aren't made
+    // just for this
+    std::shared_ptr<const UserRecord> record = std::atomic_load_explicit(&m_record, std::memory_order_acquire);
+    std::shared_ptr<const UserRecord> other = std::atomic_load_explicit(&user.m_record, std::memory_order_acquire);
+    if (record != nullptr && other != nullptr && record->getFingerprint() != other->getFingerprint()) {
         return false;
     }
-    else if (this->getID() != user.getID()) {
+
+    // Compares the members directly, the getters would copy every string
+    if (m_userGUID != user.m_userGUID) {
+        return false;
+    }
+    else if (m_userID != user.m_userID) {
         return false;
     }
-    else if (this->getPhoneNumber() != user.getPhoneNumber()) {
+    else if (m_userPhoneNumber != user.m_userPhoneNumber) {
         return false;
     }
-    else if (this->getEmail() != user.getEmail()) {
+    else if (m_userEmail != user.m_userEmail) {
         return false;
     }
-    else if (this->getProfileImageURL() != user.getProfileImageURL()) {
+    else if (m_userProfileImageURL != user.m_userProfileImageURL) {
         return false;
     }
-    else if (this->getNickname() != user.getNickname()) {
+    else if (m_userNickname != user.m_userNickname) {
         return false;
     }
     return true;
@@ -192,3 +220,25 @@ bool User::operator!=(const User& user) const {
     // This legit just returns the oposite of the equals comparison operator
     return !(this->operator==(user));
 }
+
+std::shared_ptr<const UserRecord> User::getRecord() const {
+    std::shared_ptr<const UserRecord> record = std::atomic_load_explicit(&m_record, std::memory_order_acquire);
+    if (record == nullptr) {
+        // Two threads can both get here, they just make the same record
+        record = std::make_shared<const UserRecord>(*this);
+        std::atomic_store_explicit(&m_record, record, std::memory_order_release);
+    }
+    return record;
+}
+
+uint64_t User::getFingerprint() const {
+    return getRecord()->getFingerprint();
+}
+
+void User::publishRecord() {
+    std::atomic_store_explicit(&m_record, std::make_shared<const UserRecord>(*this), std::memory_order_release);
+}
+
+void User::invalidateRecord() {
+    std::atomic_store_explicit(&m_record, std::shared_ptr<const UserRecord>(), std::memory_order_release);
+}
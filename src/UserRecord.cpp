@@ -0,0 +1,161 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "UserRecord.h"
+#include "User.h"
+
+#include <functional>
+
+using namespace GroupMe;
+
+namespace {
+    // Folds the hash of one field into the fingerprint, mixing after
+    // every field so the same text in a different field hashes differently
+    uint64_t combine(uint64_t fingerprint, std::size_t hash) {
+        fingerprint ^= static_cast<uint64_t>(hash);
+        fingerprint ^= fingerprint >> 30;
+        fingerprint *= 0xbf58476d1ce4e5b9ULL;
+        fingerprint ^= fingerprint >> 27;
+        fingerprint *= 0x94d049bb133111ebULL;
+        fingerprint ^= fingerprint >> 31;
+        return fingerprint;
+    }
+}
+
+UserRecord::UserRecord(const User& user) :
+    m_id(user.m_userID),
+    m_createdAt(user.m_createdAt),
+    m_updatedAt(user.m_updatedAt),
+    m_isSMS(user.m_isSMS),
+    m_isFacebookConnected(user.m_isFacebookConnected),
+    m_isTwitterConnected(user.m_isTwitterConnected)
+{
+    const std::array<const std::string*, Text::Count> texts = {{
+        &user.m_userNickname,
+        &user.m_userProfileImageURL,
+        &user.m_userPhoneNumber,
+        &user.m_userEmail,
+        &user.m_userGUID,
+        &user.m_locale,
+        &user.m_zipcode,
+        &user.m_shareURL,
+        &user.m_shareQRCodeURL
+    }};
+
+    // Sized up front so the buffer is allocated once
+    std::size_t size = 0;
+    for (const std::string* string : texts) {
+        size += string->size();
+    }
+    m_text.reserve(size);
+
+    for (std::size_t i = 0; i < texts.size(); i++) {
+        m_offsets[i] = static_cast<uint32_t>(m_text.size());
+        m_text.append(*texts[i]);
+    }
+    m_offsets[Text::Count] = static_cast<uint32_t>(m_text.size());
+
+    // The same fields as `operator==`, so equal records always have equal fingerprints
+    std::hash<std::string_view> hash;
+    m_fingerprint = combine(0, m_id.hash());
+    for (Text field : {Text::GUID, Text::PhoneNumber, Text::Email, Text::ProfileImageURL, Text::Nickname}) {
+        m_fingerprint = combine(m_fingerprint, hash(text(field)));
+    }
+}
+
+const ID& UserRecord::getID() const {
+    return m_id;
+}
+
+std::string_view UserRecord::getNickname() const {
+    return text(Text::Nickname);
+}
+
+std::string_view UserRecord::getProfileImageURL() const {
+    return text(Text::ProfileImageURL);
+}
+
+std::string_view UserRecord::getPhoneNumber() const {
+    return text(Text::PhoneNumber);
+}
+
+std::string_view UserRecord::getEmail() const {
+    return text(Text::Email);
+}
+
+std::string_view UserRecord::getGUID() const {
+    return text(Text::GUID);
+}
+
+std::string_view UserRecord::getLocale() const {
+    return text(Text::Locale);
+}
+
+std::string_view UserRecord::getZipcode() const {
+    return text(Text::Zipcode);
+}
+
+std::string_view UserRecord::getShareURL() const {
+    return text(Text::ShareURL);
+}
+
+std::string_view UserRecord::getShareQRCodeURL() const {
+    return text(Text::ShareQRCodeURL);
+}
+
+unsigned int UserRecord::getCreatedAt() const {
+    return m_createdAt;
+}
+
+unsigned int UserRecord::getUpdatedAt() const {
+    return m_updatedAt;
+}
+
+bool UserRecord::usingSMS() const {
+    return m_isSMS;
+}
+
+bool UserRecord::getFacebookConnected() const {
+    return m_isFacebookConnected;
+}
+
+bool UserRecord::getTwitterConnected() const {
+    return m_isTwitterConnected;
+}
+
+uint64_t UserRecord::getFingerprint() const {
+    return m_fingerprint;
+}
+
+bool UserRecord::operator==(const UserRecord& other) const {
+    return m_fingerprint == other.m_fingerprint &&
+        m_id == other.m_id &&
+        getGUID() == other.getGUID() &&
+        getPhoneNumber() == other.getPhoneNumber() &&
+        getEmail() == other.getEmail() &&
+        getProfileImageURL() == other.getProfileImageURL() &&
+        getNickname() == other.getNickname();
+}
+
+bool UserRecord::operator!=(const UserRecord& other) const {
+    return !(*this == other);
+}
+
+std::string_view UserRecord::text(Text text) const {
+    return std::string_view(m_text).substr(m_offsets[text], m_offsets[text + 1] - m_offsets[text]);
+}
@@ -17,15 +17,32 @@
 */
 
 #include "Video.h"
+#include "util/Json.h"
 
 using namespace GroupMe;
 
+Video::State::State(const web::uri& endpoint) :
+    client(endpoint),
+    owners(1)
+{
+
+}
+
 Video::Video(const std::string& accessToken, const std::filesystem::path& path, const std::string& conversationID) :
     Attachment(path, Attachment::Types::Video, accessToken),
-    m_client("https://video.groupme.com/transcode"),
-    m_conversationID(conversationID)
+    m_state(std::make_shared<State>(web::uri("https://video.groupme.com/transcode")))
 {
-    m_task = pplx::task<void>([&, this]() {
+    Util::Cancellation::Link link = Util::Cancellation::link({m_state->cancellation.get_token(), m_state->preparation.get_token()});
+    pplx::cancellation_token token = link.getToken();
+
+    m_state->content = m_content;
+
+    m_state->request.set_method(web::http::methods::POST);
+    m_state->request.headers().add("X-Access-Token", m_accessToken);
+    m_state->request.headers().add("X-Conversation-Id", conversationID);
+    m_state->request.headers().add("Content-Type", "multipart/form-data; boundary=" + m_state->parser.getBoundary());
+
+    m_state->task = pplx::task<void>([state = m_state, path]() {
         // avformat is used to grab the duration of
         // the video to make sure we don't upload a
         // video that is too long. Max is 1 minute
@@ -35,119 +52,170 @@ Video::Video(const std::string& accessToken, const std::filesystem::path& path,
             throw LargeFile();
         }
 
-        m_request.set_method(web::http::methods::POST);
-        m_request.headers().add("X-Access-Token", m_accessToken);
-        m_request.headers().add("X-Conversation-Id", m_conversationID);
-
-        m_parser.addFile(m_contentPath);
-        m_request.headers().add("Content-Type", "multipart/form-data; boundary=" + m_parser.getBoundary());
+        state->parser.addFile(path);
         return;
-    });
+    }, Util::Executors::options(Util::Executors::cpu(), token));
+
+    link.attach(m_state->task);
 }
 
 Video::Video(const std::string& accessToken, const std::vector<unsigned char>& contentVector, const std::string& conversationID) :
     Attachment(contentVector, Attachment::Types::Video, accessToken),
-    m_client("https://video.groupme.com/transcode"),
-    m_conversationID(conversationID)
+    m_state(std::make_shared<State>(web::uri("https://video.groupme.com/transcode")))
 {
-    m_task = pplx::task<void>([this, contentVector]() {
+    Util::Cancellation::Link link = Util::Cancellation::link({m_state->cancellation.get_token(), m_state->preparation.get_token()});
+    pplx::cancellation_token token = link.getToken();
+
+    m_state->content = m_content;
+
+    m_state->request.set_method(web::http::methods::POST);
+    m_state->request.headers().add("X-Access-Token", m_accessToken);
+    m_state->request.headers().add("X-Conversation-Id", conversationID);
+    m_state->request.headers().add("Content-Type", "multipart/form-data;boundary=" + m_state->parser.getBoundary());
+
+    // The parser keeps its own copy, so the one in the attachment isn't needed
+    m_state->task = pplx::task<void>([state = m_state, contentVector = std::move(m_contentBinary)]() {
         Util::AVFormat format(contentVector);
 
         if (static_cast<double>(format.get()->duration / AV_TIME_BASE) > 60.0) {
             throw LargeFile();
         }
 
-        m_request.set_method(web::http::methods::POST);
-        m_request.headers().add("X-Access-Token", m_accessToken);
-        m_request.headers().add("X-Conversation-Id", m_conversationID);
+        state->parser.addFile(contentVector, "file.mp4");
+    }, Util::Executors::options(Util::Executors::cpu(), token));
 
-        m_parser.addFile(contentVector, "file.mp4");
-        m_request.headers().add("Content-Type", "multipart/form-data;boundary=" + m_parser.getBoundary());
-    });
+    link.attach(m_state->task);
 }
 
 Video::Video(const std::string& accessToken, const web::uri& contentURL,const  std::string& conversationID) :
     Attachment(contentURL, Attachment::Types::Video, accessToken),
-    m_client(m_content),
-    m_conversationID(conversationID)
+    m_state(std::make_shared<State>(contentURL))
 {
-    m_content = contentURL.to_string();
+    Util::Cancellation::Link link = Util::Cancellation::link({m_state->cancellation.get_token(), m_state->preparation.get_token()});
+    pplx::cancellation_token token = link.getToken();
 
-    m_task = pplx::task<void>([this]() -> void {
+    m_state->content = m_content;
 
-        m_request.set_method(web::http::methods::GET);
-        pplx::task<web::http::http_response> task = m_client.request(m_request);
-        task.then([this](const web::http::http_response& response) {
+    m_state->request.set_method(web::http::methods::GET);
 
-            std::stringstream strm;
+    m_state->task = m_state->client.request(m_state->request, token).then([](const web::http::http_response& response) {
+        return response.extract_vector();
+    }, Util::Executors::options(Util::Executors::io(), token)).then([state = m_state, accessToken = m_accessToken, conversationID](const std::vector<unsigned char>& content) {
+        state->parser.addFile(content, "file.mp4");
 
-            strm << response.extract_string(true).get();
+        state->client = web::http::client::http_client("https://video.groupme.com/transcode");
 
-            m_contentBinary.assign(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
+        state->request.set_method(web::http::methods::POST);
+        state->request.headers().add("X-Access-Token", accessToken);
+        state->request.headers().add("X-Conversation-Id", conversationID);
+        state->request.headers().add("Content-Type", "multipart/form-data;boundary=" + state->parser.getBoundary());
+        state->request.set_body("");
+    }, Util::Executors::options(Util::Executors::io(), token));
 
-            m_parser.addFile(m_contentBinary, "file.mp4");
-
-        });
-        m_client = web::http::client::http_client("https://video.groupme.com/transcode");
+    link.attach(m_state->task);
+}
 
-        m_request.set_method(web::http::methods::POST);
-        m_request.headers().add("X-Access-Token", m_accessToken);
-        m_request.headers().add("Content-Type", "multipart/form-data;boundary=" + m_parser.getBoundary());
-        m_request.set_body("");
-    });
+Video::Video(const Video& other) :
+    Attachment(other),
+    m_state(other.m_state)
+{
+    acquire();
 }
 
 Video::~Video() {
-    m_task.wait();
+    release();
 }
 
-pplx::task<std::string> Video::upload() {
-    m_task.wait();
-
-    m_request.set_body(m_parser.generateBody());
-
-    return pplx::task<std::string>([this]() -> std::string {
-
-        m_json = nlohmann::json::parse(m_client.request(m_request).get().extract_string(true).get());
-
-        m_content = m_json["status_url"].dump();
-
-        m_content.erase(std::remove(m_content.begin(), m_content.end(), '"'), m_content.end());
-
-        m_client = web::http::client::http_client(m_content);
-
-        m_request.set_method(web::http::methods::GET);
+Video& Video::operator=(const Video& other) {
+    if (this != &other) {
+        release();
+        Attachment::operator=(other);
+        m_state = other.m_state;
+        acquire();
+    }
+    return *this;
+}
 
-        m_request.set_body("");
+Video& Video::operator=(Video&& other) noexcept {
+    if (this != &other) {
+        release();
+        Attachment::operator=(std::move(other));
+        m_state = std::move(other.m_state);
+    }
+    return *this;
+}
 
-        bool done = false;
+void Video::acquire() {
+    if (m_state != nullptr) {
+        m_state->owners.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
-        // The video upload request if done correctly give us
-        // a status url for an upload so we keep checking that
-        // until the url says that it is finished.
-        while (!done) {
-            m_client.request(m_request).then([&done, this](const web::http::http_response& response) {
-                if (response.status_code() == web::http::status_codes::Created) {
+void Video::release() {
+    release(m_state);
+    m_state = nullptr;
+}
 
-                    std::string content;
+void Video::release(const std::shared_ptr<State>& state) {
+    if (state == nullptr || state->owners.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
 
-                    m_json.clear();
+    state->preparation.cancel();
 
-                    m_json = nlohmann::json::parse(response.extract_string(true).get());
+    // The preparation might still be writing to the buffers, so they're
+    // only freed after it has stopped
+    state->task.then([state](const pplx::task<void>&) {
+        state->parser.clear();
+    }, Util::Executors::options(Util::Executors::io(), pplx::cancellation_token::none()));
+}
 
-                    content = m_json["url"].dump();
+pplx::task<std::string> Video::upload(const pplx::cancellation_token& token, const Util::Deadline& deadline) {
+    Util::Cancellation::Link link = Util::Cancellation::link({token, m_state->cancellation.get_token()}, deadline);
+    pplx::cancellation_token linked = link.getToken();
+
+    // Building the body copies the whole video, so that part runs on the
+    // CPU scheduler and everything after it is network continuations
+    pplx::task<std::string> upload = m_state->task.then([state = m_state, linked]() {
+        state->request.set_body(state->parser.generateBody());
+        return state->client.request(state->request, linked);
+    }, Util::Executors::options(Util::Executors::cpu(), linked)).then([](const web::http::http_response& response) {
+        return response.extract_string(true);
+    }, Util::Executors::options(Util::Executors::io(), linked)).then([linked](const std::string& body) {
+        return poll(std::make_shared<web::http::client::http_client>(Util::Json::Document(body).getString("/status_url")), linked);
+    }, Util::Executors::options(Util::Executors::io(), linked)).then([state = m_state](const std::string& content) {
+        state->content->set(content);
+        return content;
+    }, Util::Executors::options(Util::Executors::io(), linked));
+
+    // A running upload keeps the preparation alive just like a copy does
+    m_state->owners.fetch_add(1, std::memory_order_relaxed);
+    upload.then([state = m_state](const pplx::task<std::string>&) {
+        release(state);
+    }, Util::Executors::options(Util::Executors::io(), pplx::cancellation_token::none()));
+
+    return link.attach(upload);
+}
 
-                    content.erase(std::remove(content.begin(), content.end(), '"'), content.end());
+// The video upload request if done correctly give us a status url for
+// an upload so we keep checking that until the url says that it is
+// finished. The wait between checks is on the timer, not on a worker.
+pplx::task<std::string> Video::poll(const std::shared_ptr<web::http::client::http_client>& client, const pplx::cancellation_token& token) {
+    web::http::http_request request(web::http::methods::GET);
+
+    return client->request(request, token).then([client, token](const web::http::http_response& response) -> pplx::task<std::string> {
+        if (response.status_code() == web::http::status_codes::Created) {
+            return response.extract_string(true).then([](const std::string& body) {
+                return Util::Json::Document(body).getString("/url");
+            }, Util::Executors::options(Util::Executors::io(), token));
+        }
 
-                    m_content = content;
+        return Util::Timer::delay(std::chrono::milliseconds(300), token).then([client, token]() {
+            return poll(client, token);
+        }, Util::Executors::options(Util::Executors::io(), token));
+    }, Util::Executors::options(Util::Executors::io(), token));
+}
 
-                    done = true;
-                }
-                else {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(300));
-                }
-            }).wait();
-        }
-        return m_content;
-    });
+void Video::cancel() {
+    m_state->cancellation.cancel();
 }
@@ -0,0 +1,317 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "util/Cancellation.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+using namespace GroupMe::Util;
+
+namespace {
+    // A single thread that runs callbacks once their time passes, like
+    // cancelling a token at its deadline. It's only started the first
+    // time it's used.
+    class TimerThread {
+        public:
+            static TimerThread& instance() {
+                static TimerThread timer;
+                return timer;
+            }
+
+            TimerThread(const TimerThread& other) = delete;
+
+            TimerThread& operator=(const TimerThread& other) = delete;
+
+            Timer::Handle add(Deadline::Clock::time_point time, std::function<void()> callback) {
+                Timer::Handle handle;
+                handle.time = time;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    handle.id = ++m_lastID;
+                    m_callbacks.emplace(std::make_pair(time, handle.id), std::move(callback));
+                }
+                m_cv.notify_one();
+                return handle;
+            }
+
+            void remove(const Timer::Handle& handle) {
+                std::function<void()> callback;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    auto found = m_callbacks.find(std::make_pair(handle.time, handle.id));
+                    if (found == m_callbacks.end()) {
+                        return;
+                    }
+                    callback = std::move(found->second);
+                    m_callbacks.erase(found);
+                }
+                // Whatever the callback holds is destroyed outside of the lock
+            }
+
+        private:
+            TimerThread() :
+                m_stopping(false),
+                m_thread(&TimerThread::run, this)
+            {
+
+            }
+
+            ~TimerThread() {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stopping = true;
+                }
+                m_cv.notify_one();
+                m_thread.join();
+            }
+
+            void run() {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while (!m_stopping) {
+                    if (m_callbacks.empty()) {
+                        m_cv.wait(lock);
+                        continue;
+                    }
+
+                    auto first = m_callbacks.begin();
+                    if (first->first.first > Deadline::Clock::now()) {
+                        m_cv.wait_until(lock, first->first.first);
+                        continue;
+                    }
+
+                    std::function<void()> callback = std::move(first->second);
+                    m_callbacks.erase(first);
+
+                    // Callbacks can schedule more callbacks, so the lock is
+                    // released while they run
+                    lock.unlock();
+                    callback();
+                    lock.lock();
+                }
+            }
+
+            // Keyed by the time and then the ID, so callbacks for the same time run in order
+            std::map<std::pair<Deadline::Clock::time_point, uint64_t>, std::function<void()>> m_callbacks;
+
+            uint64_t m_lastID = 0;
+
+            std::mutex m_mutex;
+
+            std::condition_variable m_cv;
+
+            bool m_stopping;
+
+            std::thread m_thread;
+    };
+}
+
+Deadline::Deadline() :
+    m_time(),
+    m_set(false)
+{
+
+}
+
+Deadline::Deadline(Clock::time_point time) :
+    m_time(time),
+    m_set(true)
+{
+
+}
+
+Deadline Deadline::none() {
+    return Deadline();
+}
+
+Deadline Deadline::after(Clock::duration duration) {
+    return Deadline(Clock::now() + duration);
+}
+
+bool Deadline::isSet() const {
+    return m_set;
+}
+
+bool Deadline::expired() const {
+    return m_set && Clock::now() >= m_time;
+}
+
+Deadline::Clock::time_point Deadline::time() const {
+    return m_time;
+}
+
+Cancellation::Link::Link() :
+    m_token(pplx::cancellation_token::none())
+{
+
+}
+
+Cancellation::Link::Link(pplx::cancellation_token token) :
+    m_token(std::move(token))
+{
+
+}
+
+Cancellation::Link::Link(std::shared_ptr<State> state) :
+    m_state(std::move(state)),
+    m_token(m_state->source.get_token())
+{
+
+}
+
+const pplx::cancellation_token& Cancellation::Link::getToken() const {
+    return m_token;
+}
+
+void Cancellation::Link::release() const {
+    if (m_state != nullptr) {
+        m_state->release();
+    }
+}
+
+Cancellation::Link::State::~State() {
+    release();
+}
+
+void Cancellation::Link::State::release() {
+    std::vector<std::pair<pplx::cancellation_token, pplx::cancellation_token_registration>> linked;
+    bool dropTimer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (released) {
+            return;
+        }
+        released = true;
+        linked.swap(registrations);
+        dropTimer = timed;
+    }
+
+    // Deregistering waits for a callback that is running on another
+    // thread, and the callback cancels the source, so it's done unlocked
+    for (const auto& [token, registration] : linked) {
+        token.deregister_callback(registration);
+    }
+
+    if (dropTimer) {
+        Timer::cancel(timer);
+    }
+}
+
+Cancellation::Link Cancellation::link(std::initializer_list<pplx::cancellation_token> tokens, const Deadline& deadline) {
+    std::vector<pplx::cancellation_token> cancelable;
+    for (const auto& token : tokens) {
+        if (token.is_cancelable()) {
+            cancelable.push_back(token);
+        }
+    }
+
+    if (!deadline.isSet()) {
+        if (cancelable.empty()) {
+            return Link();
+        }
+        if (cancelable.size() == 1) {
+            return Link(cancelable.front());
+        }
+    }
+
+    // pplx's linked sources never unregister from their parents, so the
+    // callbacks are registered here where they can be taken back
+    auto state = std::make_shared<Link::State>();
+    pplx::cancellation_token_source source = state->source;
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+
+        for (const auto& token : cancelable) {
+            state->registrations.emplace_back(token, token.register_callback([source]() {
+                source.cancel();
+            }));
+        }
+
+        if (deadline.isSet() && !deadline.expired()) {
+            state->timed = true;
+            state->timer = Timer::schedule(deadline.time(), [source]() {
+                source.cancel();
+            });
+        }
+    }
+
+    if (deadline.expired()) {
+        source.cancel();
+    }
+
+    return Link(std::move(state));
+}
+
+bool Cancellation::sleepFor(std::chrono::milliseconds duration, const pplx::cancellation_token& token) {
+    if (!token.is_cancelable()) {
+        std::this_thread::sleep_for(duration);
+        return true;
+    }
+
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool cancelled = false;
+    };
+
+    // Shared because the callback can run on another thread after we return
+    auto state = std::make_shared<State>();
+
+    auto registration = token.register_callback([state]() {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->cancelled = true;
+        }
+        state->cv.notify_all();
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait_for(lock, duration, [&state]() {
+            return state->cancelled;
+        });
+    }
+
+    token.deregister_callback(registration);
+    return !token.is_canceled();
+}
+
+Timer::Handle Timer::schedule(Deadline::Clock::time_point time, std::function<void()> callback) {
+    return TimerThread::instance().add(time, std::move(callback));
+}
+
+void Timer::cancel(const Handle& handle) {
+    TimerThread::instance().remove(handle);
+}
+
+pplx::task<void> Timer::delay(std::chrono::milliseconds duration, const pplx::cancellation_token& token) {
+    pplx::task_completion_event<void> event;
+
+    schedule(Deadline::Clock::now() + duration, [event]() {
+        event.set();
+    });
+
+    // The token cancels the task right away, the event being set later
+    // on doesn't do anything
+    return pplx::create_task(event, pplx::task_options(token));
+}
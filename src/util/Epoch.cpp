@@ -0,0 +1,181 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "util/Epoch.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+using namespace GroupMe::Util;
+
+std::atomic<uint64_t> Epoch::s_epoch(1);
+
+std::atomic<Epoch::Participant*> Epoch::s_participants(nullptr);
+
+std::mutex Epoch::s_mutex;
+
+std::vector<Epoch::Retired> Epoch::s_retired;
+
+// Claims a participant for a thread and gives it back when the thread exits
+class Epoch::Registration {
+    public:
+        Registration() :
+            m_participant(nullptr)
+        {
+            // Reuse the slot of a thread that exited before adding a new one
+            for (Participant* participant = s_participants.load(std::memory_order_acquire); participant != nullptr; participant = participant->next) {
+                bool used = false;
+                if (participant->used.compare_exchange_strong(used, true, std::memory_order_acq_rel)) {
+                    m_participant = participant;
+                    return;
+                }
+            }
+
+            m_participant = new Participant();
+            m_participant->used.store(true, std::memory_order_relaxed);
+
+            Participant* head = s_participants.load(std::memory_order_relaxed);
+            do {
+                m_participant->next = head;
+            } while (!s_participants.compare_exchange_weak(head, m_participant, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        ~Registration() {
+            m_participant->epoch.store(0, std::memory_order_release);
+            m_participant->used.store(false, std::memory_order_release);
+        }
+
+        Participant& get() {
+            return *m_participant;
+        }
+
+    private:
+        Participant* m_participant;
+};
+
+Epoch::Guard::Guard() :
+    m_pinned(false)
+{
+
+}
+
+Epoch::Guard::Guard(Guard&& other) noexcept :
+    m_pinned(std::exchange(other.m_pinned, false))
+{
+
+}
+
+Epoch::Guard& Epoch::Guard::operator=(Guard&& other) noexcept {
+    if (this != &other) {
+        release();
+        m_pinned = std::exchange(other.m_pinned, false);
+    }
+    return *this;
+}
+
+Epoch::Guard::~Guard() {
+    release();
+}
+
+void Epoch::Guard::release() {
+    if (!m_pinned) {
+        return;
+    }
+    m_pinned = false;
+
+    Participant& participant = local();
+    if (--participant.depth == 0) {
+        participant.epoch.store(0, std::memory_order_release);
+    }
+}
+
+Epoch::Guard Epoch::pin() {
+    Participant& participant = local();
+
+    if (participant.depth++ == 0) {
+        participant.epoch.store(s_epoch.load(std::memory_order_seq_cst), std::memory_order_relaxed);
+
+        // The pin has to be visible before anything is read under it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    Guard guard;
+    guard.m_pinned = true;
+    return guard;
+}
+
+void Epoch::retire(std::function<void()> reclaim) {
+    // Whatever was unlinked has to be visible before the epoch is read
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_retired.push_back({s_epoch.load(std::memory_order_seq_cst), std::move(reclaim)});
+    }
+    collect();
+}
+
+std::size_t Epoch::collect() {
+    std::vector<Retired> safe;
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        advance();
+
+        uint64_t epoch = s_epoch.load(std::memory_order_seq_cst);
+
+        auto keep = std::partition(s_retired.begin(), s_retired.end(), [epoch](const Retired& retired) {
+            return retired.epoch + 2 > epoch;
+        });
+
+        std::move(keep, s_retired.end(), std::back_inserter(safe));
+        s_retired.erase(keep, s_retired.end());
+    }
+
+    // Reclaimed outside of the lock, so they can retire more
+    for (auto& retired : safe) {
+        retired.reclaim();
+    }
+
+    return safe.size();
+}
+
+std::size_t Epoch::pending() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_retired.size();
+}
+
+Epoch::Participant& Epoch::local() {
+    thread_local Registration registration;
+    return registration.get();
+}
+
+bool Epoch::advance() {
+    uint64_t epoch = s_epoch.load(std::memory_order_seq_cst);
+
+    // Every pinned thread has to have seen the current epoch
+    for (Participant* participant = s_participants.load(std::memory_order_acquire); participant != nullptr; participant = participant->next) {
+        uint64_t pinned = participant->epoch.load(std::memory_order_seq_cst);
+        if (pinned != 0 && pinned != epoch) {
+            return false;
+        }
+    }
+
+    return s_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+}
@@ -0,0 +1,91 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "util/Executors.h"
+
+using namespace GroupMe::Util;
+
+std::mutex Executors::s_mutex;
+
+std::shared_ptr<pplx::scheduler_interface> Executors::s_io;
+
+std::shared_ptr<pplx::scheduler_interface> Executors::s_cpu;
+
+std::shared_ptr<pplx::scheduler_interface> Executors::s_blocking;
+
+std::shared_ptr<pplx::scheduler_interface> Executors::io() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_io == nullptr) {
+        return pplx::get_ambient_scheduler();
+    }
+    return s_io;
+}
+
+std::shared_ptr<pplx::scheduler_interface> Executors::cpu() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    // The default pool is only created the first time it's needed so
+    // that users who supply their own don't pay for the threads
+    if (s_cpu == nullptr) {
+        ThreadPool::Options options;
+        options.name = "groupme-cpu";
+        s_cpu = std::make_shared<ThreadPool>(options);
+    }
+    return s_cpu;
+}
+
+std::shared_ptr<pplx::scheduler_interface> Executors::blocking() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    // Blocking work gets its own small pool so a slow disk can never
+    // take every CPU worker away from parsing
+    if (s_blocking == nullptr) {
+        ThreadPool::Options options;
+        options.threads = 4;
+        options.name = "groupme-blocking";
+        s_blocking = std::make_shared<ThreadPool>(options);
+    }
+    return s_blocking;
+}
+
+pplx::task_options Executors::options(const std::shared_ptr<pplx::scheduler_interface>& scheduler, const pplx::cancellation_token& token) {
+    pplx::task_options options(scheduler);
+    options.set_cancellation_token(token);
+    return options;
+}
+
+void Executors::setIO(const std::shared_ptr<pplx::scheduler_interface>& scheduler) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_io = scheduler;
+}
+
+void Executors::setCPU(const std::shared_ptr<pplx::scheduler_interface>& scheduler) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_cpu = scheduler;
+}
+
+void Executors::setBlocking(const std::shared_ptr<pplx::scheduler_interface>& scheduler) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_blocking = scheduler;
+}
+
+void Executors::configureCPU(const ThreadPool::Options& options) {
+    setCPU(std::make_shared<ThreadPool>(options));
+}
+
+void Executors::configureBlocking(const ThreadPool::Options& options) {
+    setBlocking(std::make_shared<ThreadPool>(options));
+}
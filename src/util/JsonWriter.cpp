@@ -0,0 +1,215 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "util/JsonWriter.h"
+#include "util/Fields.h"
+#include "User.h"
+#include "Message.h"
+#include "Attachment.h"
+#include "ID.h"
+
+using namespace GroupMe::Util;
+
+namespace {
+    // Escapes for the control characters that have a short form
+    char shortEscape(unsigned char character) {
+        switch (character) {
+            case '\b':
+                return 'b';
+            case '\f':
+                return 'f';
+            case '\n':
+                return 'n';
+            case '\r':
+                return 'r';
+            case '\t':
+                return 't';
+            default:
+                return 0;
+        }
+    }
+}
+
+JsonWriter::JsonWriter(std::size_t capacity) :
+    m_comma(false)
+{
+    m_buffer.reserve(capacity);
+}
+
+void JsonWriter::clear() {
+    m_buffer.clear();
+    m_comma = false;
+}
+
+std::string_view JsonWriter::view() const {
+    return m_buffer;
+}
+
+std::size_t JsonWriter::capacity() const {
+    return m_buffer.capacity();
+}
+
+void JsonWriter::beginObject() {
+    separate();
+    m_buffer.push_back('{');
+    m_comma = false;
+}
+
+void JsonWriter::endObject() {
+    m_buffer.push_back('}');
+    m_comma = true;
+}
+
+void JsonWriter::beginArray() {
+    separate();
+    m_buffer.push_back('[');
+    m_comma = false;
+}
+
+void JsonWriter::endArray() {
+    m_buffer.push_back(']');
+    m_comma = true;
+}
+
+void JsonWriter::key(std::string_view key) {
+    separate();
+    writeString(key);
+    m_buffer.push_back(':');
+    m_comma = false;
+}
+
+void JsonWriter::value(std::string_view string) {
+    separate();
+    writeString(string);
+    m_comma = true;
+}
+
+void JsonWriter::value(const char* string) {
+    value(std::string_view(string));
+}
+
+void JsonWriter::value(bool boolean) {
+    separate();
+    m_buffer.append(boolean ? "true" : "false");
+    m_comma = true;
+}
+
+void JsonWriter::value(const GroupMe::ID& id) {
+    separate();
+    if (id.isNumber()) {
+        // Digits never need escaping
+        m_buffer.push_back('"');
+        id.appendTo(m_buffer);
+        m_buffer.push_back('"');
+    }
+    else {
+        writeString(id.toString());
+    }
+    m_comma = true;
+}
+
+void JsonWriter::null() {
+    separate();
+    m_buffer.append("null");
+    m_comma = true;
+}
+
+void JsonWriter::separate() {
+    if (m_comma) {
+        m_buffer.push_back(',');
+    }
+}
+
+void JsonWriter::writeString(std::string_view string) {
+    static constexpr char hex[] = "0123456789abcdef";
+
+    m_buffer.push_back('"');
+
+    // Runs of characters that don't need escaping are copied at once
+    std::size_t run = 0;
+    for (std::size_t i = 0; i < string.size(); i++) {
+        unsigned char character = static_cast<unsigned char>(string[i]);
+        if (character >= 0x20 && character != '"' && character != '\\') {
+            continue;
+        }
+
+        m_buffer.append(string.data() + run, i - run);
+        run = i + 1;
+
+        m_buffer.push_back('\\');
+        if (character == '"' || character == '\\') {
+            m_buffer.push_back(static_cast<char>(character));
+        }
+        else if (char escape = shortEscape(character); escape != 0) {
+            m_buffer.push_back(escape);
+        }
+        else {
+            const char unicode[] = {'u', '0', '0', hex[character >> 4], hex[character & 0xF]};
+            m_buffer.append(unicode, sizeof(unicode));
+        }
+    }
+    m_buffer.append(string.data() + run, string.size() - run);
+
+    m_buffer.push_back('"');
+}
+
+void GroupMe::Util::writeProfile(JsonWriter& writer, const GroupMe::User& user, uint64_t mask) {
+    writer.beginObject();
+    writeFields(GroupMe::User::Schema::profile, user, [&writer](std::string_view key, const auto& value) {
+        writer.field(key, value);
+    }, mask);
+    writer.endObject();
+}
+
+void GroupMe::Util::writeMessage(JsonWriter& writer, const GroupMe::Message& message) {
+    writer.beginObject();
+    writer.key("message");
+
+    writer.beginObject();
+    writeFields(GroupMe::Message::Schema::outbound, message, [&writer](std::string_view key, const auto& value) {
+        writer.field(key, value);
+    });
+    writer.key("attachments");
+    writeAttachments(writer, message.getAttachments());
+    writer.endObject();
+
+    writer.endObject();
+}
+
+void GroupMe::Util::writeAttachments(JsonWriter& writer, const std::vector<GroupMe::Attachment>& attachments) {
+    writer.beginArray();
+    for (const auto& attachment : attachments) {
+        writer.beginObject();
+        switch (attachment.getType()) {
+            case GroupMe::Attachment::Types::Picture:
+                writer.field("type", "image");
+                writer.field("url", attachment.getContent());
+                break;
+            case GroupMe::Attachment::Types::Video:
+                writer.field("type", "video");
+                writer.field("url", attachment.getContent());
+                break;
+            case GroupMe::Attachment::Types::File:
+                writer.field("type", "file");
+                writer.field("file_id", attachment.getContent());
+                break;
+        }
+        writer.endObject();
+    }
+    writer.endArray();
+}
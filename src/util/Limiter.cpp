@@ -0,0 +1,89 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "util/Limiter.h"
+
+using namespace GroupMe::Util;
+
+Limiter::Limiter(std::size_t permits) :
+    m_available(permits > 0 ? permits : 1)
+{
+
+}
+
+std::shared_ptr<Limiter> Limiter::create(std::size_t permits) {
+    return std::shared_ptr<Limiter>(new Limiter(permits));
+}
+
+pplx::task<void> Limiter::acquire(const pplx::cancellation_token& token) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (token.is_canceled()) {
+        return pplx::task_from_exception<void>(pplx::task_canceled());
+    }
+
+    if (m_available > 0) {
+        m_available--;
+        return pplx::task_from_result();
+    }
+
+    m_waiters.push_back({pplx::task_completion_event<void>(), token});
+    return pplx::create_task(m_waiters.back().ready);
+}
+
+void Limiter::release() {
+    std::deque<Waiter> cancelled;
+    pplx::task_completion_event<void> next;
+    bool handedOff = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // The permit goes straight to the first waiter that still wants it
+        while (!m_waiters.empty()) {
+            Waiter waiter = std::move(m_waiters.front());
+            m_waiters.pop_front();
+
+            if (waiter.token.is_canceled()) {
+                cancelled.push_back(std::move(waiter));
+                continue;
+            }
+
+            next = waiter.ready;
+            handedOff = true;
+            break;
+        }
+
+        if (!handedOff) {
+            m_available++;
+        }
+    }
+
+    // Continuations can run inline, so nothing is completed under the lock
+    for (const auto& waiter : cancelled) {
+        waiter.ready.set_exception(pplx::task_canceled());
+    }
+
+    if (handedOff) {
+        next.set();
+    }
+}
+
+std::size_t Limiter::available() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_available;
+}
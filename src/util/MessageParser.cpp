@@ -0,0 +1,372 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "util/MessageParser.h"
+
+using namespace GroupMe::Util;
+
+MessagePageParser::MessagePageParser(Handler handler) :
+    m_handler(std::move(handler)),
+    m_messagesDepth(0),
+    m_depth(0),
+    m_done(false),
+    m_expectMessages(false),
+    m_field(nullptr),
+    m_attachmentField(nullptr),
+    m_nextArray(Array::None),
+    m_array(Array::None)
+{
+
+}
+
+bool MessagePageParser::null() {
+    // A null is the same as the field not being there, which is what `m_pending` already holds
+    consume();
+    return true;
+}
+
+bool MessagePageParser::boolean(bool value) {
+    Scalar scalar;
+    scalar.boolean = value;
+    read(scalar);
+
+    consume();
+    return true;
+}
+
+bool MessagePageParser::number_integer(number_integer_t value) {
+    Scalar scalar;
+    scalar.number = static_cast<uint64_t>(value);
+    read(scalar);
+
+    consume();
+    return true;
+}
+
+bool MessagePageParser::number_unsigned(number_unsigned_t value) {
+    Scalar scalar;
+    scalar.number = value;
+    read(scalar);
+
+    consume();
+    return true;
+}
+
+bool MessagePageParser::number_float(number_float_t value, const string_t& string) {
+    static_cast<void>(value);
+    static_cast<void>(string);
+    consume();
+    return true;
+}
+
+bool MessagePageParser::string(string_t& value) {
+    // The IDs in `favorited_by` are the only strings that don't have a key
+    if (m_field == nullptr && m_attachmentField == nullptr) {
+        if (m_messagesDepth != 0 && m_depth == m_messagesDepth + 2 && m_array == Array::FavoritedBy) {
+            m_pending.favoritedBy.push_back(value);
+        }
+    }
+    else {
+        // The strings in `m_pending` are assigned to rather than moved
+        // into, so they keep their capacity from one message to the next
+        Scalar scalar;
+        scalar.string = value;
+        read(scalar);
+    }
+
+    consume();
+    return true;
+}
+
+bool MessagePageParser::binary(binary_t& value) {
+    static_cast<void>(value);
+    consume();
+    return true;
+}
+
+bool MessagePageParser::start_object(std::size_t elements) {
+    static_cast<void>(elements);
+
+    if (m_messagesDepth != 0) {
+        if (m_depth == m_messagesDepth) {
+            m_pending.clear();
+        }
+        else if (m_depth == m_messagesDepth + 2 && m_array == Array::Attachments) {
+            m_attachment = MessageFields::AttachmentFields();
+        }
+    }
+
+    consume();
+    m_depth++;
+    return true;
+}
+
+bool MessagePageParser::end_object() {
+    m_depth--;
+
+    if (m_messagesDepth != 0) {
+        if (m_depth == m_messagesDepth) {
+            finishMessage();
+        }
+        else if (m_depth == m_messagesDepth + 2 && m_array == Array::Attachments) {
+            finishAttachment();
+        }
+    }
+    return true;
+}
+
+bool MessagePageParser::start_array(std::size_t elements) {
+    static_cast<void>(elements);
+
+    // Either the array under the `messages` key, or the whole document is an array
+    if (m_messagesDepth == 0 && !m_done && (m_expectMessages || m_depth == 0)) {
+        m_depth++;
+        m_messagesDepth = m_depth;
+        consume();
+        return true;
+    }
+
+    if (m_messagesDepth != 0 && m_depth == m_messagesDepth + 1) {
+        m_array = m_nextArray;
+    }
+
+    consume();
+    m_depth++;
+    return true;
+}
+
+bool MessagePageParser::end_array() {
+    m_depth--;
+
+    if (m_messagesDepth != 0) {
+        if (m_depth + 1 == m_messagesDepth) {
+            // Only the first messages array is parsed
+            m_messagesDepth = 0;
+            m_done = true;
+        }
+        else if (m_depth == m_messagesDepth + 1) {
+            m_array = Array::None;
+        }
+    }
+    return true;
+}
+
+bool MessagePageParser::key(string_t& value) {
+    consume();
+
+    if (m_messagesDepth == 0) {
+        m_expectMessages = !m_done && value == "messages";
+        return true;
+    }
+
+    if (m_depth == m_messagesDepth + 1) {
+        for (const auto& field : MessageFields::s_fields) {
+            if (field.key() == value) {
+                m_field = &field;
+                return true;
+            }
+        }
+
+        if (value == "favorited_by") {
+            m_nextArray = Array::FavoritedBy;
+        }
+        else if (value == "attachments") {
+            m_nextArray = Array::Attachments;
+        }
+    }
+    else if (m_depth == m_messagesDepth + 3 && m_array == Array::Attachments) {
+        for (const auto& field : MessageFields::s_attachmentFields) {
+            if (field.key() == value) {
+                m_attachmentField = &field;
+                return true;
+            }
+        }
+    }
+    return true;
+}
+
+void MessagePageParser::read(const Scalar& value) {
+    if (m_field != nullptr) {
+        m_field->read(value, m_pending);
+    }
+    else if (m_attachmentField != nullptr) {
+        m_attachmentField->read(value, m_attachment);
+    }
+}
+
+void MessagePageParser::consume() {
+    m_field = nullptr;
+    m_attachmentField = nullptr;
+    m_nextArray = Array::None;
+    m_expectMessages = false;
+}
+
+void MessagePageParser::finishMessage() {
+    m_handler(m_pending);
+}
+
+void MessagePageParser::finishAttachment() {
+    m_pending.attachments.push_back(std::move(m_attachment));
+}
+
+void MessageFields::clear() {
+    id.clear();
+    createdAt = 0;
+    userID.clear();
+    name.clear();
+    avatarURL.clear();
+    text.clear();
+    favoritedBy.clear();
+    attachments.clear();
+}
+
+constexpr std::array<Field<MessageFields>, 6> MessageFields::s_fields = {{
+    {"id", &MessageFields::id, Field<MessageFields>::Read},
+    {"created_at", &MessageFields::createdAt, Field<MessageFields>::Read},
+    {"user_id", &MessageFields::userID, Field<MessageFields>::Read},
+    {"name", &MessageFields::name, Field<MessageFields>::Read},
+    {"avatar_url", &MessageFields::avatarURL, Field<MessageFields>::Read},
+    {"text", &MessageFields::text, Field<MessageFields>::Read}
+}};
+
+constexpr std::array<Field<MessageFields::AttachmentFields>, 3> MessageFields::s_attachmentFields = {{
+    {"type", &AttachmentFields::type, Field<AttachmentFields>::Read},
+    {"url", &AttachmentFields::url, Field<AttachmentFields>::Read},
+    {"file_id", &AttachmentFields::fileID, Field<AttachmentFields>::Read}
+}};
+
+void MessageFields::read(GroupMe::Util::Json::Value& json) {
+    readFields(s_fields, json, *this, [this](std::string_view key, GroupMe::Util::Json::Value& value) {
+        if (value.isNull()) {
+            return;
+        }
+
+        if (key == "favorited_by") {
+            value.forEachElement([this](GroupMe::Util::Json::Value& user) {
+                favoritedBy.emplace_back(user.getString());
+            });
+        }
+        else if (key == "attachments") {
+            value.forEachElement([this](GroupMe::Util::Json::Value& attachment) {
+                readFields(s_attachmentFields, attachment, attachments.emplace_back());
+            });
+        }
+    });
+}
+
+namespace {
+    // `find` resolves a user ID to a member of the group, or `nullptr`
+    template <typename Find>
+    GroupMe::Message buildMessage(const MessageFields& fields, Find&& find) {
+        GroupMe::Message message;
+
+        message.setID(fields.id);
+        message.setCreatedAt(static_cast<unsigned int>(fields.createdAt));
+
+        std::shared_ptr<GroupMe::User> sender = find(fields.userID);
+
+        if (sender != nullptr) {
+            message.setSender(sender);
+        }
+        else {
+            // Senders that left the group share one user per identity
+            GroupMe::IdentityTable& identities = GroupMe::IdentityTable::global();
+            message.setSender(identities.getUser(identities.intern(fields.userID, fields.name, fields.avatarURL)));
+        }
+
+        message.attach(fields.text);
+
+        for (const auto& userID : fields.favoritedBy) {
+            std::shared_ptr<GroupMe::User> user = find(userID);
+            if (user != nullptr) {
+                message.addFavorited(user);
+            }
+        }
+
+        // Attachments of an unknown type are ignored
+        for (const auto& attachment : fields.attachments) {
+            if (attachment.type == "image") {
+                message.attach(GroupMe::Attachment(web::uri(attachment.url), GroupMe::Attachment::Types::Picture));
+            }
+            else if (attachment.type == "file") {
+                message.attach(GroupMe::Attachment(attachment.fileID, GroupMe::Attachment::Types::File));
+            }
+            else if (attachment.type == "video") {
+                message.attach(GroupMe::Attachment(attachment.url, GroupMe::Attachment::Types::Video));
+            }
+        }
+
+        return message;
+    }
+}
+
+GroupMe::Message MessageFields::build(const GroupMe::UserSet& users) const {
+    return buildMessage(*this, [&users](std::string_view userID) -> std::shared_ptr<GroupMe::User> {
+        GroupMe::UserSet::iterator user = users.find(userID);
+        return user != users.cend() ? *user : nullptr;
+    });
+}
+
+GroupMe::Message MessageFields::build(const GroupMe::MemberDirectory& members) const {
+    // Only the members that are actually referenced get built
+    return buildMessage(*this, [&members](std::string_view userID) {
+        return members.find(userID);
+    });
+}
+
+void GroupMe::Util::parseMessagePage(std::string_view page, const MessagePageParser::Handler& handler) {
+#ifdef GROUPME_SIMDJSON
+    GroupMe::Util::Json::Document document(page);
+
+    MessageFields fields;
+
+    auto readMessages = [&fields, &handler](GroupMe::Util::Json::Value& value) {
+        value.forEachElement([&fields, &handler](GroupMe::Util::Json::Value& message) {
+            fields.clear();
+            fields.read(message);
+            handler(fields);
+        });
+    };
+
+    if (document.isArray()) {
+        document.forEachElement([&fields, &handler](GroupMe::Util::Json::Value& message) {
+            fields.clear();
+            fields.read(message);
+            handler(fields);
+        });
+        return;
+    }
+
+    // `{"response": {"count": ..., "messages": [...]}}`, or just the response
+    document.forEachField([&readMessages](std::string_view key, GroupMe::Util::Json::Value& value) {
+        if (key == "messages") {
+            readMessages(value);
+        }
+        else if (key == "response" && !value.isNull()) {
+            value.forEachField([&readMessages](std::string_view responseKey, GroupMe::Util::Json::Value& responseValue) {
+                if (responseKey == "messages") {
+                    readMessages(responseValue);
+                }
+            });
+        }
+    });
+#else
+    MessagePageParser parser(handler);
+    nlohmann::json::sax_parse(page, &parser);
+#endif
+}
@@ -0,0 +1,187 @@
+/*
+    This is a library used to communicate with the GroupMe API efficiently and seamlessly.
+    Copyright (C) 2022 Timothy Hutchins
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "util/ThreadPool.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace GroupMe::Util;
+
+namespace {
+    // Lets `post` tell whether it's being called from one of the workers
+    // of a pool, and which one
+    thread_local const void* t_pool = nullptr;
+
+    thread_local std::size_t t_index = 0;
+
+    std::size_t threadCount(const ThreadPool::Options& options) {
+        if (options.threads == 0) {
+            return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+        }
+        return options.threads;
+    }
+}
+
+ThreadPool::Shared::Shared(std::size_t threads) :
+    pending(0),
+    next(0)
+{
+    queues.reserve(threads);
+    for (std::size_t i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+}
+
+bool ThreadPool::Shared::take(std::size_t index, std::function<void()>& work) {
+    {
+        Queue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.work.empty()) {
+            work = std::move(own.work.back());
+            own.work.pop_back();
+            pending--;
+            return true;
+        }
+    }
+
+    // Steals the oldest work, which is the least likely to be in anyone's cache
+    for (std::size_t i = 1; i < queues.size(); i++) {
+        Queue& victim = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.work.empty()) {
+            work = std::move(victim.work.front());
+            victim.work.pop_front();
+            pending--;
+            return true;
+        }
+    }
+    return false;
+}
+
+ThreadPool::ThreadPool(const Options& options) :
+    m_options(options),
+    m_shared(std::make_shared<Shared>(threadCount(options)))
+{
+    std::size_t threads = m_shared->queues.size();
+
+    m_threads.reserve(threads);
+    for (std::size_t i = 0; i < threads; i++) {
+        m_threads.emplace_back(&ThreadPool::run, m_shared, m_options, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_shared->mutex);
+        m_shared->stopping = true;
+    }
+    m_shared->cv.notify_all();
+
+    for (auto& thread : m_threads) {
+        // The last reference to a pool can be dropped by a task running on
+        // the pool itself, which can't join its own thread
+        if (thread.get_id() == std::this_thread::get_id()) {
+            thread.detach();
+        }
+        else if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void ThreadPool::schedule(pplx::TaskProc_t proc, void* param) {
+    post([proc, param]() {
+        proc(param);
+    });
+}
+
+void ThreadPool::post(std::function<void()> work) {
+    // The work can destroy the pool as soon as it's queued, so nothing
+    // after that point may touch `this`
+    std::shared_ptr<Shared> shared = m_shared;
+
+    std::size_t index;
+    if (t_pool == shared.get()) {
+        index = t_index;
+    }
+    else {
+        index = shared->next++ % shared->queues.size();
+    }
+
+    {
+        Queue& queue = *shared->queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.work.push_back(std::move(work));
+        shared->pending++;
+    }
+
+    // Taking the lock makes sure a worker that is about to sleep sees the work
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+    }
+    shared->cv.notify_one();
+}
+
+std::size_t ThreadPool::size() const {
+    return m_threads.size();
+}
+
+void ThreadPool::run(const std::shared_ptr<Shared>& shared, const Options& options, std::size_t index) {
+#ifdef __linux__
+    // Names are limited to 15 characters by the kernel
+    std::string name = (options.name + "-" + std::to_string(index)).substr(0, 15);
+    pthread_setname_np(pthread_self(), name.c_str());
+
+    if (!options.affinity.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (unsigned int cpu : options.affinity) {
+            CPU_SET(cpu, &set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+    }
+#else
+    static_cast<void>(index);
+#endif
+
+    t_pool = shared.get();
+    t_index = index;
+
+    while (true) {
+        std::function<void()> work;
+
+        if (!shared->take(index, work)) {
+            std::unique_lock<std::mutex> lock(shared->mutex);
+            shared->cv.wait(lock, [&shared]() {
+                return shared->stopping || shared->pending > 0;
+            });
+
+            // Drains the queues before stopping so that no task is left
+            // without ever being run
+            if (shared->pending == 0) {
+                return;
+            }
+            continue;
+        }
+
+        work();
+    }
+}
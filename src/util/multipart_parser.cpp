@@ -77,6 +77,15 @@ namespace web::http {
             m_files.push_back(std::move(std::pair<std::filesystem::path, std::string>(file, file.filename())));
     }
 
+    // Drops the files and the body but keeps the boundary, since the
+    // request headers already use it
+    void MultipartParser::clear() {
+            m_params = std::vector<std::pair<std::string, std::string>>();
+            m_files = std::vector<std::pair<std::filesystem::path, std::string>>();
+            m_filesRaw = std::vector<std::pair<std::vector<uint8_t>, std::string>>();
+            m_bodyContent = std::string();
+    }
+
     const std::string &MultipartParser::generateBody() {
         std::vector<std::future<std::string> > futures;
         m_bodyContent.clear();
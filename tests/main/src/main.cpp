@@ -19,12 +19,591 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <set>
+#include <filesystem>
+#include <stdexcept>
 
 #include "Video.h"
+#include "ContactRegistry.h"
+#include "Timeline.h"
+#include "MessageLog.h"
+#include "UserSet.hpp"
+#include "ID.h"
+
+#include "util/Epoch.h"
+#include "util/Limiter.h"
+#include "util/JsonWriter.h"
+#include "util/MessageParser.h"
 
 #include "util/AVFileMem.h"
 
+namespace {
+    // Every check that fails is printed, and makes the test exit with a failure
+    int s_failures = 0;
+
+    void check(bool condition, const char* what) {
+        if (!condition) {
+            std::cerr << "FAILED: " << what << std::endl;
+            s_failures++;
+        }
+    }
+
+    // Stands in for an attachment whose upload finishes after it was
+    // copied into a message
+    class PendingUpload : public GroupMe::Attachment {
+        public:
+            explicit PendingUpload(GroupMe::Attachment::Types type) :
+                GroupMe::Attachment(std::string(), type)
+            {
+
+            }
+
+            void finish(const std::string& content) {
+                m_content->set(content);
+            }
+    };
+
+    GroupMe::User makeUser(const std::string& id, int version) {
+        // The nickname and email always carry the same version, so a reader
+        // can tell if it saw a user that was changed while it was reading
+        return GroupMe::User(id, "name" + std::to_string(version), "", "", "email" + std::to_string(version), "");
+    }
+
+    void testContactRegistry() {
+        GroupMe::ContactRegistry registry;
+
+        auto original = std::make_shared<GroupMe::User>(makeUser("1", 0));
+        check(registry.insert(original), "a new contact is inserted");
+        check(!registry.insert(original), "a contact with the same ID isn't inserted twice");
+
+        // The registry keeps its own copy
+        original->setNickname("changed");
+        check(registry.find("1")->getNickname() == "name0", "changing the inserted user doesn't change the contact");
+
+        std::shared_ptr<const GroupMe::User> before = registry.find("1");
+        registry.assign(makeUser("1", 1));
+        check(before->getNickname() == "name0", "a contact that was found isn't changed by assign");
+        check(registry.find("1")->getNickname() == "name1", "assign replaces the contact");
+
+        GroupMe::UserSet set = {std::make_shared<GroupMe::User>(makeUser("1", 5)), std::make_shared<GroupMe::User>(makeUser("2", 0))};
+        registry.merge(set);
+        check(set.size() == 1 && set.contains("1"), "merge leaves contacts that already exist in the set");
+        check(registry.size() == 2, "merge adds the new contacts");
+
+        std::atomic<bool> done(false);
+        std::atomic<bool> torn(false);
+
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; i++) {
+            readers.emplace_back([&registry, &done, &torn]() {
+                while (!done.load(std::memory_order_acquire)) {
+                    std::shared_ptr<const GroupMe::User> contact = registry.find("1");
+                    if (contact == nullptr) {
+                        torn = true;
+                        continue;
+                    }
+
+                    std::string nickname = contact->getNickname();
+                    std::string email = contact->getEmail();
+                    if (nickname.substr(4) != email.substr(5)) {
+                        torn = true;
+                    }
+                }
+            });
+        }
+
+        for (int version = 2; version < 2000; version++) {
+            if (version % 2 == 0) {
+                registry.assign(makeUser("1", version));
+            }
+            else {
+                registry.update([version](GroupMe::UserSet& contacts) {
+                    contacts.erase("1");
+                    contacts.insert(std::make_shared<GroupMe::User>(makeUser("1", version)));
+                });
+            }
+        }
+
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        check(!torn, "readers never see a contact that is missing or half changed");
+        check(registry.find("1")->getNickname() == "name1999", "the last write wins");
+    }
+
+    // Parses a page with the SAX handler, whatever JSON backend is built
+    std::vector<GroupMe::Util::MessageFields> parsePage(const std::string& page) {
+        std::vector<GroupMe::Util::MessageFields> messages;
+        GroupMe::Util::MessagePageParser parser([&messages](GroupMe::Util::MessageFields& message) {
+            messages.push_back(message);
+        });
+        nlohmann::json::sax_parse(page, &parser);
+        return messages;
+    }
+
+    bool sameMessage(const GroupMe::Message& a, const GroupMe::Message& b) {
+        bool same = a.getID() == b.getID() && a.getCreatedAt() == b.getCreatedAt() && a.getText() == b.getText();
+        same = same && a.getSender()->getID() == b.getSender()->getID() && a.getSender()->getNickname() == b.getSender()->getNickname();
+
+        same = same && a.getFavorited().size() == b.getFavorited().size();
+        for (std::size_t i = 0; same && i < a.getFavorited().size(); i++) {
+            same = a.getFavorited()[i]->getID() == b.getFavorited()[i]->getID();
+        }
+
+        same = same && a.getAttachments().size() == b.getAttachments().size();
+        for (std::size_t i = 0; same && i < a.getAttachments().size(); i++) {
+            same = a.getAttachments()[i].getType() == b.getAttachments()[i].getType() && a.getAttachments()[i].getContent() == b.getAttachments()[i].getContent();
+        }
+        return same;
+    }
+
+    void testMessagePageParser() {
+        GroupMe::UserSet users = {
+            std::make_shared<GroupMe::User>("1", "alice", "", "", "", ""),
+            std::make_shared<GroupMe::User>("2", "bob", "", "", "", "")
+        };
+
+        // The event of the first message has its own "id", and the meta
+        // object has a second "messages" array, neither of which are part
+        // of the page
+        std::string page = R"({"response":{"count":3,"messages":[
+            {"attachments":[{"type":"image","url":"https://i.groupme.com/a.png"},{"type":"mentions","loci":[[0,5],[6,3]],"user_ids":["1","2"]}],
+             "avatar_url":"https://i.groupme.com/bob","created_at":1700000000,"favorited_by":["1","9"],"group_id":"5","id":"100",
+             "name":"bob","sender_id":"2","system":false,"text":null,"user_id":"2","event":{"type":"x","data":{"id":"zzz","nested":[{"messages":[]}]}}},
+            {"id":"101","created_at":1700000001,"user_id":"1","name":"alice","avatar_url":"","text":"hi","favorited_by":[],"attachments":null},
+            {"id":"102","created_at":1700000002,"user_id":"7","name":"carol","avatar_url":"https://i.groupme.com/carol","text":"left","favorited_by":["2"],
+             "attachments":[{"type":"file","file_id":"f1"},{"type":"video","url":"https://v.groupme.com/v.mp4","preview_url":"https://v.groupme.com/p.jpg"}]}
+        ]},"meta":{"code":200,"messages":[{"id":"999","created_at":1,"user_id":"1","name":"","avatar_url":"","text":"no","favorited_by":[],"attachments":[]}]}})";
+
+        std::vector<GroupMe::Util::MessageFields> parsed = parsePage(page);
+        nlohmann::json dom = nlohmann::json::parse(page)["response"]["messages"];
+
+        check(parsed.size() == 3, "only the first messages array is parsed");
+
+        bool same = parsed.size() == dom.size();
+        for (std::size_t i = 0; same && i < parsed.size(); i++) {
+            same = sameMessage(parsed[i].build(users), GroupMe::Message::createFromJson(dom[i], users));
+        }
+        check(same, "the SAX handler builds the same messages as the DOM");
+
+        if (parsed.size() == 3) {
+            check(parsed[0].id == "100" && parsed[0].text.empty(), "nested objects don't overwrite the fields of a message, and a null text is empty");
+            check(parsed[0].favoritedBy == std::vector<std::string>({"1", "9"}), "favorited_by is read in order");
+            check(parsed[0].attachments.size() == 2 && parsed[0].attachments[1].type == "mentions", "attachments with nested arrays are read");
+            check(parsed[1].attachments.empty(), "null attachments are empty");
+            check(parsed[2].attachments.size() == 2 && parsed[2].attachments[0].fileID == "f1" && parsed[2].attachments[1].url == "https://v.groupme.com/v.mp4", "every field of an attachment is read");
+        }
+
+        std::vector<GroupMe::Util::MessageFields> bare = parsePage(R"([{"id":"7","created_at":3,"user_id":"1","name":null,"avatar_url":null,"text":"x","favorited_by":null,"attachments":[]}])");
+        check(bare.size() == 1 && bare[0].id == "7" && bare[0].createdAt == 3 && bare[0].text == "x", "a bare array of messages is parsed");
+        check(bare.size() == 1 && bare[0].name.empty() && bare[0].avatarURL.empty() && bare[0].favoritedBy.empty(), "null fields are left empty");
+
+        check(parsePage(R"({"response":{"count":0,"messages":[]}})").empty(), "an empty page has no messages");
+    }
+
+    void testMessageWriter() {
+        GroupMe::Message message(std::string("hello \"there\""), std::string("guid"));
+
+        PendingUpload picture(GroupMe::Attachment::Types::Picture);
+        PendingUpload file(GroupMe::Attachment::Types::File);
+        message.attach(picture);
+        message.attach(file);
+
+        // The uploads finish after the message copied the attachments
+        picture.finish("https://i.groupme.com/picture");
+        file.finish("file-id");
+
+        GroupMe::Util::JsonWriter writer;
+        GroupMe::Util::writeMessage(writer, message);
+
+        nlohmann::json body = nlohmann::json::parse(writer.view());
+        const nlohmann::json& attachments = body["message"]["attachments"];
+
+        check(body["message"]["text"] == "hello \"there\"" && body["message"]["source_guid"] == "guid", "the text and GUID of the message are written");
+        check(attachments.size() == 2, "every attachment is written");
+        check(attachments[0]["type"] == "image" && attachments[0]["url"] == "https://i.groupme.com/picture", "a picture is written with the URL it was uploaded to");
+        check(attachments[1]["type"] == "file" && attachments[1]["file_id"] == "file-id", "a file is written with the ID it was uploaded as");
+    }
+
+    void testIDOrdering() {
+        check(GroupMe::ID() < GroupMe::ID("0"), "the empty ID comes first");
+        check(GroupMe::ID("9") < GroupMe::ID("10"), "numeric IDs order by value");
+        check(GroupMe::ID("18446744073709551615") > GroupMe::ID("18446744073709551614"), "the largest number orders by value");
+        check(GroupMe::ID("99999") < GroupMe::ID("abc"), "numeric IDs come before text IDs");
+        check(!GroupMe::ID("007").isNumber() && GroupMe::ID("007").toString() == "007", "an ID with a leading zero is kept as text");
+        check(GroupMe::ID("007") > GroupMe::ID("7"), "a text ID comes after the number it looks like");
+        check(GroupMe::ID("abc") < GroupMe::ID("abd") && GroupMe::ID("ab") < GroupMe::ID("abc"), "text IDs order like strings");
+
+        std::string longText(40, 'z');
+        check(GroupMe::ID(longText).toString() == longText && GroupMe::ID("zz") < GroupMe::ID(longText), "long text IDs round trip and order like strings");
+        check(GroupMe::ID("123") == GroupMe::ID::fromNumber(123), "a parsed number equals the same number");
+    }
+
+    void testUserSetErase() {
+        GroupMe::UserSet users;
+        std::set<int> expected;
+
+        // Enough users that probes run into each other, so erasing has to
+        // shift the ones after the hole back for them to still be found
+        for (int i = 0; i < 4000; i++) {
+            users.insert(std::make_shared<GroupMe::User>(std::to_string(i), "", "", "", "", ""));
+            expected.insert(i);
+        }
+
+        for (int i = 0; i < 4000; i += 3) {
+            users.erase(std::to_string(i));
+            expected.erase(i);
+        }
+
+        // Erasing through an iterator moves the last user into its place
+        bool moved = true;
+        while (users.size() > 1000) {
+            std::string last = users.cbegin()[users.size() - 1]->getID();
+            expected.erase(std::stoi((*users.begin())->getID()));
+
+            GroupMe::UserSet::iterator next = users.erase(users.begin());
+            if ((*next)->getID() != last) {
+                moved = false;
+            }
+        }
+        check(moved, "erasing a user moves the last user into its place");
+
+        bool found = true;
+        for (int i = 0; i < 4000; i++) {
+            if (users.contains(std::to_string(i)) != (expected.count(i) != 0)) {
+                found = false;
+            }
+        }
+        check(found, "every user that's left is found, and no erased user is");
+        check(users.size() == expected.size(), "the size counts the users that are left");
+
+        for (int i = 0; i < 4000; i++) {
+            users.insert(std::make_shared<GroupMe::User>(std::to_string(i), "", "", "", "", ""));
+        }
+        check(users.size() == 4000, "erased users can be inserted again");
+    }
+
+    void testEpoch() {
+        std::atomic<bool> reclaimed(false);
+
+        {
+            GroupMe::Util::Epoch::Guard guard = GroupMe::Util::Epoch::pin();
+
+            GroupMe::Util::Epoch::retire([&reclaimed]() {
+                reclaimed = true;
+            });
+
+            for (int i = 0; i < 4; i++) {
+                GroupMe::Util::Epoch::collect();
+            }
+            check(!reclaimed, "nothing is reclaimed while a reader that was pinned before it was retired is still pinned");
+        }
+
+        for (int i = 0; i < 4; i++) {
+            GroupMe::Util::Epoch::collect();
+        }
+        check(reclaimed, "it's reclaimed once the reader leaves");
+    }
+
+    void testTimeline() {
+        GroupMe::Timeline timeline(1000);
+
+        std::atomic<bool> done(false);
+        std::atomic<bool> broken(false);
+
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; i++) {
+            readers.emplace_back([&timeline, &done, &broken]() {
+                while (!done.load(std::memory_order_acquire)) {
+                    GroupMe::Timeline::View view = timeline.recent(300);
+
+                    // Every message is created at its own position, so a reader
+                    // that sees a gap or a half built message would notice
+                    bool first = true;
+                    uint64_t previous = 0;
+                    for (auto message = view.begin(); message != view.end(); ++message) {
+                        uint64_t createdAt = message->getCreatedAt();
+                        if (createdAt != message.index() || (!first && createdAt != previous + 1) || message->getText() != "m") {
+                            broken = true;
+                        }
+                        previous = createdAt;
+                        first = false;
+                    }
+                }
+            });
+        }
+
+        bool ordered = true;
+        for (unsigned int i = 0; i < 50000;) {
+            if (i % 7 == 0) {
+                std::vector<GroupMe::Message> batch;
+                for (unsigned int k = 0; k < 5; k++) {
+                    GroupMe::Message message(std::string("m"), std::string());
+                    message.setCreatedAt(i + k);
+                    batch.push_back(std::move(message));
+                }
+                ordered = ordered && timeline.append(std::move(batch)) == i;
+                i += 5;
+            }
+            else {
+                GroupMe::Message message(std::string("m"), std::string());
+                message.setCreatedAt(i);
+                ordered = ordered && timeline.append(std::move(message)) == i;
+                i++;
+            }
+        }
+
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        check(ordered, "append gives back the position of the message");
+        check(!broken, "readers only ever see whole messages without gaps");
+        check(timeline.size() == 50000, "the size counts every message that was appended");
+
+        std::size_t kept = timeline.view().size();
+        check(kept >= 1000 && kept <= 1000 + 2 * GroupMe::Timeline::s_segmentSize, "old segments are trimmed down to the retention");
+        check(timeline.recent(10).size() == 10 && timeline.recent(10).begin()->getCreatedAt() == 49990, "recent views end at the newest message");
+    }
+
+    // Gets the segments of a message log, oldest first
+    std::vector<std::filesystem::path> segmentsOf(const std::filesystem::path& directory) {
+        std::vector<std::filesystem::path> segments;
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            if (entry.path().extension() == ".log") {
+                segments.push_back(entry.path());
+            }
+        }
+        std::sort(segments.begin(), segments.end());
+        return segments;
+    }
+
+    void testMessageLogRecovery() {
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "groupme-test-message-log";
+        std::filesystem::remove_all(directory);
+
+        auto sender = std::make_shared<GroupMe::User>("42", "Sender", "", "", "", "");
+
+        auto message = [&sender](unsigned int number) {
+            GroupMe::Message message(sender, "text " + std::to_string(number), std::string());
+            message.setID(std::to_string(170000000000000000ull + number));
+            message.setCreatedAt(1000 + number);
+            return message;
+        };
+
+        {
+            GroupMe::MessageLog log(directory);
+            for (unsigned int i = 0; i < 99; i++) {
+                log.append(message(i));
+            }
+
+            GroupMe::Message uploaded = message(99);
+            PendingUpload picture(GroupMe::Attachment::Types::Picture);
+            uploaded.attach(picture);
+            picture.finish("https://i.groupme.com/picture");
+            log.append(uploaded);
+
+            auto record = log.find(GroupMe::ID("170000000000000099"));
+            check(record->getAttachments().size() == 1 && record->getAttachments()[0].url == "https://i.groupme.com/picture", "an attachment is written with the content it was uploaded to");
+        }
+
+        // Cuts the last record in half, like a crash in the middle of a write.
+        // The ID index says it covers more than is left, so it's rebuilt.
+        std::filesystem::path last = segmentsOf(directory).back();
+        std::filesystem::resize_file(last, std::filesystem::file_size(last) - 2);
+
+        {
+            GroupMe::MessageLog log(directory);
+            check(log.size() == 99, "the torn record is dropped when the log is opened");
+            check(!log.contains(GroupMe::ID("170000000000000099")), "the torn record can't be found");
+            check(log.find(GroupMe::ID("170000000000000098"))->getText() == "text 98", "the records before it are kept");
+
+            check(log.append(message(99)), "the torn record can be written again");
+        }
+
+        {
+            GroupMe::MessageLog log(directory);
+            check(log.size() == 100 && log.find(GroupMe::ID("170000000000000099"))->getText() == "text 99", "records written after the recovery are kept");
+        }
+
+        std::filesystem::remove_all(directory);
+    }
+
+    void testMessageLogStaleIndex() {
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "groupme-test-message-log-index";
+        std::filesystem::remove_all(directory);
+
+        auto sender = std::make_shared<GroupMe::User>("42", "Sender", "", "", "", "");
+
+        GroupMe::MessageLog::Options options;
+        options.segmentSize = 1024 * 1024;
+
+        // Big enough that the messages fill a few segments
+        auto text = [](unsigned int number) {
+            return std::string(20000, 'x') + std::to_string(number);
+        };
+
+        {
+            GroupMe::MessageLog log(directory, options);
+            for (unsigned int i = 0; i < 200; i++) {
+                GroupMe::Message message(sender, text(i), std::string());
+                message.setID(std::to_string(170000000000000000ull + i));
+                message.setCreatedAt(1000 + i);
+                log.append(message);
+            }
+        }
+
+        // Cuts the end off of the first segment, like a crash after the log
+        // moved on to the next segment but before the first one reached the
+        // disk. The ID index still covers the newest segment, so it's kept,
+        // and its slot for the cut record points past the end of the data.
+        std::vector<std::filesystem::path> segments = segmentsOf(directory);
+        check(segments.size() > 2, "the messages are spread over several segments");
+        std::filesystem::resize_file(segments.front(), std::filesystem::file_size(segments.front()) - 2);
+
+        GroupMe::MessageLog log(directory, options);
+
+        std::size_t missing = 0;
+        bool found = true;
+        for (unsigned int i = 0; i < 200; i++) {
+            GroupMe::ID id(std::to_string(170000000000000000ull + i));
+            if (!log.contains(id)) {
+                missing++;
+                found = found && !log.find(id).has_value();
+                continue;
+            }
+            found = found && log.find(id)->getText() == text(i);
+        }
+        check(missing == 1, "only the record that was cut off is missing");
+        check(found, "the other records are found by their IDs, and the cut off one isn't");
+
+        std::filesystem::remove_all(directory);
+    }
+
+    // Waits for a task and tells if it ended by being cancelled
+    template <typename T>
+    bool isCancelled(const pplx::task<T>& task) {
+        try {
+            task.get();
+        }
+        catch (const pplx::task_canceled&) {
+            return true;
+        }
+        catch (...) {
+
+        }
+        return false;
+    }
+
+    void testLimiter() {
+        std::shared_ptr<GroupMe::Util::Limiter> limiter = GroupMe::Util::Limiter::create(1);
+
+        pplx::task<void> held = limiter->acquire();
+        check(held.is_done() && limiter->available() == 0, "a free permit is acquired right away");
+
+        std::vector<pplx::task<void>> waiters;
+        for (int i = 0; i < 3; i++) {
+            waiters.push_back(limiter->acquire());
+        }
+        check(!waiters[0].is_done(), "a waiter waits while the permit is held");
+
+        // Each release hands the permit to the oldest waiter, without it
+        // ever becoming available to someone else
+        bool ordered = true;
+        for (std::size_t i = 0; i < waiters.size(); i++) {
+            limiter->release();
+            ordered = ordered && waiters[i].is_done() && limiter->available() == 0;
+            ordered = ordered && (i + 1 == waiters.size() || !waiters[i + 1].is_done());
+        }
+        check(ordered, "waiters get the permit in the order they asked");
+
+        limiter->release();
+        check(limiter->available() == 1, "the permit is available once nobody waits");
+
+        pplx::cancellation_token_source source;
+        source.cancel();
+        check(isCancelled(limiter->acquire(source.get_token())) && limiter->available() == 1, "a cancelled token doesn't take a permit");
+
+        held = limiter->acquire();
+        pplx::cancellation_token_source waiting;
+        pplx::task<void> cancelled = limiter->acquire(waiting.get_token());
+        pplx::task<void> next = limiter->acquire();
+        waiting.cancel();
+
+        limiter->release();
+        check(isCancelled(cancelled), "a waiter whose token is cancelled is cancelled on the next release");
+        check(next.is_done() && !isCancelled(next) && limiter->available() == 0, "a cancelled waiter is skipped over");
+        limiter->release();
+
+        pplx::task<int> thrown = limiter->run([]() -> pplx::task<int> {
+            throw std::runtime_error("start");
+        });
+        bool threw = false;
+        try {
+            thrown.get();
+        }
+        catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw && limiter->available() == 1, "the permit is released when start throws");
+        // Everything after this would wait forever for a lost permit
+        if (limiter->available() != 1) {
+            return;
+        }
+
+        pplx::task<int> failed = limiter->run([]() {
+            return pplx::task_from_exception<int>(std::runtime_error("task"));
+        });
+        threw = false;
+        try {
+            failed.get();
+        }
+        catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw && limiter->available() == 1, "the permit is released when the task fails");
+        // Everything after this would wait forever for a lost permit
+        if (limiter->available() != 1) {
+            return;
+        }
+
+        // The second run waits for the first task, not only for it to start
+        pplx::task_completion_event<int> gate;
+        pplx::task<int> first = limiter->run([gate]() {
+            return pplx::create_task(gate);
+        });
+        pplx::task<int> second = limiter->run([]() {
+            return pplx::task_from_result(2);
+        });
+        check(!second.is_done(), "run waits for the permit");
+
+        gate.set(1);
+        check(first.get() == 1 && second.get() == 2 && limiter->available() == 1, "run gives back the result and the permit");
+    }
+}
+
 int main(int argc, char** argv) {
+    testContactRegistry();
+    testMessagePageParser();
+    testMessageWriter();
+    testIDOrdering();
+    testUserSetErase();
+    testEpoch();
+    testTimeline();
+    testMessageLogRecovery();
+    testMessageLogStaleIndex();
+    testLimiter();
 
+    if (s_failures != 0) {
+        return EXIT_FAILURE;
+    }
     return EXIT_SUCCESS;
 }